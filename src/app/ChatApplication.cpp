@@ -2,6 +2,7 @@
 
 #include <unordered_set>
 
+#include "ChainSync.hpp"
 #include "GlobalState.hpp"
 #include "TextMessage.hpp"
 #include "timestamp.hpp"
@@ -10,12 +11,12 @@
 namespace app
 {
 constexpr const u_int PEERS_BATCH_SIZE = 12;
-constexpr const u_int BLOCKS_BATCH_SIZE = 4;
 constexpr const char* DB_PATH = "d-chat.db";
 
 void ChatApplication::handlePeersCommand()
 {
-    std::vector<peer::UserPeer> peers = peerService->getPeers();
+    std::shared_ptr<const peer::PeerTable> table = peerService->getPeerTable();
+    const std::vector<peer::UserPeer>& peers = table->peers;
 
     if (peers.empty())
     {
@@ -91,7 +92,8 @@ void ChatApplication::handleSendCommand(const std::string& args)
                 return;
             }
 
-            std::vector<peer::UserPeer> peers = peerService->getPeers();
+            std::shared_ptr<const peer::PeerTable> table = peerService->getPeerTable();
+            const std::vector<peer::UserPeer>& peers = table->peers;
             if (peers.empty())
             {
                 consoleUI->printLog("[INFO] No online peers to send message to\n");
@@ -260,7 +262,8 @@ void ChatApplication::handleHelpCommand()
         "  /peers                  - Show list of online peers\n"
         "  /chats                  - Show all your chat conversations\n"
         "  /chat <host:port>       - View chat history with specific peer\n"
-        "  /send <host:port> <message> - Send a message to a specific peer\n\n"
+        "  /send <host:port> <message> - Send a message to a specific peer\n"
+        "  /validate               - Check the whole local chain again\n\n"
         "Examples:\n"
         "  /chat 127.0.0.1:8001\n"
         "  /send 127.0.0.1:8001 Hello, how are you?\n";
@@ -323,7 +326,11 @@ void ChatApplication::init()
     chatService = std::make_shared<chat::ChatService>(
         config, crypto, peerService, blockchainService, messageService, consoleUI);
 
-    server = std::make_shared<network::TCPServer>(port, chatService, blockchainService, consoleUI);
+    size_t workerCount = std::stoul(config->get(config::ConfigField::SERVER_WORKERS));
+    if (workerCount == 0) workerCount = std::max(1u, std::thread::hardware_concurrency());
+
+    server = std::make_shared<network::TCPServer>(
+        port, chatService, blockchainService, consoleUI, workerCount);
     client = std::make_shared<network::TCPClient>(config,
                                                   crypto,
                                                   chatService,
@@ -331,7 +338,7 @@ void ChatApplication::init()
                                                   blockchainService,
                                                   messageService,
                                                   consoleUI,
-                                                  tip.hash);
+                                                  blockchain::hashToHex(tip.hash));
 
     consoleUI->setShutdownCallback([this]() { this->shutdown(); });
 
@@ -356,29 +363,32 @@ void ChatApplication::init()
             start += PEERS_BATCH_SIZE;
         }
 
-        u_int blocksToReceive = globalState.getMissingBlocksCount();
-        start = 0;
-        while (start < blocksToReceive)
+        auto fetchRange = [this, &tip](const peer::UserPeer& to,
+                                       u_int start,
+                                       u_int count,
+                                       const blockchain::BlockSink& sink) -> bool
         {
-            message::BlockRangeMessage message =
-                message::BlockRangeMessage::create(from, to, start, BLOCKS_BATCH_SIZE, tip.hash);
+            message::BlockRangeMessage message = message::BlockRangeMessage::create(
+                from, to, start, count, blockchain::hashToHex(tip.hash));
 
-            client->sendMessage(message);
-            start += BLOCKS_BATCH_SIZE;
-        }
-    }
+            std::string response;
+            if (!client->requestMessage(message, response)) return false;
 
-    if (blockchainService->validateNewBlocks())
-    {
-        std::vector<blockchain::Block> blocks = blockchainService->getNewBlocks();
-        for (const auto& block : blocks)
-        {
-            chainRepo->insertBlock(block);
-        }
-    }
-    else
-    {
-        consoleUI->printLog("[ERROR] Can not add new invalid blocks\n");
+            // the peer answers in the format it was asked in, blocks reach the sink as they are
+            // decoded instead of after the whole message is built
+            message::MessageType type = message::MessageType::NONE;
+            bool complete = message::BlockRangeMessageResponse::decodeBlocks(response, sink, type);
+            if (type != message::MessageType::BLOCK_RANGE_RESPONSE)
+            {
+                chatService->handleOutgoingMessage(response);
+                return false;
+            }
+
+            return complete;
+        };
+
+        blockchain::ChainSync chainSync(blockchainService, consoleUI);
+        chainSync.run(peerService->getPeers(), globalState.getMissingBlocksCount(), fetchRange);
     }
 
     client->connectToAllPeers();
@@ -415,6 +425,8 @@ void ChatApplication::run()
                 handleSendCommand(input.substr(5));
             else if (input.substr(0, 5) == "/help")
                 handleHelpCommand();
+            else if (input == "/validate")
+                blockchainService->validateLocalChain(true);
             else if (!input.empty())
                 consoleUI->printLog("[YOU] " + input + "\n");
         });
@@ -1,70 +1,144 @@
 #include "Block.hpp"
 
-#include <openssl/sha.h>
-
-#include <sstream>
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
 
+#include "base64.hpp"
+#include "hex.hpp"
 #include "sha256.hpp"
 
 namespace blockchain
 {
-Block::Block()
+std::string hashToHex(const Hash& hash)
+{
+    if (hash == Hash{}) return "0";
+
+    std::string hex(hash.size() * 2, '\0');
+    utils::toHex(hash.data(), hash.size(), hex.data());
+    return hex;
+}
+
+bool hashFromHex(std::string_view hex, Hash& hash)
 {
-    hash = "0";
-    previousHash = "0";
-    payloadHash = "0";
-    authorPublicKey = "0";
-    signature = "0";
-    timestamp = 0;
+    if (hex == "0")
+    {
+        hash = Hash{};
+        return true;
+    }
+    return hex.size() == hash.size() * 2 && utils::fromHex(hex, hash.data());
 }
 
-Block::Block(std::string hash,
-             std::string previousHash,
-             std::string payloadHash,
-             std::string authorPublicKey,
-             std::string signature,
+Block::Block() {}
+
+Block::Block(const Hash& hash,
+             const Hash& previousHash,
+             const Hash& payloadHash,
+             std::vector<uint8_t> authorPublicKey,
+             std::vector<uint8_t> signature,
              uint64_t timestamp)
     : hash(hash),
       previousHash(previousHash),
       payloadHash(payloadHash),
-      authorPublicKey(authorPublicKey),
-      signature(signature),
+      authorPublicKey(std::move(authorPublicKey)),
+      signature(std::move(signature)),
       timestamp(timestamp)
 {
 }
 
 Block::Block(const json& jData)
 {
-    hash = jData["hash"].get<std::string>();
-    previousHash = jData["previousHash"].get<std::string>();
-    payloadHash = jData["payloadHash"].get<std::string>();
-    authorPublicKey = jData["authorPubKey"].get<std::string>();
-    signature = jData["signature"].get<std::string>();
-    timestamp = jData["timestamp"].get<uint64_t>();
+    // the text fields are decoded in place, without copying them out of the document
+    auto text = [&jData](const char* key) -> const std::string&
+    { return jData.at(key).get_ref<const std::string&>(); };
+
+    if (!hashFromHex(text("hash"), hash) || !hashFromHex(text("previousHash"), previousHash) ||
+        !hashFromHex(text("payloadHash"), payloadHash))
+        throw std::runtime_error("Invalid block hash");
+
+    if (!utils::fromBase64(text("authorPubKey"), authorPublicKey) ||
+        !utils::fromBase64(text("signature"), signature))
+        throw std::runtime_error("Invalid block key or signature");
+
+    timestamp = jData.at("timestamp").get<uint64_t>();
 }
 
+namespace
+{
+// feeds the text the block hash and signature are computed over to sink piece by piece:
+// previous hash and payload hash in hex, author key in base64 and the timestamp,
+// separated by '|'; it predates the binary fields, so hashes of stored blocks stay valid
+template <typename Sink>
+void writeCanonical(const Block& block, Sink&& sink)
+{
+    auto writeHash = [&sink](const Hash& hash)
+    {
+        if (hash == Hash{})
+        {
+            sink("0");
+            return;
+        }
+
+        char hex[64];
+        utils::toHex(hash.data(), hash.size(), hex);
+        sink(std::string_view(hex, sizeof(hex)));
+    };
+
+    writeHash(block.previousHash);
+    sink("|");
+    writeHash(block.payloadHash);
+    sink("|");
+
+    // whole 3-byte groups per chunk, so only the last chunk can carry padding
+    const std::vector<uint8_t>& key = block.authorPublicKey;
+    constexpr size_t KEY_CHUNK = 48;
+    for (size_t offset = 0; offset < key.size(); offset += KEY_CHUNK)
+    {
+        size_t size = std::min(KEY_CHUNK, key.size() - offset);
+        char base64[KEY_CHUNK / 3 * 4];
+        utils::toBase64(key.data() + offset, size, base64);
+        sink(std::string_view(base64, (size + 2) / 3 * 4));
+    }
+    sink("|");
+
+    char timestamp[20];
+    auto result = std::to_chars(timestamp, timestamp + sizeof(timestamp), block.timestamp);
+    sink(std::string_view(timestamp, result.ptr - timestamp));
+}
+}  // namespace
+
 std::string Block::toStringForHash() const
 {
-    std::ostringstream oss;
-    oss << previousHash << "|" << payloadHash << "|" << authorPublicKey << "|" << timestamp;
-    return oss.str();
+    std::string text;
+    text.reserve(64 * 2 + (authorPublicKey.size() + 2) / 3 * 4 + 24);
+    writeCanonical(*this, [&text](std::string_view piece) { text.append(piece); });
+    return text;
 }
 
-void Block::computeHash()
+Hash Block::calculateHash() const
 {
-    std::string body = toStringForHash();
-    hash = utils::sha256(body);
+    utils::Sha256Hasher hasher;
+    writeCanonical(*this, [&hasher](std::string_view piece) { hasher.update(piece); });
+    return hasher.finish();
 }
 
+void Block::computeHash() { hash = calculateHash(); }
+
+std::string Block::hashHex() const { return hashToHex(hash); }
+
+std::string Block::authorPublicKeyBase64() const { return utils::toBase64(authorPublicKey); }
+
+std::string Block::signatureBase64() const { return utils::toBase64(signature); }
+
 json Block::toJson() const
 {
     json jData;
-    jData["previousHash"] = previousHash;
-    jData["payloadHash"] = payloadHash;
-    jData["authorPubKey"] = authorPublicKey;
-    jData["signature"] = signature;
+    jData["previousHash"] = hashToHex(previousHash);
+    jData["payloadHash"] = hashToHex(payloadHash);
+    jData["authorPubKey"] = authorPublicKeyBase64();
+    jData["signature"] = signatureBase64();
     jData["timestamp"] = timestamp;
-    jData["hash"] = hash;
+    jData["hash"] = hashHex();
     return jData;
 }
-}  // namespace blockchain
\ No newline at end of file
+}  // namespace blockchain
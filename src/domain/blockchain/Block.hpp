@@ -1,34 +1,68 @@
 #pragma once
+#include <array>
 #include <cstdint>
+#include <cstring>
+#include <functional>
 #include <nlohmann/json.hpp>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace blockchain
 {
 using json = nlohmann::json;
 
+// raw SHA-256 digest, the zero hash stands for "no block" (parent of the first block)
+using Hash = std::array<uint8_t, 32>;
+
+// hex is only used in JSON, the database and logs, the zero hash is written as "0"
+std::string hashToHex(const Hash& hash);
+// false if hex is neither "0" nor 64 hex digits
+bool hashFromHex(std::string_view hex, Hash& hash);
+
+struct HashHasher
+{
+    // digests are uniformly distributed, any 8 bytes make a good hash
+    size_t operator()(const Hash& hash) const
+    {
+        size_t value;
+        std::memcpy(&value, hash.data(), sizeof(value));
+        return value;
+    }
+};
+
 class Block
 {
 public:
-    std::string hash;
-    std::string previousHash;
-    std::string payloadHash;
-    std::string authorPublicKey;
-    std::string signature;
+    Hash hash{};
+    Hash previousHash{};
+    Hash payloadHash{};
+    std::vector<uint8_t> authorPublicKey;  // PEM of the author's key, base64 in JSON
+    std::vector<uint8_t> signature;        // raw ECDSA signature, base64 in JSON
     uint64_t timestamp = 0;
 
     Block();
-    Block(std::string hash,
-          std::string previousHash,
-          std::string payloadHash,
-          std::string authorPublicKey,
-          std::string signature,
+    Block(const Hash& hash,
+          const Hash& previousHash,
+          const Hash& payloadHash,
+          std::vector<uint8_t> authorPublicKey,
+          std::vector<uint8_t> signature,
           uint64_t timestamp);
+    // throws std::runtime_error on malformed hashes or base64 fields
     Block(const json& jData);
 
     std::string toStringForHash() const;
+    // hash of toStringForHash() without building the string
+    Hash calculateHash() const;
     void computeHash();
 
+    std::string hashHex() const;
+    std::string authorPublicKeyBase64() const;
+    std::string signatureBase64() const;
+
     json toJson() const;
 };
-}  // namespace blockchain
\ No newline at end of file
+
+// takes decoded blocks one at a time, returning false stops the decoder
+using BlockSink = std::function<bool(Block&& block)>;
+}  // namespace blockchain
@@ -2,7 +2,12 @@
 
 #include <openssl/sha.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <future>
+
 #include "BlockchainErrorMessage.hpp"
+#include "WorkerPool.hpp"
 #include "sha256.hpp"
 #include "timestamp.hpp"
 
@@ -13,20 +18,40 @@ bool BlockchainService::verifyBlockSignature(const Block& block)
     std::string canon = block.toStringForHash();
 
     crypto::Bytes msg(canon.begin(), canon.end());
-    crypto::Bytes sig = crypto->stringToKey(block.signature);
-    crypto::Bytes pub = crypto->stringToKey(block.authorPublicKey);
 
-    bool ok = crypto->verify(msg, sig, pub);
+    bool ok = crypto->verify(msg, block.signature, block.authorPublicKey);
 
     if (!ok)
     {
-        consoleUI->printLog("[BLOCKCHAIN] Invalid signature: " + block.hash + "\n");
+        consoleUI->printLog("[BLOCKCHAIN] Invalid signature: " + block.hashHex() + "\n");
         return false;
     }
 
     return true;
 }
 
+void BlockchainService::verifyBlockSignatures(const std::vector<Block>& blocks,
+                                              std::vector<bool>& valid)
+{
+    std::vector<crypto::SignatureCheck> checks(blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        std::string canon = blocks[i].toStringForHash();
+
+        checks[i].message.assign(canon.begin(), canon.end());
+        checks[i].signature = blocks[i].signature;
+        checks[i].publicKey = blocks[i].authorPublicKey;
+    }
+
+    crypto->verifyBatch(checks, valid);
+
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        if (!valid[i])
+            consoleUI->printLog("[BLOCKCHAIN] Invalid signature: " + blocks[i].hashHex() + "\n");
+    }
+}
+
 bool BlockchainService::validateSingleBlock(const Block& block, std::string& error)
 {
     if (!verifyBlockSignature(block))
@@ -35,13 +60,17 @@ bool BlockchainService::validateSingleBlock(const Block& block, std::string& err
         return false;
     }
 
-    Block tempBlock = block;
-    tempBlock.hash = "";
-    tempBlock.computeHash();
+    return validateBlockHash(block, error);
+}
+
+bool BlockchainService::validateBlockHash(const Block& block, std::string& error)
+{
+    Hash computed = block.calculateHash();
 
-    if (tempBlock.hash != block.hash)
+    if (computed != block.hash)
     {
-        error = "Block hash mismatch: computed=" + tempBlock.hash + ", stored=" + block.hash;
+        error = "Block hash mismatch: computed=" + hashToHex(computed) +
+                ", stored=" + block.hashHex();
         return false;
     }
 
@@ -50,10 +79,11 @@ bool BlockchainService::validateSingleBlock(const Block& block, std::string& err
 
 inline void BlockchainService::logValidationError(const std::string& context,
                                                   const std::string& error,
-                                                  const std::string& blockHash)
+                                                  const Hash& blockHash)
 {
-    consoleUI->printLog("[BLOCKCHAIN] " + context + " validation failed for block " + blockHash +
-                        ": " + error + "\n" + "Clear your blockchain database and try again.\n");
+    consoleUI->printLog("[BLOCKCHAIN] " + context + " validation failed for block " +
+                        hashToHex(blockHash) + ": " + error + "\n" +
+                        "Clear your blockchain database and try again.\n");
 }
 
 BlockchainService::BlockchainService(const std::shared_ptr<config::IConfig>& config,
@@ -64,6 +94,11 @@ BlockchainService::BlockchainService(const std::shared_ptr<config::IConfig>& con
 {
 }
 
+BlockchainService::~BlockchainService()
+{
+    if (broadcastPool) broadcastPool->shutdown();
+}
+
 std::vector<Block> BlockchainService::getNewBlocks() const
 {
     std::lock_guard<std::mutex> lock(newBlocksMutex);
@@ -82,17 +117,16 @@ void BlockchainService::createBlockFromMessage(const message::TextMessage& messa
     chainRepo->findTip(tip);
     block.previousHash = tip.hash;
 
-    block.payloadHash = utils::sha256(message.getPayload().message.data());
+    block.payloadHash = utils::sha256Digest(message.getPayload().message.data());
 
-    block.authorPublicKey = message.getFrom().publicKey;
+    block.authorPublicKey = crypto->stringToKey(message.getFrom().publicKey);
     block.timestamp = message.getTimestamp();
 
     std::string privateKey = config->get(config::ConfigField::PRIVATE_KEY);
     std::string canonical = block.toStringForHash();
     crypto::Bytes canonicalBytes(canonical.begin(), canonical.end());
     crypto::Bytes priv = crypto->stringToKey(privateKey);
-    crypto::Bytes sign = crypto->sign(canonicalBytes, priv);
-    block.signature = crypto->keyToString(sign);
+    block.signature = crypto->sign(canonicalBytes, priv);
 
     block.computeHash();
 }
@@ -100,30 +134,110 @@ void BlockchainService::createBlockFromMessage(const message::TextMessage& messa
 bool BlockchainService::storeAndBroadcastBlock(
     const Block& block,
     const std::vector<peer::UserPeer>& peers,
-    const std::function<bool(const std::string&, const peer::UserPeer&)>& sendCallback)
+    const std::function<bool(const std::string&, const peer::UserPeer&)>& sendCallback,
+    BroadcastResult& result,
+    const BroadcastPolicy& policy)
 {
-    std::string rawJson = block.toJson().dump();
+    enum class Ack
+    {
+        PENDING,
+        ACCEPTED,
+        REJECTED
+    };
 
-    for (const auto& p : peers)
+    // shared with the sends, a timed out send may still be running when this function returns
+    struct BroadcastState
     {
-        try
+        std::string rawJson;
+        std::function<bool(const std::string&, const peer::UserPeer&)> sendCallback;
+        std::vector<Ack> acks;
+        size_t answered = 0;
+        std::mutex mutex;
+        std::condition_variable allAnswered;
+    };
+
+    auto state = std::make_shared<BroadcastState>();
+    state->rawJson = block.toJson().dump();
+    state->sendCallback = sendCallback;
+    state->acks.assign(peers.size(), Ack::PENDING);
+
+    {
+        std::lock_guard<std::mutex> lock(broadcastPoolMutex);
+        if (!broadcastPool)
+            broadcastPool = std::make_unique<concurrency::WorkerPool>(BROADCAST_WORKERS,
+                                                                      BROADCAST_WORKERS * 16);
+    }
+
+    for (size_t i = 0; i < peers.size(); ++i)
+    {
+        peer::UserPeer peer = peers[i];
+        auto consoleUI = this->consoleUI;
+
+        // earlier timed out sends may still fill the pool, waiting for room would outlast the
+        // timeout, so a peer that can not be queued counts as failed
+        bool queued = broadcastPool->trySubmit(
+            [state, peer, i, consoleUI]()
+            {
+                bool accepted = false;
+                try
+                {
+                    accepted = state->sendCallback(state->rawJson, peer);
+                }
+                catch (std::exception& error)
+                {
+                    consoleUI->printLog(
+                        "[BLOCKCHAIN] error sending block to peer: " + std::string(error.what()) +
+                        "\n");
+                }
+
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->acks[i] = accepted ? Ack::ACCEPTED : Ack::REJECTED;
+                if (++state->answered == state->acks.size()) state->allAnswered.notify_one();
+            });
+
+        if (!queued)
         {
-            if (!sendCallback(rawJson, p)) return false;
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->acks[i] = Ack::REJECTED;
+            ++state->answered;
         }
-        catch (std::exception& error)
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->allAnswered.wait_for(lock,
+                                    std::chrono::milliseconds(policy.timeoutMs),
+                                    [&state]() { return state->answered == state->acks.size(); });
+
+        result = BroadcastResult();
+        for (size_t i = 0; i < peers.size(); ++i)
         {
-            consoleUI->printLog(
-                "[BLOCKCHAIN] error sending block to peer: " + std::string(error.what()) + "\n");
-            return false;
+            if (state->acks[i] == Ack::ACCEPTED)
+                result.accepted.push_back(peers[i]);
+            else if (state->acks[i] == Ack::REJECTED)
+                result.rejected.push_back(peers[i]);
+            else
+                result.timedOut.push_back(peers[i]);
         }
     }
 
+    if (!peers.empty())
+        consoleUI->printLog("[BLOCKCHAIN] broadcast " + block.hashHex() + ": " +
+                            std::to_string(result.accepted.size()) + " accepted, " +
+                            std::to_string(result.rejected.size()) + " rejected, " +
+                            std::to_string(result.timedOut.size()) + " timed out\n");
+
+    if (!result.rejected.empty() || result.accepted.size() < policy.quorum) return false;
+
+    std::lock_guard<std::mutex> lock(chainMutex);
     if (!chainRepo->insertBlock(block))
     {
-        consoleUI->printLog("[BLOCKCHAIN] Failed to store block: " + block.hash +
+        consoleUI->printLog("[BLOCKCHAIN] Failed to store block: " + block.hashHex() +
                             "(fork  probably)\n");
         return false;
     }
+
+    result.stored = true;
     return true;
 }
 
@@ -137,11 +251,19 @@ void BlockchainService::onIncomingBlock(const json& jData, std::string& response
     {
         Block block(jData);
         std::string error;
+        bool valid = validateSingleBlock(block, error);  // signature check needs no lock
+
+        if (valid)
+        {
+            std::lock_guard<std::mutex> lock(chainMutex);
+            valid = validateBlockPlacement(block, error);
+            if (valid) chainRepo->insertBlock(block);
+        }
 
-        if (!validateIncomingBlock(block, error))
+        if (!valid)
         {
             message::BlockchainErrorMessageResponse errorResponse =
-                message::BlockchainErrorMessageResponse::create(me, error, block.hash, "-1");
+                message::BlockchainErrorMessageResponse::create(me, error, block.hashHex(), "-1");
 
             json jData;
             errorResponse.serialize(jData);
@@ -150,7 +272,6 @@ void BlockchainService::onIncomingBlock(const json& jData, std::string& response
             return;
         }
 
-        chainRepo->insertBlock(block);
         response = "{}";
     }
     catch (const std::exception& error)
@@ -170,29 +291,31 @@ void BlockchainService::onIncomingBlock(const json& jData, std::string& response
 
 void BlockchainService::loadChain(std::vector<Block>& blocks) { chainRepo->loadAllBlocks(blocks); }
 
-bool BlockchainService::validateLocalChain()
+bool BlockchainService::validateChainWindow(const std::vector<Block>& blocks,
+                                            Hash& prevHash)
 {
-    std::vector<Block> blocks;
-    chainRepo->loadAllBlocks(blocks);
-
-    if (blocks.empty()) return true;
+    std::vector<bool> signatures;
+    verifyBlockSignatures(blocks, signatures);
 
     bool isValid = true;
-    std::string prevHash = "0";
-
     for (size_t i = 0; i < blocks.size(); ++i)
     {
-        Block& block = blocks[i];
+        const Block& block = blocks[i];
         std::string error;
 
         if (block.previousHash != prevHash)
         {
-            error =
-                "Previous hash mismatch: expected=" + prevHash + ", actual=" + block.previousHash;
+            error = "Previous hash mismatch: expected=" + hashToHex(prevHash) +
+                    ", actual=" + hashToHex(block.previousHash);
             isValid = false;
             logValidationError("LOCAL_CHAIN", error, block.hash);
         }
-        else if (!validateSingleBlock(block, error))
+        else if (!signatures[i])
+        {
+            isValid = false;
+            logValidationError("LOCAL_CHAIN", "Invalid block signature", block.hash);
+        }
+        else if (!validateBlockHash(block, error))
         {
             isValid = false;
             logValidationError("LOCAL_CHAIN", error, block.hash);
@@ -201,19 +324,70 @@ bool BlockchainService::validateLocalChain()
         prevHash = block.hash;
     }
 
-    if (isValid)
-        consoleUI->printLog("[BLOCKCHAIN] Local chain validated successfully (" +
-                            std::to_string(blocks.size()) + " blocks)\n");
-
     return isValid;
 }
 
-bool BlockchainService::validateIncomingBlock(const Block& block, std::string& error)
+bool BlockchainService::validateLocalChain(bool full)
 {
-    if (!validateSingleBlock(block, error))
+    u_int checkpointHeight = 0;
+    Hash checkpointHash{};
+    bool resume = !full && chainRepo->findCheckpoint(checkpointHeight, checkpointHash);
+
+    Hash baseHash = resume ? checkpointHash : Hash{};
+    u_int total = chainRepo->countBlocksAfterHash(baseHash);
+    if (total == 0) return true;
+
+    // only two windows are alive at a time: the one being checked and the one being read
+    std::vector<Block> window;
+    chainRepo->getBlocksByIndexRange(0, VALIDATION_WINDOW, baseHash, window);
+
+    bool isValid = true;
+    Hash prevHash = baseHash;
+    u_int validated = 0;
+
+    while (!window.empty())
+    {
+        validated += static_cast<u_int>(window.size());
+
+        std::vector<Block> next;
+        std::future<void> nextRead;
+        if (validated < total)
+        {
+            auto readNext = [this, &next, &baseHash, validated]()
+            { chainRepo->getBlocksByIndexRange(validated, VALIDATION_WINDOW, baseHash, next); };
+            nextRead = std::async(std::launch::async, readNext);
+        }
+
+        // the rest of the chain is not read once a block is invalid,
+        // a pending read is waited for by the destructor of its future
+        if (!validateChainWindow(window, prevHash))
+        {
+            isValid = false;
+            break;
+        }
+
+        if (nextRead.valid()) nextRead.get();
+        window.swap(next);
+    }
+
+    if (!isValid)
     {
+        chainRepo->clearCheckpoint();  // next start checks the whole chain again
         return false;
     }
+
+    u_int tipHeight = (resume ? checkpointHeight + 1 : 0) + validated - 1;
+    chainRepo->saveCheckpoint(tipHeight, prevHash);
+
+    consoleUI->printLog("[BLOCKCHAIN] Local chain validated successfully (" +
+                        std::to_string(validated) + " blocks" +
+                        (resume ? " after checkpoint " + hashToHex(checkpointHash) : "") + ")\n");
+
+    return true;
+}
+
+bool BlockchainService::validateBlockPlacement(const Block& block, std::string& error)
+{
     uint64_t currentTimestamp = utils::getTimestamp();
     if (block.timestamp > currentTimestamp + 300000)  // this time + 5 minutes
     {
@@ -225,18 +399,11 @@ bool BlockchainService::validateIncomingBlock(const Block& block, std::string& e
     chainRepo->findTip(tip);
     if (block.previousHash != tip.hash)
     {
-        Block prevBlock;
-        if (!chainRepo->findBlockByHash(block.previousHash, prevBlock))
-        {
+        if (!chainRepo->hasBlock(block.previousHash))
             error = "Previous block not found in local chain";
-            return false;
-        }
-
-        if (prevBlock.hash != tip.hash)
-        {
+        else
             error = "Block extends non-tip block (fork detected)";
-            return false;
-        }
+        return false;
     }
 
     if (chainRepo->hasBlock(block.hash))
@@ -248,6 +415,11 @@ bool BlockchainService::validateIncomingBlock(const Block& block, std::string& e
     return true;
 }
 
+bool BlockchainService::validateIncomingBlock(const Block& block, std::string& error)
+{
+    return validateSingleBlock(block, error) && validateBlockPlacement(block, error);
+}
+
 bool BlockchainService::validateNewBlocks()
 {
     std::lock_guard<std::mutex> lock(newBlocksMutex);
@@ -259,8 +431,8 @@ bool BlockchainService::validateNewBlocks()
         if (newBlocks[i].previousHash != newBlocks[i - 1].hash)
         {
             std::string error = "New blocks sequence broken at index " + std::to_string(i) +
-                                ": expected=" + newBlocks[i - 1].hash +
-                                ", actual=" + newBlocks[i].previousHash;
+                                ": expected=" + newBlocks[i - 1].hashHex() +
+                                ", actual=" + hashToHex(newBlocks[i].previousHash);
             logValidationError("NEW_BLOCKS", error, newBlocks[i].hash);
             return false;
         }
@@ -271,29 +443,26 @@ bool BlockchainService::validateNewBlocks()
 
     if (found && newBlocks[0].previousHash != tip.hash)
     {
-        std::string error;
-        Block prevBlock;
-
-        if (!chainRepo->findBlockByHash(newBlocks[0].previousHash, prevBlock))
-        {
-            error = "First new block's previous hash not found in local chain";
-            logValidationError("NEW_BLOCKS", error, newBlocks[0].hash);
-            return false;
-        }
-
-        if (prevBlock.hash != tip.hash)
-        {
-            error = "New blocks extend non-tip block (fork detected)";
-            logValidationError("NEW_BLOCKS", error, newBlocks[0].hash);
-            return false;
-        }
+        std::string error = chainRepo->hasBlock(newBlocks[0].previousHash)
+                                ? "New blocks extend non-tip block (fork detected)"
+                                : "First new block's previous hash not found in local chain";
+        logValidationError("NEW_BLOCKS", error, newBlocks[0].hash);
+        return false;
     }
 
+    std::vector<bool> signatures;
+    verifyBlockSignatures(newBlocks, signatures);
+
     bool allValid = true;
     for (size_t i = 0; i < newBlocks.size(); ++i)
     {
         std::string error;
-        if (!validateSingleBlock(newBlocks[i], error))
+        if (!signatures[i])
+            error = "Invalid block signature";
+        else
+            validateBlockHash(newBlocks[i], error);
+
+        if (!error.empty())
         {
             logValidationError("NEW_BLOCKS", error, newBlocks[i].hash);
             allValid = false;
@@ -304,13 +473,63 @@ bool BlockchainService::validateNewBlocks()
     return allValid;
 }
 
+bool BlockchainService::validateBlockRange(const std::vector<Block>& blocks)
+{
+    std::vector<bool> signatures;
+    verifyBlockSignatures(blocks, signatures);
+
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        std::string error;
+        if (i > 0 && blocks[i].previousHash != blocks[i - 1].hash)
+            error = "Block range sequence broken at index " + std::to_string(i);
+        else if (!signatures[i])
+            error = "Invalid block signature";
+        else
+            validateBlockHash(blocks[i], error);
+
+        if (!error.empty())
+        {
+            consoleUI->printLog("[BLOCKCHAIN] SYNC validation failed for block " +
+                                blocks[i].hashHex() + ": " + error + "\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool BlockchainService::appendBlockRange(const std::vector<Block>& blocks)
+{
+    if (blocks.empty()) return true;
+
+    std::lock_guard<std::mutex> lock(chainMutex);
+
+    Block tip;
+    if (chainRepo->findTip(tip) && blocks[0].previousHash != tip.hash)
+    {
+        consoleUI->printLog("[BLOCKCHAIN] SYNC block range does not extend the tip: " +
+                            blocks[0].hashHex() + "\n");
+        return false;
+    }
+
+    if (!chainRepo->insertBlocks(blocks))
+    {
+        consoleUI->printLog("[BLOCKCHAIN] Failed to store block range starting at " +
+                            blocks[0].hashHex() + "\n");
+        return false;
+    }
+
+    return true;
+}
+
 bool BlockchainService::compareBlockWithMessage(const Block& block,
                                                 const message::TextMessage& message,
                                                 std::string& error)
 {
-    if (block.authorPublicKey != message.getFrom().publicKey)
+    if (block.authorPublicKey != crypto->stringToKey(message.getFrom().publicKey))
     {
-        error = "Author public key mismatch: block=" + block.authorPublicKey +
+        error = "Author public key mismatch: block=" + block.authorPublicKeyBase64() +
                 ", message=" + message.getFrom().publicKey;
         return false;
     }
@@ -323,12 +542,13 @@ bool BlockchainService::compareBlockWithMessage(const Block& block,
     }
 
     std::string messageContent = message.getPayload().message;
-    std::string computedPayloadHash = utils::sha256(messageContent.data());
+    Hash computedPayloadHash = utils::sha256Digest(messageContent.data());
 
     if (computedPayloadHash != block.payloadHash)
     {
-        error = "Payload hash mismatch: block=" + block.payloadHash +
-                ", computed=" + computedPayloadHash + ", content='" + messageContent + "'";
+        error = "Payload hash mismatch: block=" + hashToHex(block.payloadHash) +
+                ", computed=" + hashToHex(computedPayloadHash) + ", content='" + messageContent +
+                "'";
         return false;
     }
 
@@ -341,20 +561,20 @@ bool BlockchainService::compareBlockWithMessage(const Block& block,
     return true;
 }
 
-u_int BlockchainService::countBlocksAfterHash(const std::string& hash)
+u_int BlockchainService::countBlocksAfterHash(const Hash& hash)
 {
     return chainRepo->countBlocksAfterHash(hash);
 }
 
 void BlockchainService::getBlocksByIndexRange(u_int start,
                                               u_int count,
-                                              const std::string& lastHash,
+                                              const Hash& lastHash,
                                               std::vector<Block>& outBlocks)
 {
     chainRepo->getBlocksByIndexRange(start, count, lastHash, outBlocks);
 }
 
-bool BlockchainService::findBlockByHash(const std::string& hash, Block& block)
+bool BlockchainService::findBlockByHash(const Hash& hash, Block& block)
 {
     return chainRepo->findBlockByHash(hash, block);
 }
@@ -2,6 +2,7 @@
 
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "ConsoleUI.hpp"
@@ -11,8 +12,32 @@
 #include "TextMessage.hpp"
 #include "UserPeer.hpp"
 
+namespace concurrency
+{
+class WorkerPool;
+}
+
 namespace blockchain
 {
+constexpr const u_int BROADCAST_TIMEOUT_MS = 5000;
+constexpr const size_t BROADCAST_WORKERS = 16;
+constexpr const u_int VALIDATION_WINDOW = 256;  // blocks read from the repo at once when validating
+
+struct BroadcastPolicy
+{
+    u_int timeoutMs = BROADCAST_TIMEOUT_MS;  // peers that did not answer by then count as timed out
+    size_t quorum = 0;  // minimum number of accepting peers needed to store the block
+};
+
+// outcome of one block broadcast, peers are sorted by how they answered
+struct BroadcastResult
+{
+    std::vector<peer::UserPeer> accepted;
+    std::vector<peer::UserPeer> rejected;
+    std::vector<peer::UserPeer> timedOut;
+    bool stored = false;
+};
+
 class BlockchainService
 {
 private:
@@ -23,43 +48,63 @@ private:
 
     std::vector<Block> newBlocks;
     mutable std::mutex newBlocksMutex;
+    // serializes "check tip, then insert" so concurrent incoming blocks can not both extend it
+    std::mutex chainMutex;
+
+    std::unique_ptr<concurrency::WorkerPool> broadcastPool;  // created on first broadcast
+    std::mutex broadcastPoolMutex;
 
     bool verifyBlockSignature(const Block& block);
+    // valid[i] tells whether the signature of blocks[i] holds, checked in one crypto batch
+    void verifyBlockSignatures(const std::vector<Block>& blocks, std::vector<bool>& valid);
+    bool validateBlockHash(const Block& block, std::string& error);
     bool validateSingleBlock(const Block& block, std::string& error);
+    // checks one window of the local chain, prevHash is the hash the window has to link to
+    bool validateChainWindow(const std::vector<Block>& blocks, Hash& prevHash);
+    bool validateBlockPlacement(const Block& block, std::string& error);
     inline void logValidationError(const std::string& context,
                                    const std::string& error,
-                                   const std::string& blockHash);
+                                   const Hash& blockHash);
 
 public:
     BlockchainService(const std::shared_ptr<config::IConfig>& config,
                       const std::shared_ptr<crypto::ICrypto>& crypto,
                       const std::shared_ptr<IChainRepo>& chainRepo,
                       const std::shared_ptr<ui::ConsoleUI>& consoleUI);
+    ~BlockchainService();
 
     std::vector<Block> getNewBlocks() const;
     void addNewBlockRange(const std::vector<Block>& blocks);
     void createBlockFromMessage(const message::TextMessage& message,
 
                                 Block& block);
+    // sends the block to all peers at once, stores it if nobody rejected it and quorum is reached
     bool storeAndBroadcastBlock(
         const Block& block,
         const std::vector<peer::UserPeer>& peers,
-        const std::function<bool(const std::string&, const peer::UserPeer&)>& sendCallback);
+        const std::function<bool(const std::string&, const peer::UserPeer&)>& sendCallback,
+        BroadcastResult& result,
+        const BroadcastPolicy& policy = BroadcastPolicy());
     void onIncomingBlock(const json& jData, std::string& response);
     void loadChain(std::vector<Block>& blocks);
 
-    bool validateLocalChain();
+    // checks the blocks stored after the last checkpoint, or the whole chain when full is set
+    bool validateLocalChain(bool full = false);
     bool validateIncomingBlock(const Block& block, std::string& error);
     bool validateNewBlocks();
+    // signatures, hashes and links inside a downloaded range, safe to call from several threads
+    bool validateBlockRange(const std::vector<Block>& blocks);
+    // stores a validated range, it has to extend the current tip
+    bool appendBlockRange(const std::vector<Block>& blocks);
     bool compareBlockWithMessage(const Block& block,
                                  const message::TextMessage& message,
                                  std::string& error);
 
-    u_int countBlocksAfterHash(const std::string& hash);
+    u_int countBlocksAfterHash(const Hash& hash);
     void getBlocksByIndexRange(u_int start,
                                u_int count,
-                               const std::string& lastHash,
+                               const Hash& lastHash,
                                std::vector<Block>& outBlocks);
-    bool findBlockByHash(const std::string& hash, Block& block);
+    bool findBlockByHash(const Hash& hash, Block& block);
 };
 }  // namespace blockchain
@@ -0,0 +1,76 @@
+#include "ChainIndex.hpp"
+
+#include <mutex>
+
+namespace blockchain
+{
+void ChainIndex::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    heights.clear();
+    tip = Block();
+    tipHeight = -1;
+}
+
+void ChainIndex::add(const Hash& hash, int64_t height)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    heights[hash] = height;
+}
+
+void ChainIndex::setTip(const Block& block, int64_t height)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    heights[block.hash] = height;
+    tip = block;
+    tipHeight = height;
+}
+
+void ChainIndex::append(const Block& block)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    heights[block.hash] = ++tipHeight;
+    tip = block;
+}
+
+bool ChainIndex::contains(const Hash& hash) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return heights.count(hash) > 0;
+}
+
+bool ChainIndex::findHeight(const Hash& hash, int64_t& height) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+
+    auto it = heights.find(hash);
+    if (it == heights.end()) return false;
+
+    height = it->second;
+    return true;
+}
+
+bool ChainIndex::findTip(Block& block) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (tipHeight < 0) return false;
+
+    block = tip;
+    return true;
+}
+
+bool ChainIndex::findTipHeight(int64_t& height) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (tipHeight < 0) return false;
+
+    height = tipHeight;
+    return true;
+}
+
+size_t ChainIndex::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return heights.size();
+}
+}  // namespace blockchain
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "Block.hpp"
+
+namespace blockchain
+{
+// in-memory copy of the block headers a repository stores: hash -> height and the tip.
+// lets tip, height and existence checks skip the database
+class ChainIndex
+{
+private:
+    std::unordered_map<Hash, int64_t, HashHasher> heights;
+    Block tip;
+    int64_t tipHeight = -1;  // -1 while the chain is empty
+    mutable std::shared_mutex mutex;
+
+public:
+    void clear();
+    void add(const Hash& hash, int64_t height);
+    void setTip(const Block& block, int64_t height);
+    // block stored right after the current tip
+    void append(const Block& block);
+
+    bool contains(const Hash& hash) const;
+    bool findHeight(const Hash& hash, int64_t& height) const;
+    bool findTip(Block& block) const;
+    bool findTipHeight(int64_t& height) const;
+    size_t size() const;
+};
+}  // namespace blockchain
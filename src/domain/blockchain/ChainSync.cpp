@@ -0,0 +1,241 @@
+#include "ChainSync.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace blockchain
+{
+ChainSync::ChainSync(const std::shared_ptr<BlockchainService>& blockchainService,
+                     const std::shared_ptr<ui::ConsoleUI>& consoleUI,
+                     u_int batchSize,
+                     size_t requestsPerPeer)
+    : blockchainService(blockchainService),
+      consoleUI(consoleUI),
+      batchSize(batchSize > 0 ? batchSize : 1),
+      requestsPerPeer(requestsPerPeer > 0 ? requestsPerPeer : 1)
+{
+}
+
+bool ChainSync::peerAlive(size_t peerIndex) const
+{
+    return peerFailures[peerIndex] < SYNC_MAX_PEER_FAILURES;
+}
+
+bool ChainSync::rangeExhausted(const Range& range) const
+{
+    for (size_t i = 0; i < peers.size(); ++i)
+        if (peerAlive(i) && range.failedPeers.count(i) == 0) return false;
+
+    return true;
+}
+
+bool ChainSync::takeRange(size_t peerIndex, Range& range)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true)
+    {
+        if (aborted || nextStart >= missingCount || !peerAlive(peerIndex)) return false;
+
+        for (auto it = pending.begin(); it != pending.end(); ++it)
+        {
+            if (it->failedPeers.count(peerIndex) > 0) continue;
+
+            range = std::move(*it);
+            range.peerIndex = peerIndex;
+            pending.erase(it);
+            return true;
+        }
+
+        changed.wait(lock);
+    }
+}
+
+void ChainSync::completeRange(Range range)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    u_int start = range.start;
+    fetched.emplace(start, std::move(range));
+    changed.notify_all();
+
+    // one thread stores at a time, the others only leave their ranges in fetched
+    if (storing) return;
+    storing = true;
+
+    // requests already in flight are still stored after an abort
+    while (true)
+    {
+        std::vector<Range> ready;
+        for (u_int next = nextStart; !fetched.empty() && fetched.begin()->first == next;)
+        {
+            next += fetched.begin()->second.count;
+            ready.push_back(std::move(fetched.begin()->second));
+            fetched.erase(fetched.begin());
+        }
+        if (ready.empty()) break;
+
+        // appending writes to the database, other threads keep taking ranges meanwhile
+        lock.unlock();
+        size_t stored = 0;
+        bool brokenLink = false;
+        while (stored < ready.size() && storeRange(ready[stored], brokenLink)) ++stored;
+        lock.lock();
+
+        for (size_t i = 0; i < stored; ++i) nextStart += ready[i].count;
+        if (stored < ready.size())
+        {
+            for (size_t i = stored + 1; i < ready.size(); ++i)
+            {
+                u_int readyStart = ready[i].start;
+                fetched.emplace(readyStart, std::move(ready[i]));
+            }
+            failRange(std::move(ready[stored]), brokenLink);
+        }
+        changed.notify_all();
+    }
+
+    storing = false;
+}
+
+bool ChainSync::storeRange(const Range& range, bool& brokenLink)
+{
+    // the first range is checked against the local tip by appendBlockRange, later ones have
+    // to attach to the range stored before them, which may be the wrong one
+    brokenLink = range.start > 0 && range.blocks.front().previousHash != storedTip;
+    if (brokenLink || !blockchainService->appendBlockRange(range.blocks)) return false;
+
+    storedTip = range.blocks.back().hash;
+    storedTipPeer = range.peerIndex;
+    return true;
+}
+
+void ChainSync::failRange(Range range, bool brokenLink)
+{
+    range.blocks.clear();
+    range.failedPeers.insert(range.peerIndex);
+
+    // a range that does not attach is fetched from other peers first, only when enough of them
+    // disagree with the stored blocks the peer those came from is blamed
+    size_t blamedPeer = range.peerIndex;
+    if (brokenLink && ++range.brokenLinks >= SYNC_LINK_DISAGREEMENTS) blamedPeer = storedTipPeer;
+
+    if (++peerFailures[blamedPeer] == SYNC_MAX_PEER_FAILURES)
+        consoleUI->printLog("[SYNC] dropping peer " + peers[blamedPeer].host + ":" +
+                            std::to_string(peers[blamedPeer].port) + " after " +
+                            std::to_string(SYNC_MAX_PEER_FAILURES) + " failed ranges\n");
+
+    if (!peerAlive(blamedPeer) && blamedPeer != range.peerIndex)
+    {
+        // blocks already stored came from a dropped peer, nothing can attach to them
+        consoleUI->printLog("[SYNC] blocks from " + std::to_string(range.start) +
+                            " do not attach to the stored ones, sync stopped\n");
+        aborted = true;
+    }
+
+    // retry from the front so the range blocking storage is fetched first
+    pending.push_front(std::move(range));
+
+    for (const auto& waiting : pending)
+    {
+        if (rangeExhausted(waiting))
+        {
+            consoleUI->printLog("[SYNC] no peer could provide blocks from " +
+                                std::to_string(waiting.start) + ", sync stopped\n");
+            aborted = true;
+            break;
+        }
+    }
+
+    changed.notify_all();
+}
+
+void ChainSync::runPeer(size_t peerIndex, const FetchCallback& fetch)
+{
+    Range range;
+    while (takeRange(peerIndex, range))
+    {
+        std::vector<Block> blocks;
+        blocks.reserve(range.count);
+        // a peer sending more blocks than asked for is cut off instead of filling memory
+        auto take = [&blocks, &range](Block&& block)
+        {
+            if (blocks.size() == range.count) return false;
+
+            blocks.push_back(std::move(block));
+            return true;
+        };
+        bool ok = false;
+
+        try
+        {
+            ok = fetch(peers[peerIndex], range.start, range.count, take);
+        }
+        catch (std::exception& error)
+        {
+            consoleUI->printLog("[SYNC] error fetching blocks from " + peers[peerIndex].host + ":" +
+                                std::to_string(peers[peerIndex].port) + ": " + error.what() +
+                                "\n");
+        }
+
+        // signatures are checked here, in parallel, only linking to the tip is left for storage
+        ok = ok && blocks.size() == range.count && blockchainService->validateBlockRange(blocks);
+
+        if (ok)
+        {
+            range.blocks = std::move(blocks);
+            completeRange(std::move(range));
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            size_t peer = range.peerIndex;
+            failRange(std::move(range), peer);
+        }
+
+        range = Range();
+    }
+}
+
+u_int ChainSync::run(const std::vector<peer::UserPeer>& peers,
+                     u_int missingCount,
+                     const FetchCallback& fetch)
+{
+    if (peers.empty() || missingCount == 0) return 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->peers = peers;
+        this->missingCount = missingCount;
+        peerFailures.assign(peers.size(), 0);
+        pending.clear();
+        fetched.clear();
+        nextStart = 0;
+        storing = false;
+        aborted = false;
+        storedTip = Hash{};
+        storedTipPeer = 0;
+
+        for (u_int start = 0; start < missingCount; start += batchSize)
+        {
+            Range range;
+            range.start = start;
+            range.count = std::min(batchSize, missingCount - start);
+            pending.push_back(std::move(range));
+        }
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < peers.size(); ++i)
+        for (size_t j = 0; j < requestsPerPeer; ++j)
+            threads.emplace_back(&ChainSync::runPeer, this, i, std::cref(fetch));
+
+    for (auto& thread : threads) thread.join();
+
+    consoleUI->printLog("[SYNC] stored " + std::to_string(nextStart) + " of " +
+                        std::to_string(missingCount) + " missing blocks from " +
+                        std::to_string(peers.size()) + " peers\n");
+
+    return nextStart;
+}
+}  // namespace blockchain
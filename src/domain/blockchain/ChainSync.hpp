@@ -0,0 +1,88 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "BlockchainService.hpp"
+#include "ConsoleUI.hpp"
+#include "UserPeer.hpp"
+
+namespace blockchain
+{
+constexpr const u_int SYNC_BATCH_SIZE = 256;
+constexpr const size_t SYNC_REQUESTS_PER_PEER = 4;  // range requests kept in flight to every peer
+constexpr const size_t SYNC_MAX_PEER_FAILURES = 3;  // after that many failed ranges the peer is dropped
+// peers whose range did not attach to the stored blocks before the peer of those blocks is blamed
+constexpr const size_t SYNC_LINK_DISAGREEMENTS = 2;
+
+// downloads the missing part of the chain from all peers at once and stores it in order
+class ChainSync
+{
+public:
+    // asks peer for blocks [start, start + count) after the local tip and hands them to sink
+    // as they are decoded
+    using FetchCallback = std::function<bool(
+        const peer::UserPeer& peer, u_int start, u_int count, const BlockSink& sink)>;
+
+private:
+    struct Range
+    {
+        u_int start = 0;
+        u_int count = 0;
+        size_t peerIndex = 0;  // peer the blocks came from
+        std::vector<Block> blocks;
+        std::unordered_set<size_t> failedPeers;
+        size_t brokenLinks = 0;  // peers whose blocks did not attach to the stored ones
+    };
+
+    std::shared_ptr<BlockchainService> blockchainService;
+    std::shared_ptr<ui::ConsoleUI> consoleUI;
+    u_int batchSize;
+    size_t requestsPerPeer;
+
+    // state of the running sync, guarded by mutex
+    std::vector<peer::UserPeer> peers;
+    std::vector<size_t> peerFailures;
+    std::deque<Range> pending;      // not requested yet or waiting for a retry
+    std::map<u_int, Range> fetched;  // downloaded, waiting for the ranges before them
+    u_int missingCount = 0;
+    u_int nextStart = 0;  // first block not stored yet
+    bool storing = false;  // a thread is appending ranges outside the lock
+    bool aborted = false;
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    // last stored block and the peer it came from, only used by the storing thread
+    Hash storedTip{};
+    size_t storedTipPeer = 0;
+
+    void runPeer(size_t peerIndex, const FetchCallback& fetch);
+    bool takeRange(size_t peerIndex, Range& range);
+    void completeRange(Range range);
+    // appends ranges in order, brokenLink tells a range that did not attach to the stored
+    // blocks apart from one that could not be stored
+    bool storeRange(const Range& range, bool& brokenLink);
+
+    // caller holds mutex
+    void failRange(Range range, bool brokenLink = false);
+    bool peerAlive(size_t peerIndex) const;
+    bool rangeExhausted(const Range& range) const;
+
+public:
+    ChainSync(const std::shared_ptr<BlockchainService>& blockchainService,
+              const std::shared_ptr<ui::ConsoleUI>& consoleUI,
+              u_int batchSize = SYNC_BATCH_SIZE,
+              size_t requestsPerPeer = SYNC_REQUESTS_PER_PEER);
+
+    // returns the number of stored blocks
+    u_int run(const std::vector<peer::UserPeer>& peers,
+              u_int missingCount,
+              const FetchCallback& fetch);
+};
+}  // namespace blockchain
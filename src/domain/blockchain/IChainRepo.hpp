@@ -17,16 +17,24 @@ public:
     virtual void init() = 0;
 
     virtual bool insertBlock(const Block& block) = 0;
-    virtual bool findBlockByHash(const std::string& hash, Block& block) = 0;
+    // stores a linked segment in one transaction, nothing is stored if any block fails
+    virtual bool insertBlocks(const std::vector<Block>& blocks) = 0;
+    virtual bool findBlockByHash(const Hash& hash, Block& block) = 0;
     virtual void getBlocksByIndexRange(u_int start,
                                        u_int count,
-                                       const std::string& lastHash,
+                                       const Hash& lastHash,
                                        std::vector<Block>& outBlocks) = 0;
-    virtual u_int countBlocksAfterHash(const std::string& hash) = 0;
-    virtual bool hasBlock(const std::string& hash) = 0;
+    virtual u_int countBlocksAfterHash(const Hash& hash) = 0;
+    virtual bool hasBlock(const Hash& hash) = 0;
     virtual void loadAllBlocks(std::vector<Block>& blocks) = 0;
 
     virtual bool findTip(Block& block) = 0;
+    // height of the tip, the first block has height 0
     virtual bool findTipIndex(u_int& index) = 0;
+
+    // last block known to be valid, false if there is none or it is no longer at that height
+    virtual bool findCheckpoint(u_int& height, Hash& hash) = 0;
+    virtual void saveCheckpoint(u_int height, const Hash& hash) = 0;
+    virtual void clearCheckpoint() = 0;
 };
 }  // namespace blockchain
@@ -1,12 +1,149 @@
 #include "ChatService.hpp"
 
+#include <algorithm>
+
 #include "Block.hpp"
 #include "GlobalState.hpp"
+#include "binary.hpp"
 #include "timestamp.hpp"
 #include "uuid.hpp"
 
 namespace chat
 {
+class ChatService::Received
+{
+private:
+    const json* jData = nullptr;
+    std::string_view frame;  // binary frame, or the JSON text when the caller kept it
+
+public:
+    message::MessageType type = message::MessageType::NONE;
+
+    // an unknown or missing "type" is left as NONE, which has no route
+    explicit Received(const json& jData, std::string_view text = {}) : jData(&jData), frame(text)
+    {
+        auto it = jData.find("type");
+        if (it != jData.end() && it->is_string())
+            message::Message::findMessageType(it->get_ref<const std::string&>(), type);
+    }
+
+    explicit Received(std::string_view frame)
+        : frame(frame), type(message::Message::peekBinaryType(frame))
+    {
+    }
+
+    bool isBinary() const { return jData == nullptr; }
+
+    // only JSON messages have one
+    const json& getJson() const
+    {
+        if (!jData) throw std::logic_error("Binary message has no JSON form");
+        return *jData;
+    }
+
+    // the JSON text as received, serialized again only if the caller did not keep it
+    std::string getJsonText() const
+    {
+        return frame.empty() ? getJson().dump() : std::string(frame);
+    }
+
+    template <typename T>
+    T decode() const
+    {
+        if (jData) return T(*jData);
+
+        utils::BinaryReader reader(frame);
+        return T(reader);
+    }
+};
+
+template <typename Request, void (ChatService::*Handle)(const Request&, std::string&)>
+void ChatService::serve(ChatService& service, const Received& received, std::string& response)
+{
+    (service.*Handle)(received.decode<Request>(), response);
+}
+
+template <typename Response, void (ChatService::*Handle)(const Response&)>
+void ChatService::accept(ChatService& service, const Received& received)
+{
+    (service.*Handle)(received.decode<Response>());
+}
+
+// requests the server answers
+const std::array<ChatService::IncomingRoute, message::MESSAGE_TYPE_COUNT>
+    ChatService::INCOMING_ROUTES = []()
+{
+    using message::MessageType;
+
+    std::array<IncomingRoute, message::MESSAGE_TYPE_COUNT> routes{};
+    auto route = [&routes](MessageType type, IncomingRoute handler)
+    { routes[static_cast<size_t>(type)] = handler; };
+
+    route(MessageType::CONNECT,
+          &serve<message::ConnectionMessage, &ChatService::handleIncomingConnectionMessage>);
+    route(MessageType::PEER_LIST,
+          &serve<message::PeerListMessage, &ChatService::handleIncomingPeerListMessage>);
+    route(MessageType::BLOCK_RANGE_REQUEST,
+          &serve<message::BlockRangeMessage, &ChatService::handleIncomingBlockRangeMessage>);
+    route(MessageType::DISCONNECT,
+          &serve<message::DisconnectionMessage, &ChatService::handleIncomingDisconnectionMessage>);
+    route(MessageType::BLOCKCHAIN_ERROR_RESPONSE,
+          [](ChatService& service, const Received& received, std::string&)
+          {
+              service.handleOutgoingBlockchainErrorMessage(
+                  received.decode<message::BlockchainErrorMessageResponse>());
+          });
+    // text messages are stored the way they were sent, so they only come as JSON
+    route(MessageType::TEXT_MESSAGE,
+          [](ChatService& service, const Received& received, std::string& response)
+          {
+              if (received.isBinary())
+              {
+                  response = R"({"type":"ERROR_RESPONSE","error":"Invalid message type"})";
+                  return;
+              }
+
+              message::TextMessage message(received.getJson(),
+                                           service.config->get(config::ConfigField::PRIVATE_KEY),
+                                           service.crypto);
+              service.handleIncomingTextMessage(message, received.getJsonText(), response);
+          });
+
+    return routes;
+}();
+
+// responses the client reads
+const std::array<ChatService::OutgoingRoute, message::MESSAGE_TYPE_COUNT>
+    ChatService::OUTGOING_ROUTES = []()
+{
+    using message::MessageType;
+
+    std::array<OutgoingRoute, message::MESSAGE_TYPE_COUNT> routes{};
+    auto route = [&routes](MessageType type, OutgoingRoute handler)
+    { routes[static_cast<size_t>(type)] = handler; };
+
+    route(MessageType::ERROR_RESPONSE,
+          &accept<message::ErrorMessageResponse, &ChatService::handleOutgoingErrorMessage>);
+    route(MessageType::BLOCKCHAIN_ERROR_RESPONSE,
+          &accept<message::BlockchainErrorMessageResponse,
+                  &ChatService::handleOutgoingBlockchainErrorMessage>);
+    route(MessageType::CONNECT_RESPONSE,
+          &accept<message::ConnectionMessageResponse,
+                  &ChatService::handleOutgoingConnectionMessage>);
+    route(MessageType::TEXT_MESSAGE_RESPONSE,
+          &accept<message::TextMessageResponse, &ChatService::handleOutgoingTextMessage>);
+    route(MessageType::PEER_LIST_RESPONSE,
+          &accept<message::PeerListMessageResponse, &ChatService::handleOutgoingPeerListMessage>);
+    route(MessageType::BLOCK_RANGE_RESPONSE,
+          &accept<message::BlockRangeMessageResponse,
+                  &ChatService::handleOutgoingBlockRangeMessage>);
+    route(MessageType::DISCONNECT_RESPONSE,
+          &accept<message::DisconnectionMessageResponse,
+                  &ChatService::handleOutgoingDisconnectionMessage>);
+
+    return routes;
+}();
+
 void ChatService::handleIncomingErrorMessage(const json& jData,
                                              const std::string& error,
                                              std::string& response)
@@ -37,6 +174,28 @@ void ChatService::handleIncomingErrorMessage(const json& jData,
     response = R"({"type":"ERROR_RESPONSE","error":"Invalid request"})";
 }
 
+void ChatService::handleIncomingBinaryErrorMessage(std::string_view frame, std::string& response)
+{
+    peer::UserPeer to;
+    try
+    {
+        to = message::Message::peekBinarySender(frame);
+    }
+    catch (utils::BinaryFormatError&)
+    {
+        response = R"({"type":"ERROR_RESPONSE","error":"Invalid request"})";
+        return;
+    }
+
+    std::string host = config->get(config::ConfigField::HOST);
+    unsigned short port = static_cast<unsigned short>(stoi(config->get(config::ConfigField::PORT)));
+    peer::UserPeer me(host, port, config->get(config::ConfigField::PUBLIC_KEY));
+
+    message::ErrorMessageResponse errorMessage =
+        message::ErrorMessageResponse::create(me, to, "Invalid request");
+    response = errorMessage.toWire(message::WireFormat::BINARY);
+}
+
 void ChatService::handleOutgoingBlockchainErrorMessage(
     const message::BlockchainErrorMessageResponse& response)
 {
@@ -71,18 +230,22 @@ void ChatService::handleIncomingConnectionMessage(const message::ConnectionMessa
 
     peerService->addPeer({ from.host, from.port, from.publicKey });
 
+    // both sides use the highest format they know, old peers send no version and get JSON
+    uint8_t agreedVersion = std::min(wireVersion, payload.wireVersion);
+    peerService->setWireVersion(from, agreedVersion);
+
     peer::UserPeer me{ to.host, to.port, config->get(config::ConfigField::PUBLIC_KEY) };
 
     unsigned int peersToReceive = peerService->getPeersCount();
-    unsigned int missingCount = blockchainService->countBlocksAfterHash(payload.lastBlockHash);
-
-    message::ConnectionMessageResponse responseMessage =
-        message::ConnectionMessageResponse::create(me, from, peersToReceive, missingCount);
+    // a malformed hash is treated like an unknown one: the peer is missing the whole chain
+    blockchain::Hash lastBlockHash{};
+    blockchain::hashFromHex(payload.lastBlockHash, lastBlockHash);
+    unsigned int missingCount = blockchainService->countBlocksAfterHash(lastBlockHash);
 
-    json jData;
-    responseMessage.serialize(jData);
+    message::ConnectionMessageResponse responseMessage = message::ConnectionMessageResponse::create(
+        me, from, peersToReceive, missingCount, agreedVersion);
 
-    response = jData.dump();
+    response = responseMessage.toWire(message.getWireFormat());
     consoleUI->printLog("[SERVER] accepted new peer from " + from.host + ":" +
                         std::to_string(from.port) + "\n");
 }
@@ -94,6 +257,7 @@ void ChatService::handleOutgoingConnectionMessage(
     peerService->addPeer({ from.host, from.port, from.publicKey });
 
     const message::ConnectionMessageResponsePayload& payload = response.getPayload();
+    peerService->setWireVersion(from, std::min(wireVersion, payload.wireVersion));
     config::GlobalState& globalState = config::GlobalState::getInstance();
 
     globalState.setPeersToReceive(payload.peersToReceive);
@@ -120,10 +284,7 @@ void ChatService::handleIncomingTextMessage(const message::TextMessage& message,
     peer::UserPeer me{ to.host, to.port, config->get(config::ConfigField::PUBLIC_KEY) };
     message::TextMessageResponse responseMessage = message::TextMessageResponse::create(me, from);
 
-    json jData;
-    responseMessage.serialize(jData);
-
-    response = jData.dump();
+    response = responseMessage.toWire(message.getWireFormat());
 }
 
 void ChatService::handleOutgoingTextMessage(const message::TextMessageResponse&) {}
@@ -136,27 +297,21 @@ void ChatService::handleIncomingPeerListMessage(const message::PeerListMessage&
     const message::PeerListMessagePayload& payload = message.getPayload();
     std::vector<peer::UserPeer> peers;
 
-    for (size_t i = payload.start; i < payload.start + payload.count; i++)
+    // one table for the whole batch, peers connecting meanwhile do not shift the indexes
+    std::shared_ptr<const peer::PeerTable> table = peerService->getPeerTable();
+    size_t end = std::min(static_cast<size_t>(payload.start) + payload.count, table->peers.size());
+    for (size_t i = payload.start; i < end; i++)
     {
-        try
-        {
-            peer::UserPeer peer = peerService->getPeer(i);
-            if (peer == from) continue;
+        const peer::UserPeer& peer = table->peers[i];
+        if (peer == from) continue;
 
-            peers.push_back(peer);
-        }
-        catch (const std::out_of_range&)
-        {
-            break;
-        }
+        peers.push_back(peer);
     }
 
     message::PeerListMessageResponse responseMessage =
         message::PeerListMessageResponse::create(to, from, peers);
 
-    json jData;
-    responseMessage.serialize(jData);
-    response = jData.dump();
+    response = responseMessage.toWire(message.getWireFormat());
 }
 
 void ChatService::handleOutgoingPeerListMessage(const message::PeerListMessageResponse& response)
@@ -178,14 +333,12 @@ void ChatService::handleIncomingDisconnectionMessage(const message::Disconnectio
     peer::UserPeer to = message.getTo();
 
     peerService->removePeer(from);
+    crypto->forgetSessionKeys(crypto->stringToKey(from.publicKey));  // wipe keys of gone peers
 
     message::DisconnectionMessageResponse responseMessage =
         message::DisconnectionMessageResponse::create(to, from);
 
-    json jData;
-    responseMessage.serialize(jData);
-
-    response = jData.dump();
+    response = responseMessage.toWire(message.getWireFormat());
     consoleUI->printLog("[SERVER] removed peer " + from.host + ":" + std::to_string(from.port) +
                         "\n");
 }
@@ -198,14 +351,14 @@ void ChatService::handleIncomingBlockRangeMessage(const message::BlockRangeMessa
     peer::UserPeer to = message.getTo();
 
     std::vector<blockchain::Block> blocks;
-    blockchainService->getBlocksByIndexRange(
-        payload.start, payload.count, payload.lastHash, blocks);
+    blockchain::Hash lastHash;
+    if (blockchain::hashFromHex(payload.lastHash, lastHash))
+        blockchainService->getBlocksByIndexRange(payload.start, payload.count, lastHash, blocks);
 
     message::BlockRangeMessageResponse responseMessage =
         message::BlockRangeMessageResponse::create(to, from, blocks);
-    json jData;
-    responseMessage.serialize(jData);
-    response = jData.dump();
+
+    response = responseMessage.toWire(message.getWireFormat());
 }
 
 void ChatService::handleOutgoingBlockRangeMessage(
@@ -236,51 +389,36 @@ ChatService::ChatService(const std::shared_ptr<config::IConfig>& config,
       messageService(messageService),
       consoleUI(consoleUI)
 {
+    wireVersion = config->get(config::ConfigField::WIRE_FORMAT) == "json" ? 0
+                                                                          : message::WIRE_VERSION;
+}
+
+uint8_t ChatService::getWireVersion() const { return wireVersion; }
+
+void ChatService::routeIncoming(const Received& received, std::string& response)
+{
+    IncomingRoute route = INCOMING_ROUTES[static_cast<size_t>(received.type)];
+    if (!route)
+    {
+        response = R"({"type":"ERROR_RESPONSE","error":"Invalid message type"})";
+        return;
+    }
+
+    route(*this, received, response);
 }
 
 void ChatService::handleIncomingMessage(const json& jMessage, std::string& response)
+{
+    handleIncomingMessage(std::string_view(), jMessage, response);
+}
+
+void ChatService::handleIncomingMessage(std::string_view text,
+                                        const json& jMessage,
+                                        std::string& response)
 {
     try
     {
-        if (jMessage["type"] ==
-            message::Message::fromMessageTypeToString(message::MessageType::CONNECT))
-        {
-            message::ConnectionMessage message(jMessage);
-            handleIncomingConnectionMessage(message, response);
-        }
-        else if (jMessage["type"] ==
-                 message::Message::fromMessageTypeToString(message::MessageType::TEXT_MESSAGE))
-        {
-            message::TextMessage message(
-                jMessage, config->get(config::ConfigField::PRIVATE_KEY), crypto);
-            handleIncomingTextMessage(message, jMessage.dump(), response);
-        }
-        else if (jMessage["type"] ==
-                 message::Message::fromMessageTypeToString(message::MessageType::PEER_LIST))
-        {
-            message::PeerListMessage message(jMessage);
-            handleIncomingPeerListMessage(message, response);
-        }
-        else if (jMessage["type"] == message::Message::fromMessageTypeToString(
-                                         message::MessageType::BLOCK_RANGE_REQUEST))
-        {
-            message::BlockRangeMessage message(jMessage);
-            handleIncomingBlockRangeMessage(message, response);
-        }
-        else if (jMessage["type"] ==
-                 message::Message::fromMessageTypeToString(message::MessageType::DISCONNECT))
-        {
-            message::DisconnectionMessage message(jMessage);
-            handleIncomingDisconnectionMessage(message, response);
-        }
-        else if (jMessage["type"] == message::Message::fromMessageTypeToString(
-                                         message::MessageType::BLOCKCHAIN_ERROR_RESPONSE))
-        {
-            message::BlockchainErrorMessageResponse message(jMessage);
-            handleOutgoingBlockchainErrorMessage(message);
-        }
-        else
-            response = R"({"type":"ERROR_RESPONSE","error":"Invalid message type"})";
+        routeIncoming(Received(jMessage, text), response);
     }
     catch (json::exception& error)
     {
@@ -292,54 +430,35 @@ void ChatService::handleIncomingMessage(const json& jMessage, std::string& respo
     }
 }
 
+void ChatService::handleIncomingBinaryMessage(std::string_view frame, std::string& response)
+{
+    try
+    {
+        routeIncoming(Received(frame), response);
+    }
+    catch (utils::BinaryFormatError& error)
+    {
+        response = R"({"type":"ERROR_RESPONSE","error":"Invalid data format"})";
+    }
+    catch (std::exception& error)
+    {
+        consoleUI->printLog("[SERVER] handle incoming message error: " +
+                            std::string(error.what()) + "\n");
+        handleIncomingBinaryErrorMessage(frame, response);
+    }
+}
+
 void ChatService::handleOutgoingMessage(const std::string& response)
 {
     try
     {
-        json jData = json::parse(response);
+        json jData;
+        bool binary = message::Message::isBinaryFrame(response);
+        if (!binary) jData = json::parse(response);
 
-        if (jData["type"] ==
-            message::Message::fromMessageTypeToString(message::MessageType::ERROR_RESPONSE))
-        {
-            message::ErrorMessageResponse response(jData);
-            handleOutgoingErrorMessage(response);
-        }
-        if (jData["type"] == message::Message::fromMessageTypeToString(
-                                 message::MessageType::BLOCKCHAIN_ERROR_RESPONSE))
-        {
-            message::BlockchainErrorMessageResponse response(jData);
-            handleOutgoingBlockchainErrorMessage(response);
-        }
-        if (jData["type"] ==
-            message::Message::fromMessageTypeToString(message::MessageType::CONNECT_RESPONSE))
-        {
-            message::ConnectionMessageResponse response(jData);
-            handleOutgoingConnectionMessage(response);
-        }
-        else if (jData["type"] == message::Message::fromMessageTypeToString(
-                                      message::MessageType::TEXT_MESSAGE_RESPONSE))
-        {
-            message::TextMessageResponse response(jData);
-            handleOutgoingTextMessage(response);
-        }
-        else if (jData["type"] == message::Message::fromMessageTypeToString(
-                                      message::MessageType::PEER_LIST_RESPONSE))
-        {
-            message::PeerListMessageResponse response(jData);
-            handleOutgoingPeerListMessage(response);
-        }
-        else if (jData["type"] == message::Message::fromMessageTypeToString(
-                                      message::MessageType::BLOCK_RANGE_RESPONSE))
-        {
-            message::BlockRangeMessageResponse response(jData);
-            handleOutgoingBlockRangeMessage(response);
-        }
-        else if (jData["type"] == message::Message::fromMessageTypeToString(
-                                      message::MessageType::DISCONNECT_RESPONSE))
-        {
-            message::DisconnectionMessageResponse response(jData);
-            handleOutgoingDisconnectionMessage(response);
-        }
+        Received received = binary ? Received(std::string_view(response)) : Received(jData);
+        OutgoingRoute route = OUTGOING_ROUTES[static_cast<size_t>(received.type)];
+        if (route) route(*this, received);
     }
     catch (std::exception& error)
     {
@@ -347,4 +466,4 @@ void ChatService::handleOutgoingMessage(const std::string& response)
                             "\n");
     }
 }
-}  // namespace chat
\ No newline at end of file
+}  // namespace chat
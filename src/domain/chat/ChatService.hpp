@@ -1,8 +1,10 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <nlohmann/json.hpp>
 #include <string>
+#include <string_view>
 
 #include "BlockRangeMessage.hpp"
 #include "BlockchainErrorMessage.hpp"
@@ -31,11 +33,32 @@ private:
     std::shared_ptr<blockchain::BlockchainService> blockchainService;
     std::shared_ptr<message::MessageService> messageService;
     std::shared_ptr<ui::ConsoleUI> consoleUI;
+    uint8_t wireVersion;
+
+    // a received message in either wire format, decoded into its class by the route
+    class Received;
+    using IncomingRoute = void (*)(ChatService& service,
+                                   const Received& received,
+                                   std::string& response);
+    using OutgoingRoute = void (*)(ChatService& service, const Received& received);
+
+    // handlers by message type, a type without a route is not accepted on that side
+    static const std::array<IncomingRoute, message::MESSAGE_TYPE_COUNT> INCOMING_ROUTES;
+    static const std::array<OutgoingRoute, message::MESSAGE_TYPE_COUNT> OUTGOING_ROUTES;
+
+    template <typename Request, void (ChatService::*Handle)(const Request&, std::string&)>
+    static void serve(ChatService& service, const Received& received, std::string& response);
+    template <typename Response, void (ChatService::*Handle)(const Response&)>
+    static void accept(ChatService& service, const Received& received);
+
+    void routeIncoming(const Received& received, std::string& response);
 
 protected:
     void handleIncomingErrorMessage(const json& jData,
                                     const std::string& error,
                                     std::string& response);
+    // the error text is fixed, the exception behind it is only logged
+    void handleIncomingBinaryErrorMessage(std::string_view frame, std::string& response);
     void handleOutgoingBlockchainErrorMessage(
         const message::BlockchainErrorMessageResponse& response);
     void handleOutgoingErrorMessage(const message::ErrorMessageResponse& response);
@@ -64,9 +87,16 @@ public:
                 const std::shared_ptr<message::MessageService>& messageService,
                 const std::shared_ptr<ui::ConsoleUI>& consoleUI);
 
+    // highest binary format offered in CONNECT, 0 when the config asks for JSON only
+    uint8_t getWireVersion() const;
+
     // server side handle request
     void handleIncomingMessage(const json& jMessage, std::string& response);
-    // client side handle response
+    // same, with the text jMessage was parsed from, text messages are stored as that text
+    void handleIncomingMessage(std::string_view text, const json& jMessage, std::string& response);
+    // server side handle request in the binary format, the response is binary too
+    void handleIncomingBinaryMessage(std::string_view frame, std::string& response);
+    // client side handle response, in either format
     void handleOutgoingMessage(const std::string& response);
 };
 }  // namespace chat
\ No newline at end of file
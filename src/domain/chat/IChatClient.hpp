@@ -11,6 +11,8 @@ public:
 
     virtual void connectToAllPeers() = 0;
     virtual void sendMessage(const message::Message& message) = 0;
+    // returns the raw response instead of handing it to ChatService
+    virtual bool requestMessage(const message::Message& message, std::string& response) = 0;
     virtual void sendSecretMessage(const message::SecretMessage& message) = 0;
     virtual void disconnect() = 0;
 };
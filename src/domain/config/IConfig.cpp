@@ -16,6 +16,10 @@ std::string IConfig::configFieldToString(ConfigField key)
             return "public_key";
         case ConfigField::PRIVATE_KEY:
             return "private_key";
+        case ConfigField::SERVER_WORKERS:
+            return "server_workers";
+        case ConfigField::WIRE_FORMAT:
+            return "wire_format";
     }
 
     throw std::runtime_error("Unknown config field");
@@ -31,6 +35,10 @@ ConfigField IConfig::stringToConfigField(const std::string& key)
         return ConfigField::PUBLIC_KEY;
     else if (key == "private_key")
         return ConfigField::PRIVATE_KEY;
+    else if (key == "server_workers")
+        return ConfigField::SERVER_WORKERS;
+    else if (key == "wire_format")
+        return ConfigField::WIRE_FORMAT;
 
     throw std::runtime_error("Unknown config field");
 }
@@ -13,12 +13,21 @@ enum class ConfigField
     PORT,
     PUBLIC_KEY,
     PRIVATE_KEY,
+    SERVER_WORKERS,
+    WIRE_FORMAT,
 };
 
+// required fields, a config without any of them is invalid
 const std::array<ConfigField, 4> CONFIG_FIELDS = {
     ConfigField::HOST, ConfigField::PORT, ConfigField::PUBLIC_KEY, ConfigField::PRIVATE_KEY
 };
 
+// "0" means one worker per hardware thread
+constexpr const char* DEFAULT_SERVER_WORKERS = "0";
+// "binary" offers the binary wire format to peers that support it, "json" keeps every message
+// readable for debugging
+constexpr const char* DEFAULT_WIRE_FORMAT = "binary";
+
 class IConfig
 {
 public:
@@ -1,9 +1,45 @@
 #include "Message.hpp"
 
+#include <array>
 #include <stdexcept>
+#include <unordered_map>
+
+#include "binary.hpp"
 
 namespace message
 {
+// "type" values of JSON messages, indexed by MessageType
+constexpr std::array<std::string_view, MESSAGE_TYPE_COUNT> MESSAGE_TYPE_NAMES = {
+    "NONE",
+    "ERROR_RESPONSE",
+    "BLOCKCHAIN_ERROR_RESPONSE",
+    "CONNECT",
+    "CONNECT_RESPONSE",
+    "PEER_LIST",
+    "PEER_LIST_RESPONSE",
+    "BLOCK_RANGE_REQUEST",
+    "BLOCK_RANGE_RESPONSE",
+    "TEXT_MESSAGE",
+    "TEXT_MESSAGE_RESPONSE",
+    "DISCONNECT",
+    "DISCONNECT_RESPONSE",
+};
+
+// magic, version and type, the start of every binary frame
+static MessageType readFrameStart(utils::BinaryReader& reader)
+{
+    if (reader.readByte() != WIRE_MAGIC) throw utils::BinaryFormatError("Not a binary frame");
+
+    uint8_t version = reader.readByte();
+    if (version == 0 || version > WIRE_VERSION)
+        throw utils::BinaryFormatError("Unsupported wire version");
+
+    uint8_t type = reader.readByte();
+    if (type >= MESSAGE_TYPE_COUNT) throw utils::BinaryFormatError("Unknown message type");
+
+    return static_cast<MessageType>(type);
+}
+
 json Message::getBasicSerialization() const
 {
     json jData;
@@ -17,6 +53,24 @@ json Message::getBasicSerialization() const
     return jData;
 }
 
+void Message::encodePayload(utils::BinaryWriter&) const {}
+
+void Message::encodePeer(utils::BinaryWriter& writer, const peer::UserPeer& peer)
+{
+    writer.writeString(peer.host);
+    writer.writeUint16(peer.port);
+    writer.writeBase64String(peer.publicKey);
+}
+
+peer::UserPeer Message::decodePeer(utils::BinaryReader& reader)
+{
+    peer::UserPeer peer;
+    peer.host = reader.readString();
+    peer.port = reader.readUint16();
+    peer.publicKey = reader.readBase64String();
+    return peer;
+}
+
 Message::Message() : id(""), type(MessageType::NONE), from(), to(), timestamp(0) {}
 
 Message::Message(const std::string& id,
@@ -28,13 +82,51 @@ Message::Message(const std::string& id,
 {
 }
 
+// at() throws on a missing field, operator[] on a const object would read past the end
 Message::Message(const json& jData)
+    : id(jData.at("id").get<std::string>()),
+      type(fromStringToMessageType(jData.at("type").get_ref<const std::string&>())),
+      from(jData.at("from")),
+      to(jData.at("to")),
+      timestamp(jData.at("timestamp").get<uint64_t>())
+{
+}
+
+Message::Message(utils::BinaryReader& reader) : format(WireFormat::BINARY)
+{
+    type = readFrameStart(reader);
+    id = reader.readString();
+    from = decodePeer(reader);
+    to = decodePeer(reader);
+    timestamp = reader.readVarint();
+}
+
+void Message::encode(std::string& out) const
 {
-    id = jData["id"];
-    from = peer::UserPeer(jData["from"]);
-    to = peer::UserPeer(jData["to"]);
-    timestamp = jData["timestamp"].get<uint64_t>();
-    type = Message::fromStringToMessageType(jData["type"].get<std::string>());
+    utils::BinaryWriter writer(out);
+
+    writer.writeByte(WIRE_MAGIC);
+    writer.writeByte(WIRE_VERSION);
+    writer.writeByte(static_cast<uint8_t>(type));
+    writer.writeString(id);
+    encodePeer(writer, from);
+    encodePeer(writer, to);
+    writer.writeVarint(timestamp);
+    encodePayload(writer);
+}
+
+std::string Message::toWire(WireFormat format) const
+{
+    std::string out;
+    if (format == WireFormat::BINARY)
+    {
+        encode(out);
+        return out;
+    }
+
+    json jData;
+    serialize(jData);
+    return jData.dump();
 }
 
 const std::string& Message::getId() const { return id; }
@@ -47,58 +139,68 @@ const peer::UserPeer& Message::getTo() const { return to; }
 
 uint64_t Message::getTimestamp() const { return timestamp; }
 
+WireFormat Message::getWireFormat() const { return format; }
+
 std::string Message::fromMessageTypeToString(MessageType type)
 {
-    switch (type)
-    {
-        case MessageType::NONE:
-            return "NONE";
-        case MessageType::ERROR_RESPONSE:
-            return "ERROR_RESPONSE";
-        case MessageType::BLOCKCHAIN_ERROR_RESPONSE:
-            return "BLOCKCHAIN_ERROR_RESPONSE";
-        case MessageType::CONNECT:
-            return "CONNECT";
-        case MessageType::CONNECT_RESPONSE:
-            return "CONNECT_RESPONSE";
-        case MessageType::PEER_LIST:
-            return "PEER_LIST";
-        case MessageType::PEER_LIST_RESPONSE:
-            return "PEER_LIST_RESPONSE";
-        case MessageType::BLOCK_RANGE_REQUEST:
-            return "BLOCK_RANGE_REQUEST";
-        case MessageType::BLOCK_RANGE_RESPONSE:
-            return "BLOCK_RANGE_RESPONSE";
-        case MessageType::TEXT_MESSAGE:
-            return "TEXT_MESSAGE";
-        case MessageType::TEXT_MESSAGE_RESPONSE:
-            return "TEXT_MESSAGE_RESPONSE";
-        case MessageType::DISCONNECT:
-            return "DISCONNECT";
-        case MessageType::DISCONNECT_RESPONSE:
-            return "DISCONNECT_RESPONSE";
-    }
+    size_t index = static_cast<size_t>(type);
+    if (index >= MESSAGE_TYPE_COUNT) throw std::runtime_error("Unknown message type");
 
-    throw std::runtime_error("Unknown message type");
+    return std::string(MESSAGE_TYPE_NAMES[index]);
 }
 
 MessageType Message::fromStringToMessageType(const std::string& type)
 {
-    if (type == "NONE") return MessageType::NONE;
-    if (type == "ERROR_RESPONSE") return MessageType::ERROR_RESPONSE;
-    if (type == "BLOCKCHAIN_ERROR_RESPONSE") return MessageType::BLOCKCHAIN_ERROR_RESPONSE;
-    if (type == "CONNECT") return MessageType::CONNECT;
-    if (type == "CONNECT_RESPONSE") return MessageType::CONNECT_RESPONSE;
-    if (type == "PEER_LIST") return MessageType::PEER_LIST;
-    if (type == "PEER_LIST_RESPONSE") return MessageType::PEER_LIST_RESPONSE;
-    if (type == "BLOCK_RANGE_REQUEST") return MessageType::BLOCK_RANGE_REQUEST;
-    if (type == "BLOCK_RANGE_RESPONSE") return MessageType::BLOCK_RANGE_RESPONSE;
-    if (type == "TEXT_MESSAGE") return MessageType::TEXT_MESSAGE;
-    if (type == "TEXT_MESSAGE_RESPONSE") return MessageType::TEXT_MESSAGE_RESPONSE;
-    if (type == "DISCONNECT") return MessageType::DISCONNECT;
-    if (type == "DISCONNECT_RESPONSE") return MessageType::DISCONNECT_RESPONSE;
+    MessageType messageType;
+    if (!findMessageType(type, messageType)) throw std::runtime_error("Unknown message type");
 
-    throw std::runtime_error("Unknown message type");
+    return messageType;
+}
+
+bool Message::findMessageType(std::string_view name, MessageType& type)
+{
+    static const std::unordered_map<std::string_view, MessageType> TYPES_BY_NAME = []()
+    {
+        std::unordered_map<std::string_view, MessageType> types;
+        for (size_t i = 0; i < MESSAGE_TYPE_COUNT; ++i)
+            types.emplace(MESSAGE_TYPE_NAMES[i], static_cast<MessageType>(i));
+        return types;
+    }();
+
+    auto it = TYPES_BY_NAME.find(name);
+    if (it == TYPES_BY_NAME.end()) return false;
+
+    type = it->second;
+    return true;
+}
+
+bool Message::isBinaryFrame(std::string_view data)
+{
+    return !data.empty() && static_cast<uint8_t>(data[0]) == WIRE_MAGIC;
+}
+
+MessageType Message::peekBinaryType(std::string_view data)
+{
+    utils::BinaryReader reader(data);
+    return readFrameStart(reader);
+}
+
+peer::UserPeer Message::peekBinarySender(std::string_view data)
+{
+    utils::BinaryReader reader(data);
+    readFrameStart(reader);
+    reader.readRaw(reader.readVarint());  // id
+    return decodePeer(reader);
+}
+
+MessageType Message::skipBinaryHeader(utils::BinaryReader& reader)
+{
+    MessageType type = readFrameStart(reader);
+    reader.readRaw(reader.readVarint());  // id
+    decodePeer(reader);
+    decodePeer(reader);
+    reader.readVarint();  // timestamp
+    return type;
 }
 
 void SecretMessage::serialize(json&) const
@@ -107,6 +209,11 @@ void SecretMessage::serialize(json&) const
         "This method is not accessible. SecretMessage requires session key for serialization");
 }
 
+void SecretMessage::encodePayload(utils::BinaryWriter&) const
+{
+    throw std::logic_error("Secret messages are stored as they were sent, so they stay JSON");
+}
+
 json SecretMessage::getBasicSerialization() const
 {
     json jData = Message::getBasicSerialization();
@@ -130,8 +237,8 @@ SecretMessage::SecretMessage(const std::string& id,
 SecretMessage::SecretMessage(const json& jData, const std::shared_ptr<crypto::ICrypto>& crypto)
     : Message(jData)
 {
-    signature = crypto->stringToKey(jData["signature"].get<std::string>());
-    blockHash = jData["blockHash"].get<std::string>();
+    signature = crypto->stringToKey(jData.at("signature").get_ref<const std::string&>());
+    blockHash = jData.at("blockHash").get<std::string>();
 }
 const crypto::Bytes& SecretMessage::getSignature() const { return signature; }
 
@@ -2,14 +2,33 @@
 
 #include <nlohmann/json.hpp>
 #include <string>
+#include <string_view>
 
 #include "ICrypto.hpp"
 #include "UserPeer.hpp"
 
+namespace utils
+{
+class BinaryWriter;
+class BinaryReader;
+}  // namespace utils
+
 namespace message
 {
 using json = nlohmann::json;
 
+// binary frames start with a zero byte, JSON ones with '{'
+constexpr uint8_t WIRE_MAGIC = 0x00;
+// highest binary format this build speaks, 0 means JSON only
+constexpr uint8_t WIRE_VERSION = 1;
+
+enum class WireFormat
+{
+    JSON,
+    BINARY,
+};
+
+// the values are sent in binary frames, new types go at the end
 enum class MessageType
 {
     NONE,
@@ -27,16 +46,24 @@ enum class MessageType
     DISCONNECT_RESPONSE,
 };
 
+constexpr size_t MESSAGE_TYPE_COUNT = static_cast<size_t>(MessageType::DISCONNECT_RESPONSE) + 1;
+
 class Message
 {
 protected:
     virtual json getBasicSerialization() const;
+    // fields after the common header, nothing by default
+    virtual void encodePayload(utils::BinaryWriter& writer) const;
+
+    static void encodePeer(utils::BinaryWriter& writer, const peer::UserPeer& peer);
+    static peer::UserPeer decodePeer(utils::BinaryReader& reader);
 
     std::string id;
     MessageType type;
     peer::UserPeer from;
     peer::UserPeer to;
     uint64_t timestamp;
+    WireFormat format = WireFormat::JSON;
 
 public:
     Message();
@@ -46,23 +73,42 @@ public:
             const peer::UserPeer& to,
             uint64_t timestamp);
     Message(const json& jData);
+    // reads the header of a binary frame, subclasses read their payload after it
+    Message(utils::BinaryReader& reader);
     virtual ~Message() = default;
     virtual void serialize(json& jData) const = 0;
+    // appends the binary frame of this message to out
+    void encode(std::string& out) const;
+    // text for the wire, responses use the format of the request they answer
+    std::string toWire(WireFormat format) const;
 
     const std::string& getId() const;
     MessageType getType() const;
     const peer::UserPeer& getFrom() const;
     const peer::UserPeer& getTo() const;
     uint64_t getTimestamp() const;
+    // format the message was received in
+    WireFormat getWireFormat() const;
 
     static std::string fromMessageTypeToString(MessageType type);
     static MessageType fromStringToMessageType(const std::string& type);
+    // false for names that are not a message type
+    static bool findMessageType(std::string_view name, MessageType& type);
+
+    static bool isBinaryFrame(std::string_view data);
+    // type of a binary frame without decoding it, throws if the frame has no valid header
+    static MessageType peekBinaryType(std::string_view data);
+    // sender of a binary frame without decoding the payload, throws if the header is invalid
+    static peer::UserPeer peekBinarySender(std::string_view data);
+    // reads the common header of a binary frame and returns its type, the payload comes next
+    static MessageType skipBinaryHeader(utils::BinaryReader& reader);
 };
 
 class SecretMessage : public Message
 {
 private:
     void serialize(json& jData) const final;
+    void encodePayload(utils::BinaryWriter& writer) const final;
 
 protected:
     crypto::Bytes signature;
@@ -45,8 +45,10 @@ void MessageService::findInvalidChatMessageIDs(const std::vector<TextMessage>& m
             continue;
         }
 
+        blockchain::Hash hash;
         blockchain::Block block;
-        if (!blockchainService->findBlockByHash(blockHash, block))
+        if (!blockchain::hashFromHex(blockHash, hash) ||
+            !blockchainService->findBlockByHash(hash, block))
         {
             invalidIds.push_back(message.getId());
             continue;
@@ -1,13 +1,14 @@
 #include "PeerService.hpp"
 
-#include <algorithm>
-#include <iostream>
+#include <stdexcept>
+
+#include "sha256.hpp"
 
 namespace peer
 {
 PeerService::PeerService(std::vector<std::string>& hosts,
                          const std::shared_ptr<IPeerRepo>& peerRepo)
-    : peerRepo(peerRepo)
+    : table(std::make_shared<PeerTable>()), peerRepo(peerRepo)
 {
     for (const std::string& trustedPeer : hosts)
     {
@@ -24,50 +25,103 @@ PeerService::PeerService(std::vector<std::string>& hosts,
 
 const std::vector<UserHost>& PeerService::getHosts() const { return hosts; }
 
-std::vector<UserPeer> PeerService::getPeers() const
+std::shared_ptr<const PeerTable> PeerService::getPeerTable() const
 {
-    std::lock_guard<std::mutex> lock(mutex);
-    return peers;
+    return std::atomic_load(&table);
 }
 
-int PeerService::getPeersCount() const
+std::vector<UserPeer> PeerService::getPeers() const { return getPeerTable()->peers; }
+
+int PeerService::getPeersCount() const { return getPeerTable()->peers.size(); }
+
+UserPeer PeerService::getPeer(size_t index) const { return getPeerTable()->peers.at(index); }
+
+UserPeer PeerService::findPeer(const UserHost& host) const
 {
-    std::lock_guard<std::mutex> lock(mutex);
-    return peers.size();
+    std::shared_ptr<const PeerTable> current = getPeerTable();
+    auto it = current->byHost.find(host);
+
+    if (it != current->byHost.end())
+        return current->peers[it->second];
+    else
+        throw std::range_error("Peer not found");
 }
 
-UserPeer PeerService::getPeer(size_t index) const
+bool PeerService::findPeerByPublicKey(const std::string& publicKey, UserPeer& peer) const
 {
-    std::lock_guard<std::mutex> lock(mutex);
-    return peers.at(index);
+    std::shared_ptr<const PeerTable> current = getPeerTable();
+    auto it = current->byKey.find(utils::sha256Digest(publicKey));
+    if (it == current->byKey.end()) return false;
+
+    peer = current->peers[it->second];
+    return true;
 }
 
-UserPeer PeerService::findPeer(const UserHost& host) const
+void PeerService::publish(std::vector<UserPeer> peers, std::vector<KeyFingerprint> fingerprints)
 {
-    std::lock_guard<std::mutex> lock(mutex);
-    auto it = std::find_if(peers.begin(),
-                           peers.end(),
-                           [&host](const UserPeer& peer)
-                           { return peer.host == host.host && peer.port == host.port; });
+    auto next = std::make_shared<PeerTable>();
+    next->peers = std::move(peers);
+    next->fingerprints = std::move(fingerprints);
 
-    if (it != peers.end())
-        return *it;
-    else
-        throw std::range_error("Peer not found");
+    for (size_t i = 0; i < next->peers.size(); ++i)
+    {
+        next->byHost.emplace(next->peers[i], i);
+        next->byKey.emplace(next->fingerprints[i], i);
+    }
+
+    std::atomic_store(&table, std::shared_ptr<const PeerTable>(std::move(next)));
 }
 
 void PeerService::addPeer(const UserPeer& peer)
 {
-    std::lock_guard<std::mutex> lock(mutex);
-    auto it = std::find(peers.begin(), peers.end(), peer);
-    if (it == peers.end()) peers.push_back(peer);
+    std::lock_guard<std::mutex> lock(writeMutex);
+    std::shared_ptr<const PeerTable> current = getPeerTable();
+
+    // CONNECT and PEER_LIST fields are self-reported, a known address keeps its key until that
+    // peer is removed, otherwise anyone could redirect messages to a key of their own
+    if (current->byHost.count(peer) > 0) return;
+
+    std::vector<UserPeer> peers = current->peers;
+    std::vector<KeyFingerprint> fingerprints = current->fingerprints;
+    peers.push_back(peer);
+    fingerprints.push_back(utils::sha256Digest(peer.publicKey));
+
+    publish(std::move(peers), std::move(fingerprints));
 }
 
 void PeerService::removePeer(const UserPeer& peer)
+{
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        std::shared_ptr<const PeerTable> current = getPeerTable();
+
+        auto it = current->byHost.find(peer);
+        if (it != current->byHost.end() && current->peers[it->second].publicKey == peer.publicKey)
+        {
+            std::vector<UserPeer> peers = current->peers;
+            std::vector<KeyFingerprint> fingerprints = current->fingerprints;
+            peers.erase(peers.begin() + it->second);
+            fingerprints.erase(fingerprints.begin() + it->second);
+
+            publish(std::move(peers), std::move(fingerprints));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    wireVersions.erase(peer);  // a peer that comes back negotiates again
+}
+
+void PeerService::setWireVersion(const UserHost& host, uint8_t version)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    wireVersions[host] = version;
+}
+
+uint8_t PeerService::getWireVersion(const UserHost& host) const
 {
     std::lock_guard<std::mutex> lock(mutex);
-    auto it = std::find(peers.begin(), peers.end(), peer);
-    if (it != peers.end()) peers.erase(it);
+    auto it = wireVersions.find(host);
+    return it != wireVersions.end() ? it->second : 0;
 }
 
 void PeerService::getAllChatPeers(std::vector<UserPeer>& peers) { peerRepo->getAllPeers(peers); }
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <array>
+#include <cstring>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "IPeerRepo.hpp"
@@ -9,25 +12,60 @@
 
 namespace peer
 {
+// SHA-256 of a PEM public key
+using KeyFingerprint = std::array<uint8_t, 32>;
+
+struct KeyFingerprintHash
+{
+    size_t operator()(const KeyFingerprint& fingerprint) const
+    {
+        size_t value;
+        std::memcpy(&value, fingerprint.data(), sizeof(value));
+        return value;
+    }
+};
+
+// active peers at one point in time, a published table is never changed
+struct PeerTable
+{
+    std::vector<UserPeer> peers;               // in the order they were added
+    std::vector<KeyFingerprint> fingerprints;  // of peers[i].publicKey
+    std::unordered_map<UserHost, size_t, UserHostHash> byHost;
+    // the first peer with that key, one key may be used on several ports
+    std::unordered_map<KeyFingerprint, size_t, KeyFingerprintHash> byKey;
+};
+
 class PeerService
 {
 private:
     std::vector<UserHost> hosts;
-    std::vector<UserPeer> peers;
+    // readers take the current table without waiting for writers, writers publish a new copy
+    std::shared_ptr<const PeerTable> table;
+    std::mutex writeMutex;
+    // binary format agreed on in CONNECT, peers missing here get JSON
+    std::unordered_map<UserHost, uint8_t, UserHostHash> wireVersions;
     mutable std::mutex mutex;
     std::shared_ptr<peer::IPeerRepo> peerRepo;
 
+    // builds the indexes and swaps the table in, caller holds writeMutex
+    void publish(std::vector<UserPeer> peers, std::vector<KeyFingerprint> fingerprints);
+
 public:
     PeerService(std::vector<std::string>& hosts, const std::shared_ptr<peer::IPeerRepo>& peerRepo);
 
     const std::vector<UserHost>& getHosts() const;
 
+    // the table stays valid and unchanged for as long as it is held
+    std::shared_ptr<const PeerTable> getPeerTable() const;
     std::vector<UserPeer> getPeers() const;
     int getPeersCount() const;
     UserPeer getPeer(size_t index) const;
     UserPeer findPeer(const UserHost& host) const;
+    bool findPeerByPublicKey(const std::string& publicKey, UserPeer& peer) const;
     void addPeer(const UserPeer& peer);
     void removePeer(const UserPeer& peer);
+    void setWireVersion(const UserHost& host, uint8_t version);
+    uint8_t getWireVersion(const UserHost& host) const;
 
     void getAllChatPeers(std::vector<UserPeer>& peers);
     void addChatPeer(const UserPeer& peer);
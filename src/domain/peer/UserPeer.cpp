@@ -6,6 +6,17 @@ UserHost::UserHost() : host(""), port(0) {}
 
 UserHost::UserHost(const std::string& host, unsigned short port) : host(host), port(port) {}
 
+bool UserHost::operator==(const UserHost& other) const
+{
+    return port == other.port && host == other.host;
+}
+
+size_t UserHostHash::operator()(const UserHost& userHost) const
+{
+    return std::hash<std::string>()(userHost.host) ^
+           (std::hash<unsigned short>()(userHost.port) << 1);
+}
+
 UserPeer::UserPeer() : UserHost(), publicKey("") {}
 
 UserPeer::UserPeer(const std::string& host, unsigned short port, const std::string& publicKey)
@@ -14,9 +25,9 @@ UserPeer::UserPeer(const std::string& host, unsigned short port, const std::stri
 }
 
 UserPeer::UserPeer(const json& jData)
-    : UserHost(jData["host"].get<std::string>(), jData["port"].get<unsigned short>())
+    : UserHost(jData.at("host").get<std::string>(), jData.at("port").get<unsigned short>()),
+      publicKey(jData.at("public_key").get<std::string>())
 {
-    publicKey = jData["public_key"].get<std::string>();
 }
 
 json UserPeer::toJson() const
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <nlohmann/json.hpp>
 #include <string>
 
@@ -15,6 +16,13 @@ public:
 
     UserHost();
     UserHost(const std::string& host, unsigned short port);
+
+    bool operator==(const UserHost& other) const;
+};
+
+struct UserHostHash
+{
+    size_t operator()(const UserHost& userHost) const;
 };
 
 class UserPeer : public UserHost
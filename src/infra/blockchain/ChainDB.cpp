@@ -3,8 +3,63 @@
 #include <iostream>
 #include <stdexcept>
 
+#include "base64.hpp"
+
 namespace blockchain
 {
+constexpr const char* SQL_FIND_CHILD_BLOCK = "SELECT 1 FROM blocks WHERE previous_hash=? LIMIT 1;";
+// height is the position in the chain, the new block goes right after the current tip
+constexpr const char* SQL_INSERT_BLOCK =
+    "INSERT INTO blocks(hash, previous_hash, payload_hash, author_public_key, signature, "
+    "timestamp, height) SELECT ?,?,?,?,?,?, COALESCE(MAX(height), -1) + 1 FROM blocks;";
+constexpr const char* SQL_FIND_BLOCK_BY_HASH =
+    "SELECT hash, previous_hash, payload_hash, author_public_key, signature, timestamp "
+    "FROM blocks WHERE hash=? LIMIT 1;";
+constexpr const char* SQL_BLOCKS_FROM_HEIGHT =
+    "SELECT hash, previous_hash, payload_hash, author_public_key, signature, timestamp "
+    "FROM blocks WHERE height >= ? ORDER BY height ASC LIMIT ?;";
+constexpr const char* SQL_BLOCK_HEIGHT_BY_HASH = "SELECT height FROM blocks WHERE hash=? LIMIT 1;";
+constexpr const char* SQL_FIND_TIP =
+    "SELECT hash, previous_hash, payload_hash, author_public_key, signature, timestamp "
+    "FROM blocks ORDER BY height DESC LIMIT 1;";
+constexpr const char* SQL_FIND_TIP_HEIGHT =
+    "SELECT height FROM blocks ORDER BY height DESC LIMIT 1;";
+constexpr const char* SQL_ALL_BLOCK_HEIGHTS = "SELECT hash, height FROM blocks;";
+constexpr const char* SQL_LOAD_ALL_BLOCKS =
+    "SELECT hash, previous_hash, payload_hash, author_public_key, signature, timestamp "
+    "FROM blocks ORDER BY height ASC;";
+constexpr const char* SQL_FIND_CHECKPOINT = "SELECT height, hash FROM chain_checkpoint WHERE id=1;";
+constexpr const char* SQL_SAVE_CHECKPOINT =
+    "INSERT OR REPLACE INTO chain_checkpoint(id, height, hash) VALUES(1, ?, ?);";
+constexpr const char* SQL_CLEAR_CHECKPOINT = "DELETE FROM chain_checkpoint;";
+
+// compiled once in init(), later queries reuse the cached statements
+constexpr const char* PREPARED_STATEMENTS[] = {
+    SQL_FIND_CHILD_BLOCK,
+    SQL_INSERT_BLOCK,
+    SQL_FIND_BLOCK_BY_HASH,
+    SQL_BLOCKS_FROM_HEIGHT,
+    SQL_BLOCK_HEIGHT_BY_HASH,
+    SQL_FIND_TIP,
+    SQL_FIND_TIP_HEIGHT,
+    SQL_ALL_BLOCK_HEIGHTS,
+    SQL_LOAD_ALL_BLOCKS,
+    SQL_FIND_CHECKPOINT,
+    SQL_SAVE_CHECKPOINT,
+    SQL_CLEAR_CHECKPOINT,
+};
+
+// columns in the order of the block selects above, the table keeps the hex and base64 forms
+static void readBlock(const db::Row& row, Block& block)
+{
+    hashFromHex(row.getText(0), block.hash);
+    hashFromHex(row.getText(1), block.previousHash);
+    hashFromHex(row.getText(2), block.payloadHash);
+    utils::fromBase64(row.getText(3), block.authorPublicKey);
+    utils::fromBase64(row.getText(4), block.signature);
+    block.timestamp = static_cast<uint64_t>(row.getInt64(5));
+}
+
 ChainDB::ChainDB(const std::shared_ptr<db::DBFile>& db,
                  const std::shared_ptr<config::IConfig>& config,
                  const std::shared_ptr<crypto::ICrypto>& crypto)
@@ -24,224 +79,254 @@ void ChainDB::init()
             payload_hash TEXT NOT NULL,
             author_public_key TEXT NOT NULL,
             signature TEXT NOT NULL,
-            timestamp INTEGER NOT NULL
+            timestamp INTEGER NOT NULL,
+            height INTEGER NOT NULL
         );
     )");
+    migrateHeights();
+
     db->exec(R"(
         CREATE INDEX IF NOT EXISTS idx_blocks_hash ON blocks(hash);
     )");
+    db->exec(R"(
+        CREATE UNIQUE INDEX IF NOT EXISTS idx_blocks_height ON blocks(height);
+    )");
+    db->exec(R"(
+        CREATE INDEX IF NOT EXISTS idx_blocks_previous_hash ON blocks(previous_hash);
+    )");
+
+    // single row: the chain is known to be valid up to this block
+    db->exec(R"(
+        CREATE TABLE IF NOT EXISTS chain_checkpoint (
+            id INTEGER PRIMARY KEY CHECK (id = 1),
+            height INTEGER NOT NULL,
+            hash TEXT NOT NULL
+        );
+    )");
+
+    for (const char* sql : PREPARED_STATEMENTS) db->prepare(sql);
+
+    loadIndex();
 }
 
-bool ChainDB::insertBlock(const Block& block)
+void ChainDB::loadIndex()
 {
-    if (block.previousHash != "0")
+    index.clear();
+
+    db->selectRows(SQL_ALL_BLOCK_HEIGHTS,
+                   {},
+                   [this](const db::Row& row)
+                   {
+                       Hash hash;
+                       if (hashFromHex(row.getText(0), hash)) index.add(hash, row.getInt64(1));
+                   });
+
+    int64_t tipHeight = 0;
+    db->selectRows(SQL_FIND_TIP_HEIGHT,
+                   {},
+                   [&tipHeight](const db::Row& row) { tipHeight = row.getInt64(0); });
+
+    Block tip;
+    bool found = false;
+    db->selectRows(SQL_FIND_TIP,
+                   {},
+                   [&tip, &found](const db::Row& row)
+                   {
+                       readBlock(row, tip);
+                       found = true;
+                   });
+
+    if (found) index.setTip(tip, tipHeight);
+}
+
+void ChainDB::migrateHeights()
+{
+    bool hasHeight = false;
+    db->selectRows("PRAGMA table_info(blocks);",
+                   {},
+                   [&hasHeight](const db::Row& row)
+                   {
+                       if (row.getText(1) == "height") hasHeight = true;
+                   });
+
+    if (hasHeight) return;
+
+    // databases created before the height column used the insertion order (id) as height
+    db::DBFile::Transaction transaction(*db);
+    db->exec("ALTER TABLE blocks ADD COLUMN height INTEGER NOT NULL DEFAULT -1;");
+
+    std::vector<int64_t> ids;
+    db->selectRows("SELECT id FROM blocks ORDER BY id ASC;",
+                   {},
+                   [&ids](const db::Row& row) { ids.push_back(row.getInt64(0)); });
+
+    for (size_t height = 0; height < ids.size(); ++height)
     {
-        bool found = false;
-        std::string query = "SELECT * FROM blocks WHERE previous_hash = ?";
-        db->selectPrepared("SELECT * FROM blocks WHERE previous_hash = ?",
-                           { block.previousHash },
-                           [&found](const std::vector<std::string>& row)
-                           {
-                               if (!row.empty()) found = true;
-                           });
-
-        if (found) return false;
+        if (!db->executePrepared("UPDATE blocks SET height=? WHERE id=?;",
+                                 { std::to_string(height), std::to_string(ids[height]) }))
+            throw std::runtime_error("ChainDB: failed to migrate block heights");
     }
 
-    return db->executePrepared(
-        "INSERT INTO blocks(hash, previous_hash, payload_hash, author_public_key, signature, "
-        "timestamp)"
-        "VALUES (?,?,?,?,?,?);",
-        {
-            block.hash,
-            block.previousHash,
-            block.payloadHash,
-            block.authorPublicKey,
-            block.signature,
-            std::to_string(block.timestamp),
-        });
+    transaction.commit();
 }
 
-bool ChainDB::findBlockByHash(const std::string& hash, Block& block)
+bool ChainDB::hasChildBlock(const Hash& hash)
 {
     bool found = false;
-
-    db->selectPrepared(
-        "SELECT hash, previous_hash, payload_hash, author_public_key, signature, timestamp "
-        "FROM blocks WHERE hash=? LIMIT 1;",
-        { hash },
-        [&block, &found](const std::vector<std::string>& row)
-        {
-            if (row.size() < 6) return;
-            block.hash = row[0];
-            block.previousHash = row[1];
-            block.payloadHash = row[2];
-            block.authorPublicKey = row[3];
-            block.signature = row[4];
-            block.timestamp = std::stoull(row[5]);
-            found = true;
-        });
+    db->selectRows(
+        SQL_FIND_CHILD_BLOCK, { hashToHex(hash) }, [&found](const db::Row&) { found = true; });
 
     return found;
 }
 
-void ChainDB::getBlocksByIndexRange(u_int start,
-                                    u_int count,
-                                    const std::string& lastHash,
-                                    std::vector<Block>& outBlocks)
+bool ChainDB::writeBlock(const Block& block)
 {
-    if (lastHash == "0")
-    {
-        db->selectPrepared(
-            "SELECT hash, previous_hash, payload_hash, author_public_key, signature, timestamp "
-            "FROM blocks ORDER BY id ASC LIMIT ? OFFSET ?;",
-            { std::to_string(count), std::to_string(start) },
-            [&outBlocks](const std::vector<std::string>& row)
-            {
-                if (row.size() < 6) return;
-                outBlocks.emplace_back(row[0], row[1], row[2], row[3], row[4], std::stoull(row[5]));
-            });
-    }
-    else
-    {
-        uint64_t lastBlockIndex = 0;
-        bool found = false;
-
-        db->selectPrepared("SELECT id FROM blocks WHERE hash=? LIMIT 1;",
-                           { lastHash },
-                           [&lastBlockIndex, &found](const std::vector<std::string>& row)
-                           {
-                               if (!row.empty())
+    return db->executePrepared(SQL_INSERT_BLOCK,
                                {
-                                   lastBlockIndex = std::stoull(row[0]);
-                                   found = true;
-                               }
-                           });
-
-        if (!found) return;
-
-        uint64_t startIndex = lastBlockIndex + 1 + start;
-
-        db->selectPrepared(
-            "SELECT hash, previous_hash, payload_hash, author_public_key, signature, timestamp "
-            "FROM blocks WHERE id >= ? ORDER BY id ASC LIMIT ?;",
-            { std::to_string(startIndex), std::to_string(count) },
-            [&outBlocks](const std::vector<std::string>& row)
-            {
-                if (row.size() < 6) return;
-                outBlocks.emplace_back(row[0], row[1], row[2], row[3], row[4], std::stoull(row[5]));
-            });
-    }
+                                   block.hashHex(),
+                                   hashToHex(block.previousHash),
+                                   hashToHex(block.payloadHash),
+                                   block.authorPublicKeyBase64(),
+                                   block.signatureBase64(),
+                                   std::to_string(block.timestamp),
+                               });
 }
 
-u_int ChainDB::countBlocksAfterHash(const std::string& hash)
+bool ChainDB::insertBlocks(const std::vector<Block>& blocks)
 {
-    if (hash == "0")
-    {
-        u_int count = 0;
-        db->select("SELECT COUNT(*) FROM blocks;",
-                   [&count](const std::vector<std::string>& row)
-                   {
-                       if (!row.empty()) count = std::stoull(row[0]);
-                   });
-        return count;
-    }
+    if (blocks.empty()) return true;
 
-    u_int index = 0;
-    bool exists = false;
+    db::DBFile::Transaction transaction(*db);
 
-    db->selectPrepared("SELECT id FROM blocks WHERE hash=? LIMIT 1;",
-                       { hash },
-                       [&index, &exists](const std::vector<std::string>& row)
-                       {
-                           if (row.empty()) return;
-                           index = std::stoull(row[0]);
-                           exists = true;
-                       });
+    // the rest of the segment links to blocks written here, so only the first can fork
+    if (blocks[0].previousHash != Hash{} && hasChildBlock(blocks[0].previousHash)) return false;
 
-    if (!exists)
+    for (size_t i = 0; i < blocks.size(); ++i)
     {
-        u_int count = 0;
-        db->select("SELECT COUNT(*) FROM blocks;",
-                   [&count](const std::vector<std::string>& row)
-                   {
-                       if (!row.empty()) count = std::stoull(row[0]);
-                   });
-        return count;
+        if (i > 0 && blocks[i].previousHash != blocks[i - 1].hash) return false;
+        if (!writeBlock(blocks[i])) return false;
     }
 
-    u_int missing = 0;
-    db->selectPrepared("SELECT COUNT(*) FROM blocks WHERE id > ?;",
-                       { std::to_string(index) },
-                       [&missing](const std::vector<std::string>& row)
-                       {
-                           if (!row.empty()) missing = std::stoull(row[0]);
-                       });
+    transaction.commit();
 
-    return missing;
+    // the transaction still holds the database lock, so no other insert can come in between
+    for (const auto& block : blocks) index.append(block);
+    return true;
 }
 
-bool ChainDB::findTip(Block& block)
+bool ChainDB::insertBlock(const Block& block)
 {
-    bool found = false;
+    db::DBFile::Transaction transaction(*db);  // no other block can take the parent in between
 
-    db->select(
-        "SELECT hash, previous_hash, payload_hash, author_public_key, signature, timestamp "
-        "FROM blocks ORDER BY id DESC LIMIT 1;",
-        [&block, &found](const std::vector<std::string>& row)
-        {
-            if (row.size() < 6) return;
-            block.hash = row[0];
-            block.previousHash = row[1];
-            block.payloadHash = row[2];
-            block.authorPublicKey = row[3];
-            block.signature = row[4];
-            block.timestamp = std::stoull(row[5]);
-            found = true;
-        });
+    if (block.previousHash != Hash{} && hasChildBlock(block.previousHash)) return false;
+    if (!writeBlock(block)) return false;
 
-    return found;
+    transaction.commit();
+    index.append(block);
+    return true;
 }
 
-bool ChainDB::findTipIndex(u_int& index)
+bool ChainDB::findBlockByHash(const Hash& hash, Block& block)
 {
     bool found = false;
 
-    db->select("SELECT id FROM blocks ORDER BY id DESC LIMIT 1;",
-               [&index, &found](const std::vector<std::string>& row)
-               {
-                   if (row.empty()) return;
-                   index = std::stoull(row[0]);
-                   found = true;
-               });
+    db->selectRows(SQL_FIND_BLOCK_BY_HASH,
+                   { hashToHex(hash) },
+                   [&block, &found](const db::Row& row)
+                   {
+                       readBlock(row, block);
+                       found = true;
+                   });
 
     return found;
 }
 
-bool ChainDB::hasBlock(const std::string& hash)
+void ChainDB::getBlocksByIndexRange(u_int start,
+                                    u_int count,
+                                    const Hash& lastHash,
+                                    std::vector<Block>& outBlocks)
 {
-    bool exists = false;
+    int64_t startHeight = start;
+    if (lastHash != Hash{})
+    {
+        int64_t lastHeight = 0;
+        if (!index.findHeight(lastHash, lastHeight)) return;
 
-    db->selectPrepared("SELECT 1 FROM blocks WHERE hash=? LIMIT 1;",
-                       { hash },
-                       [&exists](const std::vector<std::string>& row)
-                       {
-                           if (!row.empty()) exists = true;
-                       });
+        startHeight += lastHeight + 1;
+    }
 
-    return exists;
+    db->selectRows(SQL_BLOCKS_FROM_HEIGHT,
+                   { std::to_string(startHeight), std::to_string(count) },
+                   [&outBlocks](const db::Row& row)
+                   {
+                       outBlocks.emplace_back();
+                       readBlock(row, outBlocks.back());
+                   });
 }
 
+u_int ChainDB::countBlocksAfterHash(const Hash& hash)
+{
+    int64_t tipHeight = -1;
+    index.findTipHeight(tipHeight);
+
+    int64_t height = -1;  // unknown hash: the whole chain is missing
+    if (hash != Hash{}) index.findHeight(hash, height);
+
+    return static_cast<u_int>(tipHeight - height);
+}
+
+bool ChainDB::findTip(Block& block) { return index.findTip(block); }
+
+bool ChainDB::findTipIndex(u_int& index)
+{
+    int64_t height = 0;
+    if (!this->index.findTipHeight(height)) return false;
+
+    index = static_cast<u_int>(height);
+    return true;
+}
+
+bool ChainDB::hasBlock(const Hash& hash) { return index.contains(hash); }
+
 void ChainDB::loadAllBlocks(std::vector<Block>& blocks)
 {
-    db->select(
-        "SELECT hash, previous_hash, payload_hash, author_public_key, signature, timestamp "
-        "FROM blocks ORDER BY id ASC;",
-        [&blocks](const std::vector<std::string>& row)
-        {
-            if (row.size() < 6) return;
-            blocks.emplace_back(row[0], row[1], row[2], row[3], row[4], std::stoull(row[5]));
-        });
+    db->selectRows(SQL_LOAD_ALL_BLOCKS,
+                   {},
+                   [&blocks](const db::Row& row)
+                   {
+                       blocks.emplace_back();
+                       readBlock(row, blocks.back());
+                   });
 }
 
+bool ChainDB::findCheckpoint(u_int& height, Hash& hash)
+{
+    int64_t checkpointHeight = -1;
+    Hash checkpointHash{};
+    db->selectRows(SQL_FIND_CHECKPOINT,
+                   {},
+                   [&checkpointHeight, &checkpointHash](const db::Row& row)
+                   {
+                       if (hashFromHex(row.getText(1), checkpointHash))
+                           checkpointHeight = row.getInt64(0);
+                   });
+
+    // the blocks table may have been replaced or edited since the checkpoint was saved
+    int64_t indexedHeight = -1;
+    if (checkpointHeight < 0 || !index.findHeight(checkpointHash, indexedHeight) ||
+        indexedHeight != checkpointHeight)
+        return false;
+
+    height = static_cast<u_int>(checkpointHeight);
+    hash = checkpointHash;
+    return true;
+}
+
+void ChainDB::saveCheckpoint(u_int height, const Hash& hash)
+{
+    db->executePrepared(SQL_SAVE_CHECKPOINT, { std::to_string(height), hashToHex(hash) });
+}
+
+void ChainDB::clearCheckpoint() { db->executePrepared(SQL_CLEAR_CHECKPOINT, {}); }
+
 }  // namespace blockchain
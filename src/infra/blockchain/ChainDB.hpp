@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "Block.hpp"
+#include "ChainIndex.hpp"
 #include "DBFile.hpp"
 #include "IChainRepo.hpp"
 #include "IConfig.hpp"
@@ -17,6 +18,14 @@ private:
     std::shared_ptr<config::IConfig> config;
     std::shared_ptr<crypto::ICrypto> crypto;
 
+    // write-through: updated after every committed insert, reloaded by init()
+    ChainIndex index;
+
+    void migrateHeights();
+    void loadIndex();
+    bool hasChildBlock(const Hash& hash);
+    bool writeBlock(const Block& block);
+
 public:
     ChainDB(const std::shared_ptr<db::DBFile>& db,
             const std::shared_ptr<config::IConfig>& config,
@@ -25,16 +34,21 @@ public:
     void init() override;
 
     bool insertBlock(const Block& block) override;
-    bool findBlockByHash(const std::string& hash, Block& block) override;
+    bool insertBlocks(const std::vector<Block>& blocks) override;
+    bool findBlockByHash(const Hash& hash, Block& block) override;
     void getBlocksByIndexRange(u_int start,
                                u_int count,
-                               const std::string& lastHash,
+                               const Hash& lastHash,
                                std::vector<Block>& outBlocks) override;
-    u_int countBlocksAfterHash(const std::string& hash) override;
-    bool hasBlock(const std::string& hash) override;
+    u_int countBlocksAfterHash(const Hash& hash) override;
+    bool hasBlock(const Hash& hash) override;
     void loadAllBlocks(std::vector<Block>& blocks) override;
 
     bool findTip(Block& block) override;
     bool findTipIndex(u_int& index) override;
+
+    bool findCheckpoint(u_int& height, Hash& hash) override;
+    void saveCheckpoint(u_int height, const Hash& hash) override;
+    void clearCheckpoint() override;
 };
 }  // namespace blockchain
@@ -30,6 +30,10 @@ JsonConfig::JsonConfig(const std::string& path, const std::shared_ptr<crypto::IC
             data[IConfig::stringToConfigField(key)] = value.get<std::string>();
         }
     }
+
+    // optional fields
+    data.emplace(ConfigField::SERVER_WORKERS, DEFAULT_SERVER_WORKERS);
+    data.emplace(ConfigField::WIRE_FORMAT, DEFAULT_WIRE_FORMAT);
 }
 
 std::string JsonConfig::get(ConfigField key) const { return data.at(key); }
@@ -73,6 +77,8 @@ void JsonConfig::generatedDefaultConfig()
     jData["port"] = std::to_string(network::SocketClient::findFreePort());
     jData["public_key"] = crypto->keyToString(keyPair.publicKey);
     jData["private_key"] = crypto->keyToString(keyPair.privateKey);
+    jData["server_workers"] = DEFAULT_SERVER_WORKERS;
+    jData["wire_format"] = DEFAULT_WIRE_FORMAT;
     jData["trustedPeerList"] = json::json::array();
 
     jsonFile.writeJson(jData);
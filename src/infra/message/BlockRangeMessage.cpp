@@ -1,10 +1,154 @@
 #include "BlockRangeMessage.hpp"
 
+#include <algorithm>
+
+#include "binary.hpp"
 #include "timestamp.hpp"
 #include "uuid.hpp"
 
 namespace message
 {
+// hashes, key and signature go out as raw bytes instead of hex and base64 text
+static void encodeBlock(utils::BinaryWriter& writer, const blockchain::Block& block)
+{
+    writer.writeRaw(block.hash.data(), block.hash.size());
+    writer.writeRaw(block.previousHash.data(), block.previousHash.size());
+    writer.writeRaw(block.payloadHash.data(), block.payloadHash.size());
+    writer.writeBytes(block.authorPublicKey);
+    writer.writeBytes(block.signature);
+    writer.writeVarint(block.timestamp);
+}
+
+static void decodeHash(utils::BinaryReader& reader, blockchain::Hash& hash)
+{
+    std::string_view bytes = reader.readRaw(hash.size());
+    std::copy(bytes.begin(), bytes.end(), hash.begin());
+}
+
+static void decodeBlock(utils::BinaryReader& reader, blockchain::Block& block)
+{
+    decodeHash(reader, block.hash);
+    decodeHash(reader, block.previousHash);
+    decodeHash(reader, block.payloadHash);
+    block.authorPublicKey = reader.readBytes();
+    block.signature = reader.readBytes();
+    block.timestamp = reader.readVarint();
+}
+
+// count, then the blocks one after another
+static bool readBlocks(utils::BinaryReader& reader, const blockchain::BlockSink& sink)
+{
+    uint64_t count = reader.readVarint();
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        blockchain::Block block;
+        decodeBlock(reader, block);
+        if (!sink(std::move(block))) return false;
+    }
+    return true;
+}
+
+constexpr const char* INVALID_BLOCKS = "Blocks field must be an array of blocks";
+
+// keeps only the block of payload.blocks being read and hands it to the sink when it ends,
+// keys are sorted so "type" comes after the blocks
+class BlockRangeSax : public json::json_sax_t
+{
+private:
+    const blockchain::BlockSink& sink;
+    size_t depth = 0;  // root object is 1, payload 2, blocks 3, a block 4
+    std::string currentKey;
+    bool inPayload = false;
+    bool inBlocks = false;
+    bool inBlock = false;
+    json jBlock;
+
+    bool atBlocksField() const { return depth == 2 && inPayload && currentKey == "blocks"; }
+
+    bool value(json&& jValue)
+    {
+        if (depth == 1 && currentKey == "type" && jValue.is_string())
+            typeName = jValue.get<std::string>();
+        else if (inBlock && depth == 4 && !stopped)
+            jBlock[currentKey] = std::move(jValue);
+        else if ((inBlocks && depth == 3) || atBlocksField())
+            throw std::runtime_error(INVALID_BLOCKS);
+        return true;
+    }
+
+public:
+    std::string typeName;
+    bool foundBlocks = false;
+    bool stopped = false;  // the sink refused a block, the ones after it are skipped
+
+    explicit BlockRangeSax(const blockchain::BlockSink& sink) : sink(sink) {}
+
+    bool null() override { return value(nullptr); }
+    bool boolean(bool val) override { return value(val); }
+    bool number_integer(number_integer_t val) override { return value(val); }
+    bool number_unsigned(number_unsigned_t val) override { return value(val); }
+    bool number_float(number_float_t val, const string_t&) override { return value(val); }
+    bool string(string_t& val) override { return value(std::move(val)); }
+    bool binary(binary_t& val) override { return value(json::binary(std::move(val))); }
+
+    bool key(string_t& val) override
+    {
+        currentKey = std::move(val);
+        return true;
+    }
+
+    bool start_object(std::size_t) override
+    {
+        if (atBlocksField()) throw std::runtime_error(INVALID_BLOCKS);
+
+        ++depth;
+        if (depth == 2 && currentKey == "payload")
+            inPayload = true;
+        else if (depth == 4 && inBlocks)
+        {
+            inBlock = true;
+            jBlock = json::object();
+        }
+        return true;
+    }
+
+    bool end_object() override
+    {
+        if (inBlock && depth == 4)
+        {
+            inBlock = false;
+            if (!stopped && !sink(blockchain::Block(jBlock))) stopped = true;
+        }
+        else if (inPayload && depth == 2)
+            inPayload = false;
+
+        --depth;
+        return true;
+    }
+
+    bool start_array(std::size_t) override
+    {
+        if (inBlocks && depth == 3) throw std::runtime_error(INVALID_BLOCKS);
+
+        bool blocks = atBlocksField();
+        ++depth;
+        if (blocks) inBlocks = foundBlocks = true;
+        return true;
+    }
+
+    bool end_array() override
+    {
+        if (inBlocks && depth == 3) inBlocks = false;
+
+        --depth;
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const json::exception& error) override
+    {
+        throw std::runtime_error(error.what());
+    }
+};
 
 BlockRangeMessage::BlockRangeMessage() : Message(), payload{ 0, 0, "0" } {}
 
@@ -23,9 +167,18 @@ BlockRangeMessage::BlockRangeMessage(const std::string& id,
 BlockRangeMessage::BlockRangeMessage(const json& jData) : Message(jData)
 {
     if (type != MessageType::BLOCK_RANGE_REQUEST) throw std::runtime_error("Invalid message type");
-    payload.start = jData["payload"]["start"].get<uint64_t>();
-    payload.count = jData["payload"]["count"].get<unsigned int>();
-    payload.lastHash = jData["payload"]["lastHash"].get<std::string>();
+    const json& jPayload = jData.at("payload");
+    payload.start = jPayload.at("start").get<uint64_t>();
+    payload.count = jPayload.at("count").get<unsigned int>();
+    payload.lastHash = jPayload.at("lastHash").get<std::string>();
+}
+
+BlockRangeMessage::BlockRangeMessage(utils::BinaryReader& reader) : Message(reader)
+{
+    if (type != MessageType::BLOCK_RANGE_REQUEST) throw std::runtime_error("Invalid message type");
+    payload.start = static_cast<u_int>(reader.readVarint());
+    payload.count = static_cast<u_int>(reader.readVarint());
+    payload.lastHash = reader.readHexString();
 }
 
 void BlockRangeMessage::serialize(json& jData) const
@@ -36,6 +189,13 @@ void BlockRangeMessage::serialize(json& jData) const
     jData["payload"]["lastHash"] = payload.lastHash;
 }
 
+void BlockRangeMessage::encodePayload(utils::BinaryWriter& writer) const
+{
+    writer.writeVarint(payload.start);
+    writer.writeVarint(payload.count);
+    writer.writeHexString(payload.lastHash);
+}
+
 const BlockRangeMessagePayload& BlockRangeMessage::getPayload() const { return payload; }
 
 BlockRangeMessage BlockRangeMessage::create(const peer::UserPeer& from,
@@ -65,12 +225,25 @@ BlockRangeMessageResponse::BlockRangeMessageResponse(const json& jData) : Messag
 
     payload.blocks.clear();
 
-    json blocksJson = jData["payload"]["blocks"];
+    const json& blocksJson = jData.at("payload").at("blocks");
     if (!blocksJson.is_array()) throw std::runtime_error("Peers field must be an array");
 
     for (const auto& jBlock : blocksJson) payload.blocks.emplace_back(jBlock);
 }
 
+BlockRangeMessageResponse::BlockRangeMessageResponse(utils::BinaryReader& reader)
+    : Message(reader), payload()
+{
+    if (type != MessageType::BLOCK_RANGE_RESPONSE) throw std::runtime_error("Invalid message type");
+
+    readBlocks(reader,
+               [this](blockchain::Block&& block)
+               {
+                   payload.blocks.push_back(std::move(block));
+                   return true;
+               });
+}
+
 void BlockRangeMessageResponse::serialize(json& jData) const
 {
     jData = getBasicSerialization();
@@ -82,10 +255,38 @@ void BlockRangeMessageResponse::serialize(json& jData) const
     }
 }
 
+void BlockRangeMessageResponse::encodePayload(utils::BinaryWriter& writer) const
+{
+    writer.writeVarint(payload.blocks.size());
+    for (const auto& block : payload.blocks) encodeBlock(writer, block);
+}
+
 const BlockRangeMessageResponsePayload& BlockRangeMessageResponse::getPayload() const
 {
     return payload;
 }
+
+bool BlockRangeMessageResponse::decodeBlocks(std::string_view frame,
+                                             const blockchain::BlockSink& sink,
+                                             MessageType& type)
+{
+    if (isBinaryFrame(frame))
+    {
+        utils::BinaryReader reader(frame);
+        type = skipBinaryHeader(reader);
+        return type == MessageType::BLOCK_RANGE_RESPONSE && readBlocks(reader, sink);
+    }
+
+    BlockRangeSax handler(sink);
+    json::sax_parse(frame.begin(), frame.end(), &handler);
+
+    if (!findMessageType(handler.typeName, type)) type = MessageType::NONE;
+    if (type != MessageType::BLOCK_RANGE_RESPONSE) return false;
+    if (!handler.foundBlocks) throw std::runtime_error(INVALID_BLOCKS);
+
+    return !handler.stopped;
+}
+
 BlockRangeMessageResponse BlockRangeMessageResponse::create(
     const peer::UserPeer& from,
     const peer::UserPeer& to,
@@ -20,6 +20,7 @@ class BlockRangeMessage : public Message
 {
 protected:
     BlockRangeMessagePayload payload;
+    void encodePayload(utils::BinaryWriter& writer) const override;
 
 public:
     BlockRangeMessage();
@@ -31,6 +32,7 @@ public:
                       u_int count,
                       const std::string& lastHash);
     BlockRangeMessage(const json& jData);
+    BlockRangeMessage(utils::BinaryReader& reader);
 
     void serialize(json& jData) const override;
     const BlockRangeMessagePayload& getPayload() const;
@@ -51,6 +53,7 @@ class BlockRangeMessageResponse : public Message
 {
 protected:
     BlockRangeMessageResponsePayload payload;
+    void encodePayload(utils::BinaryWriter& writer) const override;
 
 public:
     BlockRangeMessageResponse();
@@ -60,6 +63,7 @@ public:
                               uint64_t timestamp,
                               const std::vector<blockchain::Block>& blocks);
     BlockRangeMessageResponse(const json& jData);
+    BlockRangeMessageResponse(utils::BinaryReader& reader);
 
     void serialize(json& jData) const override;
     const BlockRangeMessageResponsePayload& getPayload() const;
@@ -67,5 +71,12 @@ public:
     static BlockRangeMessageResponse create(const peer::UserPeer& from,
                                             const peer::UserPeer& to,
                                             const std::vector<blockchain::Block>& blocks);
+
+    // hands the blocks of a response in either format to sink while it is decoded, without
+    // building the message or a JSON document; true if frame is a BLOCK_RANGE_RESPONSE and
+    // sink took every block, type is set to the type of the frame
+    static bool decodeBlocks(std::string_view frame,
+                             const blockchain::BlockSink& sink,
+                             MessageType& type);
 };
 }  // namespace message
@@ -1,5 +1,6 @@
 #include "BlockchainErrorMessage.hpp"
 
+#include <binary.hpp>
 #include <timestamp.hpp>
 #include <uuid.hpp>
 
@@ -24,9 +25,21 @@ BlockchainErrorMessageResponse::BlockchainErrorMessageResponse(const json& jData
     if (type != MessageType::BLOCKCHAIN_ERROR_RESPONSE)
         throw std::runtime_error("Invalid message type");
 
-    payload.error = jData["payload"]["error"].get<std::string>();
-    payload.blockHash = jData["payload"]["blockHash"].get<std::string>();
-    payload.messageId = jData["payload"]["messageId"].get<std::string>();
+    const json& jPayload = jData.at("payload");
+    payload.error = jPayload.at("error").get<std::string>();
+    payload.blockHash = jPayload.at("blockHash").get<std::string>();
+    payload.messageId = jPayload.at("messageId").get<std::string>();
+}
+
+BlockchainErrorMessageResponse::BlockchainErrorMessageResponse(utils::BinaryReader& reader)
+    : Message(reader), payload{}
+{
+    if (type != MessageType::BLOCKCHAIN_ERROR_RESPONSE)
+        throw std::runtime_error("Invalid message type");
+
+    payload.error = reader.readString();
+    payload.blockHash = reader.readHexString();
+    payload.messageId = reader.readString();
 }
 
 void BlockchainErrorMessageResponse::serialize(json& jData) const
@@ -37,6 +50,13 @@ void BlockchainErrorMessageResponse::serialize(json& jData) const
     jData["payload"]["messageId"] = payload.messageId;
 }
 
+void BlockchainErrorMessageResponse::encodePayload(utils::BinaryWriter& writer) const
+{
+    writer.writeString(payload.error);
+    writer.writeHexString(payload.blockHash);
+    writer.writeString(payload.messageId);
+}
+
 const BlockchainErrorMessageResponsePayload& BlockchainErrorMessageResponse::getPayload() const
 {
     return payload;
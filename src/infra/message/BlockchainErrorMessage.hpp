@@ -15,6 +15,7 @@ class BlockchainErrorMessageResponse : public Message
 {
 protected:
     BlockchainErrorMessageResponsePayload payload;
+    void encodePayload(utils::BinaryWriter& writer) const override;
 
 public:
     BlockchainErrorMessageResponse();
@@ -25,6 +26,7 @@ public:
                                    const std::string& blockHash,
                                    const std::string& messageId);
     BlockchainErrorMessageResponse(const json& jData);
+    BlockchainErrorMessageResponse(utils::BinaryReader& reader);
 
     void serialize(json& jData) const override;
     const BlockchainErrorMessageResponsePayload& getPayload() const;
@@ -2,6 +2,7 @@
 
 #include <string>
 
+#include "binary.hpp"
 #include "timestamp.hpp"
 #include "uuid.hpp"
 
@@ -13,30 +14,50 @@ ConnectionMessage::ConnectionMessage(const std::string& id,
                                      const peer::UserPeer& from,
                                      const peer::UserPeer& to,
                                      uint64_t timestamp,
-                                     const std::string& lastHash)
-    : Message(id, MessageType::CONNECT, from, to, timestamp), payload{ lastHash }
+                                     const std::string& lastHash,
+                                     uint8_t wireVersion)
+    : Message(id, MessageType::CONNECT, from, to, timestamp), payload{ lastHash, wireVersion }
 {
 }
 
 ConnectionMessage::ConnectionMessage(const json& jData) : Message(jData), payload{}
 {
     if (type != MessageType::CONNECT) throw std::runtime_error("Invalid message type");
-    payload.lastBlockHash = jData["payload"]["lastBlockHash"].get<std::string>();
+    const json& jPayload = jData.at("payload");
+    payload.lastBlockHash = jPayload.at("lastBlockHash").get<std::string>();
+    // peers from before the binary format do not send it
+    payload.wireVersion = static_cast<uint8_t>(jPayload.value("wireVersion", 0));
+}
+
+ConnectionMessage::ConnectionMessage(utils::BinaryReader& reader) : Message(reader), payload{}
+{
+    if (type != MessageType::CONNECT) throw std::runtime_error("Invalid message type");
+    payload.lastBlockHash = reader.readHexString();
+    payload.wireVersion = reader.readByte();
 }
 
 void ConnectionMessage::serialize(json& jData) const
 {
     jData = getBasicSerialization();
     jData["payload"]["lastBlockHash"] = payload.lastBlockHash;
+    jData["payload"]["wireVersion"] = payload.wireVersion;
+}
+
+void ConnectionMessage::encodePayload(utils::BinaryWriter& writer) const
+{
+    writer.writeHexString(payload.lastBlockHash);
+    writer.writeByte(payload.wireVersion);
 }
 
 const ConnectionMessagePayload& ConnectionMessage::getPayload() const { return payload; }
 
 ConnectionMessage ConnectionMessage::create(const peer::UserPeer& from,
                                             const peer::UserPeer& to,
-                                            const std::string& lastHash)
+                                            const std::string& lastHash,
+                                            uint8_t wireVersion)
 {
-    return ConnectionMessage(utils::uuidv4(), from, to, utils::getTimestamp(), lastHash);
+    return ConnectionMessage(
+        utils::uuidv4(), from, to, utils::getTimestamp(), lastHash, wireVersion);
 }
 
 ConnectionMessageResponse::ConnectionMessageResponse() : Message() {}
@@ -46,9 +67,10 @@ ConnectionMessageResponse::ConnectionMessageResponse(const std::string& id,
                                                      const peer::UserPeer& to,
                                                      uint64_t timestamp,
                                                      unsigned int peersToReceive,
-                                                     unsigned int missingBlocksCount)
+                                                     unsigned int missingBlocksCount,
+                                                     uint8_t wireVersion)
     : Message(id, MessageType::CONNECT_RESPONSE, from, to, timestamp),
-      payload{ peersToReceive, missingBlocksCount }
+      payload{ peersToReceive, missingBlocksCount, wireVersion }
 {
 }
 
@@ -56,8 +78,20 @@ ConnectionMessageResponse::ConnectionMessageResponse(const json& jData) : Messag
 {
     if (type != MessageType::CONNECT_RESPONSE) throw std::runtime_error("Invalid message type");
 
-    payload.peersToReceive = jData["payload"]["peersToReceive"].get<unsigned int>();
-    payload.missingBlocksCount = jData["payload"]["missingBlocksCount"].get<unsigned int>();
+    const json& jPayload = jData.at("payload");
+    payload.peersToReceive = jPayload.at("peersToReceive").get<unsigned int>();
+    payload.missingBlocksCount = jPayload.at("missingBlocksCount").get<unsigned int>();
+    payload.wireVersion = static_cast<uint8_t>(jPayload.value("wireVersion", 0));
+}
+
+ConnectionMessageResponse::ConnectionMessageResponse(utils::BinaryReader& reader)
+    : Message(reader), payload{}
+{
+    if (type != MessageType::CONNECT_RESPONSE) throw std::runtime_error("Invalid message type");
+
+    payload.peersToReceive = static_cast<unsigned int>(reader.readVarint());
+    payload.missingBlocksCount = static_cast<unsigned int>(reader.readVarint());
+    payload.wireVersion = reader.readByte();
 }
 
 void ConnectionMessageResponse::serialize(json& jData) const
@@ -65,6 +99,14 @@ void ConnectionMessageResponse::serialize(json& jData) const
     jData = getBasicSerialization();
     jData["payload"]["peersToReceive"] = payload.peersToReceive;
     jData["payload"]["missingBlocksCount"] = payload.missingBlocksCount;
+    jData["payload"]["wireVersion"] = payload.wireVersion;
+}
+
+void ConnectionMessageResponse::encodePayload(utils::BinaryWriter& writer) const
+{
+    writer.writeVarint(payload.peersToReceive);
+    writer.writeVarint(payload.missingBlocksCount);
+    writer.writeByte(payload.wireVersion);
 }
 
 const ConnectionMessageResponsePayload& ConnectionMessageResponse::getPayload() const
@@ -74,9 +116,15 @@ const ConnectionMessageResponsePayload& ConnectionMessageResponse::getPayload()
 ConnectionMessageResponse ConnectionMessageResponse::create(const peer::UserPeer& from,
                                                             const peer::UserPeer& to,
                                                             unsigned int peersToReceive,
-                                                            unsigned int missingBlocksCount)
+                                                            unsigned int missingBlocksCount,
+                                                            uint8_t wireVersion)
 {
-    return ConnectionMessageResponse(
-        utils::uuidv4(), from, to, utils::getTimestamp(), peersToReceive, missingBlocksCount);
+    return ConnectionMessageResponse(utils::uuidv4(),
+                                     from,
+                                     to,
+                                     utils::getTimestamp(),
+                                     peersToReceive,
+                                     missingBlocksCount,
+                                     wireVersion);
 }
 }  // namespace message
\ No newline at end of file
@@ -12,12 +12,15 @@ using json = nlohmann::json;
 struct ConnectionMessagePayload
 {
     std::string lastBlockHash;
+    // highest binary format the sender reads, 0 (or missing) means JSON only
+    uint8_t wireVersion;
 };
 
 class ConnectionMessage : public Message
 {
 protected:
     ConnectionMessagePayload payload;
+    void encodePayload(utils::BinaryWriter& writer) const override;
 
 public:
     ConnectionMessage();
@@ -25,27 +28,33 @@ public:
                       const peer::UserPeer& from,
                       const peer::UserPeer& to,
                       uint64_t timestamp,
-                      const std::string& lastHash);
+                      const std::string& lastHash,
+                      uint8_t wireVersion);
     ConnectionMessage(const json& jData);
+    ConnectionMessage(utils::BinaryReader& reader);
 
     void serialize(json& jData) const override;
     const ConnectionMessagePayload& getPayload() const;
 
     static ConnectionMessage create(const peer::UserPeer& from,
                                     const peer::UserPeer& to,
-                                    const std::string& lastHash);
+                                    const std::string& lastHash,
+                                    uint8_t wireVersion = WIRE_VERSION);
 };
 
 struct ConnectionMessageResponsePayload
 {
     unsigned int peersToReceive;
     unsigned int missingBlocksCount;
+    // binary format both sides agreed on, 0 means JSON
+    uint8_t wireVersion;
 };
 
 class ConnectionMessageResponse : public Message
 {
 protected:
     ConnectionMessageResponsePayload payload;
+    void encodePayload(utils::BinaryWriter& writer) const override;
 
 public:
     ConnectionMessageResponse();
@@ -54,8 +63,10 @@ public:
                               const peer::UserPeer& to,
                               uint64_t timestamp,
                               unsigned int peersToReceive,
-                              unsigned int missingBlocksCount);
+                              unsigned int missingBlocksCount,
+                              uint8_t wireVersion);
     ConnectionMessageResponse(const json& jData);
+    ConnectionMessageResponse(utils::BinaryReader& reader);
 
     void serialize(json& jData) const override;
     const ConnectionMessageResponsePayload& getPayload() const;
@@ -63,6 +74,7 @@ public:
     static ConnectionMessageResponse create(const peer::UserPeer& from,
                                             const peer::UserPeer& to,
                                             unsigned int peersToReceive,
-                                            unsigned int missingBlocksCount);
+                                            unsigned int missingBlocksCount,
+                                            uint8_t wireVersion = 0);
 };
 }  // namespace message
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "DisconnectionMessage.hpp"
 
+#include "binary.hpp"
 #include "timestamp.hpp"
 #include "uuid.hpp"
 
@@ -20,6 +21,11 @@ DisconnectionMessage::DisconnectionMessage(const json& jData) : Message(jData)
     if (type != MessageType::DISCONNECT) throw std::runtime_error("Invalid message type");
 }
 
+DisconnectionMessage::DisconnectionMessage(utils::BinaryReader& reader) : Message(reader)
+{
+    if (type != MessageType::DISCONNECT) throw std::runtime_error("Invalid message type");
+}
+
 void DisconnectionMessage::serialize(json& jData) const { jData = getBasicSerialization(); }
 
 DisconnectionMessage DisconnectionMessage::create(const peer::UserPeer& from,
@@ -43,6 +49,12 @@ DisconnectionMessageResponse::DisconnectionMessageResponse(const json& jData) :
     if (type != MessageType::DISCONNECT_RESPONSE) throw std::runtime_error("Invalid message type");
 }
 
+DisconnectionMessageResponse::DisconnectionMessageResponse(utils::BinaryReader& reader)
+    : Message(reader)
+{
+    if (type != MessageType::DISCONNECT_RESPONSE) throw std::runtime_error("Invalid message type");
+}
+
 void DisconnectionMessageResponse::serialize(json& jData) const { jData = getBasicSerialization(); }
 
 DisconnectionMessageResponse DisconnectionMessageResponse::create(const peer::UserPeer& from,
@@ -17,6 +17,7 @@ public:
                          const peer::UserPeer& to,
                          uint64_t timestamp);
     DisconnectionMessage(const json& jData);
+    DisconnectionMessage(utils::BinaryReader& reader);
 
     void serialize(json& jData) const override;
 
@@ -32,6 +33,7 @@ public:
                                  const peer::UserPeer& to,
                                  uint64_t timestamp);
     DisconnectionMessageResponse(const json& jData);
+    DisconnectionMessageResponse(utils::BinaryReader& reader);
 
     void serialize(json& jData) const override;
 
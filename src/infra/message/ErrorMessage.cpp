@@ -1,5 +1,6 @@
 #include "ErrorMessage.hpp"
 
+#include "binary.hpp"
 #include "timestamp.hpp"
 #include "uuid.hpp"
 
@@ -21,7 +22,14 @@ ErrorMessageResponse::ErrorMessageResponse(const json& jData) : Message(jData),
 {
     if (type != MessageType::ERROR_RESPONSE) throw std::runtime_error("Invalid message type");
 
-    payload.error = jData["payload"]["error"].get<std::string>();
+    payload.error = jData.at("payload").at("error").get<std::string>();
+}
+
+ErrorMessageResponse::ErrorMessageResponse(utils::BinaryReader& reader) : Message(reader), payload{}
+{
+    if (type != MessageType::ERROR_RESPONSE) throw std::runtime_error("Invalid message type");
+
+    payload.error = reader.readString();
 }
 
 void ErrorMessageResponse::serialize(json& jData) const
@@ -30,6 +38,11 @@ void ErrorMessageResponse::serialize(json& jData) const
     jData["payload"]["error"] = payload.error;
 }
 
+void ErrorMessageResponse::encodePayload(utils::BinaryWriter& writer) const
+{
+    writer.writeString(payload.error);
+}
+
 const ErrorMessageResponsePayload& ErrorMessageResponse::getPayload() const { return payload; }
 
 ErrorMessageResponse ErrorMessageResponse::create(const peer::UserPeer& from,
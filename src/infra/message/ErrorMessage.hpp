@@ -12,6 +12,7 @@ class ErrorMessageResponse : public Message
 {
 protected:
     ErrorMessageResponsePayload payload;
+    void encodePayload(utils::BinaryWriter& writer) const override;
 
 public:
     ErrorMessageResponse();
@@ -21,6 +22,7 @@ public:
                          uint64_t timestamp,
                          const std::string& error);
     ErrorMessageResponse(const json& jData);
+    ErrorMessageResponse(utils::BinaryReader& reader);
 
     void serialize(json& jData) const override;
     const ErrorMessageResponsePayload& getPayload() const;
@@ -2,6 +2,25 @@
 
 namespace message
 {
+constexpr const char* SQL_FIND_CHAT_MESSAGES =
+    "SELECT message_json FROM messages WHERE to_public_key=? AND from_public_key=?;";
+constexpr const char* SQL_FIND_BLOCK_HASH_BY_MESSAGE_ID =
+    "SELECT block_hash FROM messages WHERE message_id=? LIMIT 1;";
+constexpr const char* SQL_INSERT_MESSAGE =
+    "INSERT INTO messages(message_id, to_public_key, from_public_key, timestamp, message_json, "
+    "block_hash) VALUES (?,?,?,?,?,?);";
+constexpr const char* SQL_REMOVE_MESSAGE_BY_BLOCK_HASH = "DELETE FROM messages WHERE block_hash=?;";
+constexpr const char* SQL_REMOVE_MESSAGE_BY_ID = "DELETE FROM messages WHERE id=?;";
+
+// compiled once in init(), later queries reuse the cached statements
+constexpr const char* PREPARED_STATEMENTS[] = {
+    SQL_FIND_CHAT_MESSAGES,
+    SQL_FIND_BLOCK_HASH_BY_MESSAGE_ID,
+    SQL_INSERT_MESSAGE,
+    SQL_REMOVE_MESSAGE_BY_BLOCK_HASH,
+    SQL_REMOVE_MESSAGE_BY_ID,
+};
+
 MessageDB::MessageDB(const std::shared_ptr<db::DBFile>& db,
                      const std::shared_ptr<config::IConfig>& config,
                      const std::shared_ptr<crypto::ICrypto>& crypto)
@@ -27,6 +46,8 @@ void MessageDB::init()
     db->exec(R"(
         CREATE INDEX IF NOT EXISTS idx_messages_message_id ON messages(message_id);
     )");
+
+    for (const char* sql : PREPARED_STATEMENTS) db->prepare(sql);
 }
 
 void MessageDB::findChatMessages(const std::string& peerAPublicKey,
@@ -34,37 +55,34 @@ void MessageDB::findChatMessages(const std::string& peerAPublicKey,
                                  std::vector<TextMessage>& messages)
 {
     bool error = false;
+    std::string privateKey = config->get(config::ConfigField::PRIVATE_KEY);
 
-    db->selectPrepared(
-        "SELECT message_json "
-        "FROM messages WHERE to_public_key=? AND from_public_key=?;",
+    db->selectRows(
+        SQL_FIND_CHAT_MESSAGES,
         { peerAPublicKey, peerBPublicKey },
-        [&messages, &error, this](const std::vector<std::string>& row)
+        [&messages, &error, &privateKey, this](const db::Row& row)
         {
-            if (row.size() < 1) return;
-            json jData = json::parse(row[0]);
+            std::string_view messageJson = row.getText(0);
+            json jData = json::parse(messageJson.begin(), messageJson.end());
             try
             {
-                messages.emplace_back(
-                    jData, config->get(config::ConfigField::PRIVATE_KEY), crypto, false, true);
+                messages.emplace_back(jData, privateKey, crypto, false, true);
             }
             catch (const std::exception&)
             {
                 error = true;
             }
         });
-    db->selectPrepared(
-        "SELECT message_json "
-        "FROM messages WHERE to_public_key=? AND from_public_key=?;",
+    db->selectRows(
+        SQL_FIND_CHAT_MESSAGES,
         { peerBPublicKey, peerAPublicKey },
-        [&messages, &error, this](const std::vector<std::string>& row)
+        [&messages, &error, &privateKey, this](const db::Row& row)
         {
-            if (row.size() < 1) return;
-            json jData = json::parse(row[0]);
+            std::string_view messageJson = row.getText(0);
+            json jData = json::parse(messageJson.begin(), messageJson.end());
             try
             {
-                messages.emplace_back(
-                    jData, config->get(config::ConfigField::PRIVATE_KEY), crypto, true, true);
+                messages.emplace_back(jData, privateKey, crypto, true, true);
             }
             catch (const std::exception&)
             {
@@ -84,16 +102,13 @@ bool MessageDB::findBlockHashByMessageId(const std::string& messageId, std::stri
 {
     bool found = false;
 
-    db->selectPrepared("SELECT block_hash FROM messages WHERE message_id=? LIMIT 1;",
-                       { messageId },
-                       [&blockHash, &found](const std::vector<std::string>& row)
-                       {
-                           if (!row.empty())
-                           {
-                               blockHash = row[0];
-                               found = true;
-                           }
-                       });
+    db->selectRows(SQL_FIND_BLOCK_HASH_BY_MESSAGE_ID,
+                   { messageId },
+                   [&blockHash, &found](const db::Row& row)
+                   {
+                       blockHash = row.getText(0);
+                       found = true;
+                   });
 
     return found;
 }
@@ -103,9 +118,7 @@ bool MessageDB::insertSecretMessage(const TextMessage& message,
                                     const std::string& blockHash)
 {
     return db->executePrepared(
-        "INSERT INTO messages(message_id, to_public_key, from_public_key, timestamp, message_json, "
-        "block_hash) "
-        "VALUES (?,?,?,?,?,?);",
+        SQL_INSERT_MESSAGE,
         { message.getId(),
           message.getTo().publicKey,
           message.getFrom().publicKey,
@@ -116,11 +129,11 @@ bool MessageDB::insertSecretMessage(const TextMessage& message,
 
 bool MessageDB::removeMessageByBlockHash(const std::string& blockHash)
 {
-    return db->executePrepared("DELETE FROM messages WHERE block_hash=?;", { blockHash });
+    return db->executePrepared(SQL_REMOVE_MESSAGE_BY_BLOCK_HASH, { blockHash });
 }
 
 bool MessageDB::removeMessageById(const std::string& messageId)
 {
-    return db->executePrepared("DELETE FROM messages WHERE id=?;", { messageId });
+    return db->executePrepared(SQL_REMOVE_MESSAGE_BY_ID, { messageId });
 }
 }  // namespace message
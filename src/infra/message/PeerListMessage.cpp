@@ -1,5 +1,6 @@
 #include "PeerListMessage.hpp"
 
+#include "binary.hpp"
 #include "timestamp.hpp"
 #include "uuid.hpp"
 
@@ -21,8 +22,17 @@ PeerListMessage::PeerListMessage(const json& jData) : Message(jData)
 {
     if (type != MessageType::PEER_LIST) throw std::runtime_error("Invalid message type");
 
-    payload.start = jData["payload"]["start"].get<u_int>();
-    payload.count = jData["payload"]["count"].get<u_int>();
+    const json& jPayload = jData.at("payload");
+    payload.start = jPayload.at("start").get<u_int>();
+    payload.count = jPayload.at("count").get<u_int>();
+}
+
+PeerListMessage::PeerListMessage(utils::BinaryReader& reader) : Message(reader)
+{
+    if (type != MessageType::PEER_LIST) throw std::runtime_error("Invalid message type");
+
+    payload.start = static_cast<u_int>(reader.readVarint());
+    payload.count = static_cast<u_int>(reader.readVarint());
 }
 
 void PeerListMessage::serialize(json& jData) const
@@ -33,6 +43,12 @@ void PeerListMessage::serialize(json& jData) const
     jData["payload"]["count"] = payload.count;
 }
 
+void PeerListMessage::encodePayload(utils::BinaryWriter& writer) const
+{
+    writer.writeVarint(payload.start);
+    writer.writeVarint(payload.count);
+}
+
 const PeerListMessagePayload& PeerListMessage::getPayload() const { return payload; }
 
 PeerListMessage PeerListMessage::create(const peer::UserPeer& from,
@@ -60,12 +76,21 @@ PeerListMessageResponse::PeerListMessageResponse(const json& jData) : Message(jD
 
     payload.peers.clear();
 
-    json peersJson = jData["payload"]["peers"];
+    const json& peersJson = jData.at("payload").at("peers");
     if (!peersJson.is_array()) throw std::runtime_error("Peers field must be an array");
 
     for (const auto& jPeer : peersJson) payload.peers.emplace_back(jPeer);
 }
 
+PeerListMessageResponse::PeerListMessageResponse(utils::BinaryReader& reader)
+    : Message(reader), payload{}
+{
+    if (type != MessageType::PEER_LIST_RESPONSE) throw std::runtime_error("Invalid message type");
+
+    uint64_t count = reader.readVarint();
+    for (uint64_t i = 0; i < count; ++i) payload.peers.push_back(decodePeer(reader));
+}
+
 void PeerListMessageResponse::serialize(json& jData) const
 {
     jData = getBasicSerialization();
@@ -76,6 +101,13 @@ void PeerListMessageResponse::serialize(json& jData) const
         jData["payload"]["peers"].push_back(peer.toJson());
     }
 }
+
+void PeerListMessageResponse::encodePayload(utils::BinaryWriter& writer) const
+{
+    writer.writeVarint(payload.peers.size());
+    for (const auto& peer : payload.peers) encodePeer(writer, peer);
+}
+
 const PeerListMessageResponsePayload& PeerListMessageResponse::getPayload() const
 {
     return payload;
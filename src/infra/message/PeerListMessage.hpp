@@ -16,6 +16,7 @@ class PeerListMessage : public Message
 {
 protected:
     PeerListMessagePayload payload;
+    void encodePayload(utils::BinaryWriter& writer) const override;
 
 public:
     PeerListMessage();
@@ -26,6 +27,7 @@ public:
                     u_int start,
                     u_int count);
     PeerListMessage(const json& jData);
+    PeerListMessage(utils::BinaryReader& reader);
 
     void serialize(json& jData) const override;
     const PeerListMessagePayload& getPayload() const;
@@ -45,6 +47,7 @@ class PeerListMessageResponse : public Message
 {
 protected:
     PeerListMessageResponsePayload payload;
+    void encodePayload(utils::BinaryWriter& writer) const override;
 
 public:
     PeerListMessageResponse();
@@ -54,6 +57,7 @@ public:
                             uint64_t timestamp,
                             const std::vector<peer ::UserPeer> peers);
     PeerListMessageResponse(const json& jData);
+    PeerListMessageResponse(utils::BinaryReader& reader);
 
     void serialize(json& jData) const override;
     const PeerListMessageResponsePayload& getPayload() const;
@@ -1,5 +1,6 @@
 #include "TextMessage.hpp"
 
+#include "binary.hpp"
 #include "timestamp.hpp"
 #include "uuid.hpp"
 
@@ -42,7 +43,8 @@ TextMessage::TextMessage(const json& jData,
         std::string publicKey = invertFromTo ? to.publicKey : from.publicKey;
         crypto::Bytes sessionKey = createSessionKey(privateKey, publicKey, crypto);
 
-        crypto::Bytes cipher = crypto->stringToKey(jData["payload"]["message"].get<std::string>());
+        crypto::Bytes cipher = crypto->stringToKey(
+            jData.at("payload").at("message").get_ref<const std::string&>());
         crypto::Bytes plain = crypto->decrypt(cipher, sessionKey);
         crypto::Bytes publicKeyBytes = crypto->stringToKey(from.publicKey);
 
@@ -97,6 +99,12 @@ TextMessageResponse::TextMessageResponse(const std::string& id,
 
 TextMessageResponse::TextMessageResponse(const json& jData) : Message(jData) {}
 
+TextMessageResponse::TextMessageResponse(utils::BinaryReader& reader) : Message(reader)
+{
+    if (type != MessageType::TEXT_MESSAGE_RESPONSE)
+        throw std::runtime_error("Invalid message type");
+}
+
 void TextMessageResponse::serialize(json& jData) const { jData = getBasicSerialization(); }
 
 TextMessageResponse TextMessageResponse::create(const peer::UserPeer& from,
@@ -57,6 +57,7 @@ public:
                         const peer::UserPeer& to,
                         uint64_t timestamp);
     TextMessageResponse(const json& jData);
+    TextMessageResponse(utils::BinaryReader& reader);
 
     void serialize(json& jData) const override;
 
@@ -0,0 +1,122 @@
+#include "ConnectionPool.hpp"
+
+#include <algorithm>
+
+namespace network
+{
+ConnectionPool::ConnectionPool(u_int socketTimeoutMs) : socketTimeoutMs(socketTimeoutMs) {}
+
+std::unique_ptr<SocketClient> ConnectionPool::acquire(const peer::UserHost& host, bool& reused)
+{
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        evictIdle();
+
+        auto it = idle.find(host);
+        if (it != idle.end())
+        {
+            std::vector<IdleConnection>& connections = it->second;
+
+            // most recently used connection first, it is the least likely to be closed
+            while (!connections.empty())
+            {
+                std::unique_ptr<SocketClient> client = std::move(connections.back().client);
+                connections.pop_back();
+
+                if (client->isAlive())
+                {
+                    reused = true;
+                    return client;
+                }
+            }
+            idle.erase(it);
+        }
+    }
+
+    reused = false;
+    auto client = std::make_unique<SocketClient>();
+    if (!client->connectTo(host.host, host.port)) return nullptr;
+
+    client->setTimeout(socketTimeoutMs);
+    return client;
+}
+
+void ConnectionPool::release(const peer::UserHost& host, std::unique_ptr<SocketClient> client)
+{
+    std::lock_guard<std::mutex> lock(idleMutex);
+
+    std::vector<IdleConnection>& connections = idle[host];
+    if (connections.size() >= POOL_MAX_IDLE_PER_HOST) return;  // client is closed on destruction
+
+    connections.push_back({ std::move(client), Clock::now() });
+}
+
+void ConnectionPool::evictIdle()
+{
+    Clock::time_point deadline = Clock::now() - std::chrono::milliseconds(POOL_IDLE_TIMEOUT_MS);
+
+    for (auto it = idle.begin(); it != idle.end();)
+    {
+        std::vector<IdleConnection>& connections = it->second;
+        connections.erase(std::remove_if(connections.begin(),
+                                         connections.end(),
+                                         [&deadline](const IdleConnection& connection)
+                                         { return connection.lastUsed < deadline; }),
+                          connections.end());
+
+        if (connections.empty())
+            it = idle.erase(it);
+        else
+            ++it;
+    }
+}
+
+bool ConnectionPool::request(const peer::UserHost& host,
+                             const std::string& message,
+                             std::string& response)
+{
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        bool reused = false;
+        std::unique_ptr<SocketClient> client = acquire(host, reused);
+        if (!client) return false;
+
+        // nothing reached the peer, a fresh connection failing means it is really unreachable
+        if (!client->sendMessage(message))
+        {
+            if (reused) continue;
+            return false;
+        }
+
+        response = client->receiveMessage();
+        if (client->isConnected())
+        {
+            release(host, std::move(client));
+            return true;
+        }
+
+        // after a timeout or a partial reply the peer may have handled the request, sending it
+        // again could store a message twice; only a stale connection closed unanswered is retried
+        if (!reused || !client->wasClosedByPeer()) return false;
+    }
+    return false;
+}
+
+void ConnectionPool::closeAll()
+{
+    std::lock_guard<std::mutex> lock(idleMutex);
+    idle.clear();
+}
+
+size_t ConnectionPool::idleCount()
+{
+    std::lock_guard<std::mutex> lock(idleMutex);
+
+    size_t count = 0;
+    for (const auto& entry : idle)
+    {
+        count += entry.second.size();
+    }
+    return count;
+}
+}  // namespace network
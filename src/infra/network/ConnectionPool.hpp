@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "SocketClient.hpp"
+#include "UserPeer.hpp"
+
+namespace network
+{
+constexpr const u_int POOL_IDLE_TIMEOUT_MS = 60000;  // idle connections older than this are closed
+constexpr const size_t POOL_MAX_IDLE_PER_HOST = 4;
+constexpr const u_int POOL_SOCKET_TIMEOUT_MS = 10000;
+
+// keeps long-lived connections to peers, so a request does not pay a TCP handshake every time
+class ConnectionPool
+{
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct IdleConnection
+    {
+        std::unique_ptr<SocketClient> client;
+        Clock::time_point lastUsed;
+    };
+
+    std::unordered_map<peer::UserHost, std::vector<IdleConnection>, peer::UserHostHash> idle;
+    std::mutex idleMutex;
+    u_int socketTimeoutMs;
+
+    std::unique_ptr<SocketClient> acquire(const peer::UserHost& host, bool& reused);
+    void release(const peer::UserHost& host, std::unique_ptr<SocketClient> client);
+    void evictIdle();
+
+public:
+    explicit ConnectionPool(u_int socketTimeoutMs = POOL_SOCKET_TIMEOUT_MS);
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // sends one message and waits for its response, reconnects once if a pooled connection turns
+    // out to be stale before the peer could have seen the request
+    bool request(const peer::UserHost& host, const std::string& message, std::string& response);
+    void closeAll();
+    size_t idleCount();
+};
+}  // namespace network
@@ -1,8 +1,6 @@
 #include "TCPClient.hpp"
 
 #include "DisconnectionMessage.hpp"
-#include "SocketClient.hpp"
-#include "SocketServer.hpp"
 #include "timestamp.hpp"
 #include "uuid.hpp"
 
@@ -34,55 +32,55 @@ TCPClient::TCPClient(const std::shared_ptr<config::IConfig>& config,
     {
         peer::UserPeer to{ userHost.host, userHost.port, "" };
 
-        message::ConnectionMessage message = message::ConnectionMessage::create(from, to, lastHash);
+        message::ConnectionMessage message = message::ConnectionMessage::create(
+            from, to, lastHash, chatService->getWireVersion());
         sendMessage(message);
     }
 }
 
 void TCPClient::connectToAllPeers()
 {
-    std::vector<peer::UserPeer> peers = peerService->getPeers();
+    std::shared_ptr<const peer::PeerTable> peers = peerService->getPeerTable();
 
     std::string host = config->get(config::ConfigField::HOST);
     u_short port = static_cast<u_short>(std::stoi(config->get(config::ConfigField::PORT)));
     peer::UserPeer from{ host, port, config->get(config::ConfigField::PUBLIC_KEY) };
 
-    for (const auto& to : peers)
+    for (const auto& to : peers->peers)
     {
-        message::ConnectionMessage message = message::ConnectionMessage::create(from, to, "0");
+        message::ConnectionMessage message =
+            message::ConnectionMessage::create(from, to, "0", chatService->getWireVersion());
         sendMessage(message);
     }
 }
 
+std::string TCPClient::encodeFor(const peer::UserHost& to, const message::Message& message) const
+{
+    bool binary = peerService->getWireVersion(to) > 0;
+    return message.toWire(binary ? message::WireFormat::BINARY : message::WireFormat::JSON);
+}
+
 void TCPClient::sendMessage(const message::Message& message)
 {
     if (typeid(message) == typeid(message::SecretMessage))
         throw std::runtime_error("Secret messages should be sent by sendSecretMessage() method");
 
-    peer::UserPeer to = message.getTo();
-    SocketClient client;
-    client.connectTo(to.host, to.port);
-
-    json jMessage;
-    message.serialize(jMessage);
-    std::string serializedMessage = jMessage.dump();
-
-    if (serializedMessage.length() > BUFFER_SIZE) throw std::runtime_error("Message is too big");
-
-    if (client.sendMessage(serializedMessage))
-    {
-        std::string response = client.receiveMessage();
+    std::string response;
+    if (connectionPool.request(message.getTo(), encodeFor(message.getTo(), message), response))
         chatService->handleOutgoingMessage(response);
-    }
+}
 
-    client.disconnect();
+bool TCPClient::requestMessage(const message::Message& message, std::string& response)
+{
+    if (typeid(message) == typeid(message::SecretMessage))
+        throw std::runtime_error("Secret messages should be sent by sendSecretMessage() method");
+
+    return connectionPool.request(message.getTo(), encodeFor(message.getTo(), message), response);
 }
 
 void TCPClient::sendSecretMessage(const message::SecretMessage& message)
 {
     peer::UserPeer to = message.getTo();
-    SocketClient textMessageClient;
-    textMessageClient.connectTo(to.host, to.port);
 
     json jMessage;
     message::TextMessage& textMessage =
@@ -90,73 +88,65 @@ void TCPClient::sendSecretMessage(const message::SecretMessage& message)
 
     blockchain::Block block;
     blockchainService->createBlockFromMessage(textMessage, block);
-    textMessage.setBlockHash(block.hash);
+    textMessage.setBlockHash(block.hashHex());
 
     textMessage.serialize(jMessage, config->get(config::ConfigField::PRIVATE_KEY), crypto);
     std::string serializedMessage = jMessage.dump();
 
-    if (serializedMessage.length() > BUFFER_SIZE) throw std::runtime_error("Message is too big");
-
-    if (textMessageClient.sendMessage(serializedMessage))
+    std::string response;
+    if (connectionPool.request(to, serializedMessage, response))
     {
-        std::string response = textMessageClient.receiveMessage();
-        textMessageClient.disconnect();
         chatService->handleOutgoingMessage(response);
 
-        messageService->insertSecretMessage(textMessage, serializedMessage, block.hash);
+        messageService->insertSecretMessage(textMessage, serializedMessage, block.hashHex());
         peerService->addChatPeer(textMessage.getTo());
 
-        auto sendCallback = [this](const std::string& raw, const peer::UserPeer& peer) -> bool
+        // a send may still run after the broadcast timed out and this client is gone
+        std::weak_ptr<TCPClient> weakClient = weak_from_this();
+        auto sendCallback = [weakClient](const std::string& raw, const peer::UserPeer& peer) -> bool
         {
-            SocketClient localClient;
-            localClient.connectTo(peer.host, peer.port);
-            bool ok = true;
+            std::shared_ptr<TCPClient> client = weakClient.lock();
+            if (!client) return false;
+
+            // an offline peer does not hold the block back
+            std::string response;
+            if (!client->connectionPool.request(peer, raw, response)) return true;
 
-            if (localClient.sendMessage(raw))
+            try
             {
-                try
-                {
-                    std::string response = localClient.receiveMessage();
-                    json jResponse = json::parse(response);
-
-                    if (jResponse.contains("type") &&
-                        jResponse["type"] == message::Message::fromMessageTypeToString(
-                                                 message::MessageType::BLOCKCHAIN_ERROR_RESPONSE))
-                        ok = false;
-                }
-                catch (...)
-                {
-                    ok = false;
-                }
-            }
+                json jResponse = json::parse(response);
 
-            localClient.disconnect();
-            return ok;
+                if (jResponse.contains("type") &&
+                    jResponse["type"] == message::Message::fromMessageTypeToString(
+                                             message::MessageType::BLOCKCHAIN_ERROR_RESPONSE))
+                    return false;
+            }
+            catch (...)
+            {
+                return false;
+            }
+            return true;
         };
 
-        std::vector<peer::UserPeer> peers = peerService->getPeers();
-        bool stored = blockchainService->storeAndBroadcastBlock(block, peers, sendCallback);
+        std::shared_ptr<const peer::PeerTable> peers = peerService->getPeerTable();
+        blockchain::BroadcastResult broadcastResult;
+        bool stored = blockchainService->storeAndBroadcastBlock(
+            block, peers->peers, sendCallback, broadcastResult);
 
         if (!stored)
         {
-            messageService->removeMessageByBlockHashOrId(block.hash, message.getId());
+            messageService->removeMessageByBlockHashOrId(block.hashHex(), message.getId());
             consoleUI->printLog("[WARN] block was not stored (maybe duplicate or fork)\n");
 
-            SocketClient errorMessageClient;
-            errorMessageClient.connectTo(to.host, to.port);
-
             message::BlockchainErrorMessageResponse errorMessage =
                 message::BlockchainErrorMessageResponse::create(
                     to,
                     "Block was not stored (maybe duplicate  or fork)",
-                    block.hash,
+                    block.hashHex(),
                     message.getId());
-            errorMessage.serialize(jMessage);
-
-            errorMessageClient.sendMessage(jMessage.dump());
+            connectionPool.request(to, encodeFor(to, errorMessage), response);
         }
     }
-    textMessageClient.disconnect();
 }
 
 void TCPClient::disconnect()
@@ -166,12 +156,14 @@ void TCPClient::disconnect()
     std::string publicKey = config->get(config::ConfigField::PUBLIC_KEY);
 
     peer::UserPeer from{ host, port, publicKey };
-    std::vector<peer::UserPeer> peers = peerService->getPeers();
+    std::shared_ptr<const peer::PeerTable> peers = peerService->getPeerTable();
 
-    for (const auto& peer : peers)
+    for (const auto& peer : peers->peers)
     {
         message::DisconnectionMessage message = message::DisconnectionMessage::create(from, peer);
         sendMessage(message);
     }
+
+    connectionPool.closeAll();
 }
 }  // namespace network
\ No newline at end of file
@@ -5,6 +5,7 @@
 
 #include "BlockchainService.hpp"
 #include "ChatService.hpp"
+#include "ConnectionPool.hpp"
 #include "ConsoleUI.hpp"
 #include "IChatClient.hpp"
 #include "Message.hpp"
@@ -15,7 +16,8 @@ namespace network
 {
 using json = nlohmann::json;
 
-class TCPClient : public IChatClient
+// owned through a shared_ptr, block broadcasts that outlive their timeout only hold a weak_ptr
+class TCPClient : public IChatClient, public std::enable_shared_from_this<TCPClient>
 {
 private:
     std::shared_ptr<config::IConfig> config;
@@ -25,6 +27,10 @@ private:
     std::shared_ptr<blockchain::BlockchainService> blockchainService;
     std::shared_ptr<message::MessageService> messageService;
     std::shared_ptr<ui::ConsoleUI> consoleUI;
+    ConnectionPool connectionPool;
+
+    // binary for peers that agreed on it in CONNECT, JSON for everyone else
+    std::string encodeFor(const peer::UserHost& to, const message::Message& message) const;
 
 public:
     TCPClient(const std::shared_ptr<config::IConfig>& config,
@@ -38,6 +44,7 @@ public:
 
     void connectToAllPeers() override;
     void sendMessage(const message::Message& message) override;
+    bool requestMessage(const message::Message& message, std::string& response) override;
     void sendSecretMessage(const message::SecretMessage& message) override;
     void disconnect() override;
 };
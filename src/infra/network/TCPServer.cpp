@@ -5,8 +5,9 @@ namespace network
 TCPServer::TCPServer(u_short port,
                      const std::shared_ptr<chat::ChatService>& chatService,
                      const std::shared_ptr<blockchain::BlockchainService>& blockchainService,
-                     const std::shared_ptr<ui::ConsoleUI>& consoleUI)
-    : server(port),
+                     const std::shared_ptr<ui::ConsoleUI>& consoleUI,
+                     size_t workerCount)
+    : server(port, workerCount),
       chatService(chatService),
       blockchainService(blockchainService),
       consoleUI(consoleUI)
@@ -20,11 +21,19 @@ void TCPServer::start()
                int bufferSize,
                std::function<void(const std::string&)> sendCallback)
         {
-            std::string message(buffer, bufferSize);
+            std::string_view frame(buffer, bufferSize);
+            if (message::Message::isBinaryFrame(frame))
+            {
+                std::string response;
+                chatService->handleIncomingBinaryMessage(frame, response);
+                sendCallback(response);
+                return;
+            }
 
             try
             {
-                json jData = json::parse(message);
+                // parsed straight from the receive buffer, the text goes along for storing
+                json jData = json::parse(frame.begin(), frame.end());
                 std::string response = "{}";
 
                 if (jData.contains("previousHash") && jData.contains("payloadHash"))
@@ -33,7 +42,7 @@ void TCPServer::start()
                 }
                 else
                 {
-                    chatService->handleIncomingMessage(jData, response);
+                    chatService->handleIncomingMessage(frame, jData, response);
                 }
 
                 sendCallback(response);
@@ -42,6 +51,9 @@ void TCPServer::start()
             {
                 consoleUI->printLog(
                     "[SERVER] handle incoming message error: " + std::string(error.what()) + "\n");
+
+                // the connection stays open, so the client still waits for an answer
+                sendCallback(R"({"type":"ERROR_RESPONSE","error":"Invalid data format"})");
             }
         });
     if (!started) throw std::runtime_error("Failed to start server");
@@ -25,7 +25,8 @@ public:
     TCPServer(u_short port,
               const std::shared_ptr<chat::ChatService>& chatService,
               const std::shared_ptr<blockchain::BlockchainService>& blockchainService,
-              const std::shared_ptr<ui::ConsoleUI>& consoleUI);
+              const std::shared_ptr<ui::ConsoleUI>& consoleUI,
+              size_t workerCount = 0);
 
     void start() override;
     void stop() override;
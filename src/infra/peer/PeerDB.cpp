@@ -2,6 +2,20 @@
 
 namespace peer
 {
+constexpr const char* SQL_ALL_PEERS = "SELECT host, port, public_key FROM peers;";
+constexpr const char* SQL_FIND_PEER_ID = "SELECT id FROM peers WHERE public_key=? LIMIT 1;";
+constexpr const char* SQL_INSERT_PEER = "INSERT INTO peers(host, port, public_key) VALUES (?,?,?);";
+constexpr const char* SQL_FIND_PUBLIC_KEY_BY_HOST =
+    "SELECT public_key FROM peers WHERE host=? AND port=? LIMIT 1;";
+
+// compiled once in init(), later queries reuse the cached statements
+constexpr const char* PREPARED_STATEMENTS[] = {
+    SQL_ALL_PEERS,
+    SQL_FIND_PEER_ID,
+    SQL_INSERT_PEER,
+    SQL_FIND_PUBLIC_KEY_BY_HOST,
+};
+
 PeerDB::PeerDB(const std::shared_ptr<db::DBFile>& db) : db(db) {}
 
 void PeerDB::init()
@@ -19,40 +33,38 @@ void PeerDB::init()
     db->exec(R"(
         CREATE INDEX IF NOT EXISTS idx_peers_public_key ON peers(public_key);
     )");
+
+    for (const char* sql : PREPARED_STATEMENTS) db->prepare(sql);
 }
 
 void PeerDB::getAllPeers(std::vector<UserPeer>& peers)
 {
-    db->select("SELECT host, port, public_key FROM peers;",
-               [&peers](const std::vector<std::string>& row)
-               {
-                   if (row.size() == 3) peers.emplace_back(row[0], std::stoi(row[1]), row[2]);
-               });
+    db->selectRows(SQL_ALL_PEERS,
+                   {},
+                   [&peers](const db::Row& row)
+                   {
+                       peers.emplace_back(row.getString(0),
+                                          static_cast<unsigned short>(row.getInt64(1)),
+                                          row.getString(2));
+                   });
 }
 
 void PeerDB::addPeer(const UserPeer& peer)
 {
     bool found = false;
-    db->selectPrepared("SELECT id FROM peers WHERE public_key=? LIMIT 1;",
-                       { peer.publicKey },
-                       [&found](const std::vector<std::string>& row)
-                       {
-                           if (!row.empty()) found = true;
-                       });
+    db->selectRows(
+        SQL_FIND_PEER_ID, { peer.publicKey }, [&found](const db::Row&) { found = true; });
 
     if (!found)
-        db->executePrepared("INSERT INTO peers(host, port, public_key) VALUES (?,?,?);",
+        db->executePrepared(SQL_INSERT_PEER,
                             { peer.host, std::to_string(peer.port), peer.publicKey });
 }
 
 bool PeerDB::findPublicKeyByUserHost(const UserHost& host, std::string& publicKey)
 {
-    db->selectPrepared("SELECT public_key FROM peers WHERE host=? AND port=? LIMIT 1;",
-                       { host.host, std::to_string(host.port) },
-                       [&publicKey](const std::vector<std::string>& row)
-                       {
-                           if (!row.empty()) publicKey = row[0];
-                       });
+    db->selectRows(SQL_FIND_PUBLIC_KEY_BY_HOST,
+                   { host.host, std::to_string(host.port) },
+                   [&publicKey](const db::Row& row) { publicKey = row.getText(0); });
 
     return !publicKey.empty();
 }
@@ -0,0 +1,145 @@
+#include "WorkerPool.hpp"
+
+namespace concurrency
+{
+void WorkerPool::workerLoop()
+{
+    while (true)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            hasWork.wait(lock, [this]() { return stopping || !queue.empty(); });
+
+            if (queue.empty()) return;  // stopping and fully drained
+
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        task();
+    }
+}
+
+void WorkerPool::runStrand(uint64_t key)
+{
+    Task task;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::deque<Task>& strand = strands[key];
+
+        task = std::move(strand.front());
+        strand.pop_front();
+    }
+
+    runTask(task);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = strands.find(key);
+
+    // requeue instead of looping, so one busy key does not starve the others
+    if (it->second.empty())
+        strands.erase(it);
+    else
+    {
+        queue.push_back([this, key]() { runStrand(key); });
+        hasWork.notify_one();
+    }
+}
+
+void WorkerPool::runTask(const Task& task)
+{
+    try
+    {
+        task();
+    }
+    catch (...)
+    {
+        // a failing task must not kill the worker, errors are the task's own business
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    --pending;
+    hasSpace.notify_one();
+}
+
+WorkerPool::WorkerPool(size_t workerCount, size_t maxPending) : maxPending(maxPending)
+{
+    if (workerCount == 0) workerCount = 1;
+
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i)
+    {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() { shutdown(); }
+
+void WorkerPool::enqueue(Task task)
+{
+    ++pending;
+    queue.push_back([this, task = std::move(task)]() { runTask(task); });
+    hasWork.notify_one();
+}
+
+bool WorkerPool::submit(Task task)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    hasSpace.wait(lock, [this]() { return stopping || pending < maxPending; });
+    if (stopping) return false;
+
+    enqueue(std::move(task));
+    return true;
+}
+
+bool WorkerPool::trySubmit(Task task)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopping || pending >= maxPending) return false;
+
+    enqueue(std::move(task));
+    return true;
+}
+
+bool WorkerPool::submit(uint64_t key, Task task)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    hasSpace.wait(lock, [this]() { return stopping || pending < maxPending; });
+    if (stopping) return false;
+
+    ++pending;
+
+    // a strand exists while some task with this key is queued or running, just wait in line
+    auto it = strands.find(key);
+    if (it != strands.end())
+    {
+        it->second.push_back(std::move(task));
+        return true;
+    }
+
+    strands[key].push_back(std::move(task));
+    queue.push_back([this, key]() { runStrand(key); });
+    hasWork.notify_one();
+
+    return true;
+}
+
+void WorkerPool::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping && workers.empty()) return;
+        stopping = true;
+    }
+    hasWork.notify_all();
+    hasSpace.notify_all();
+
+    for (auto& worker : workers)
+    {
+        if (worker.joinable()) worker.join();
+    }
+    workers.clear();
+}
+
+size_t WorkerPool::size() const { return workers.size(); }
+}  // namespace concurrency
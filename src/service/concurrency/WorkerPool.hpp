@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace concurrency
+{
+// fixed set of worker threads with a bounded task queue.
+// Tasks submitted with the same key run one at a time in submission order, different keys run in
+// parallel
+class WorkerPool
+{
+private:
+    using Task = std::function<void()>;
+
+    std::vector<std::thread> workers;
+    std::deque<Task> queue;                                // tasks ready to be picked by a worker
+    std::unordered_map<uint64_t, std::deque<Task>> strands;  // keyed tasks waiting for their turn
+    std::mutex mutex;
+    std::condition_variable hasWork;
+    std::condition_variable hasSpace;
+    size_t maxPending;
+    size_t pending = 0;  // submitted but not yet finished tasks
+    bool stopping = false;
+
+    void workerLoop();
+    void runStrand(uint64_t key);
+    void runTask(const Task& task);
+    // caller holds mutex and checked that there is space
+    void enqueue(Task task);
+
+public:
+    WorkerPool(size_t workerCount, size_t maxPending);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // block while the queue is full, return false once the pool is shut down
+    bool submit(Task task);
+    bool submit(uint64_t key, Task task);
+    // return false instead of waiting when the queue is full
+    bool trySubmit(Task task);
+
+    // run everything already queued and join the workers
+    void shutdown();
+    size_t size() const;
+};
+}  // namespace concurrency
@@ -12,6 +12,14 @@ struct KeyPair
     Bytes privateKey;
 };
 
+// one independent signature check of a batch
+struct SignatureCheck
+{
+    Bytes message;
+    Bytes signature;
+    Bytes publicKey;
+};
+
 class ICrypto
 {
 public:
@@ -24,11 +32,20 @@ public:
     virtual Bytes stringToKey(const std::string& s) = 0;
 
     virtual Bytes createSessionKey(const Bytes& privateKey, const Bytes& peerPublicKey) = 0;
+    // session keys may be cached per key pair, these drop (and wipe) the cached ones
+    virtual void forgetSessionKeys(const Bytes& peerPublicKey) = 0;
+    virtual void clearSessionKeys() = 0;
 
     virtual Bytes encrypt(const Bytes& message, const Bytes& key) = 0;
     virtual Bytes decrypt(const Bytes& cipher, const Bytes& key) = 0;
+    // same as above, but write into out and reuse its capacity; out must not alias the input
+    virtual void encryptInto(const Bytes& message, const Bytes& key, Bytes& out) = 0;
+    virtual void decryptInto(const Bytes& cipher, const Bytes& key, Bytes& out) = 0;
 
     virtual Bytes sign(const Bytes& message, const Bytes& privateKey) = 0;
     virtual bool verify(const Bytes& message, const Bytes& signature, const Bytes& publicKey) = 0;
+    // results[i] tells whether checks[i] holds, implementations may verify in parallel
+    virtual void verifyBatch(const std::vector<SignatureCheck>& checks,
+                             std::vector<bool>& results) = 0;
 };
 }  // namespace crypto
\ No newline at end of file
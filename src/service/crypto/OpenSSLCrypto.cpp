@@ -1,6 +1,7 @@
 #include "OpenSSLCrypto.hpp"
 
 #include <openssl/buffer.h>
+#include <openssl/crypto.h>
 #include <openssl/ec.h>
 #include <openssl/evp.h>
 #include <openssl/kdf.h>
@@ -8,11 +9,19 @@
 #include <openssl/rand.h>
 #include <openssl/sha.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 
+#include "../utils/base64.hpp"
 #include "../utils/hex.hpp"
+#include "../utils/sha256.hpp"
+#include "WorkerPool.hpp"
 
 namespace crypto
 {
@@ -57,7 +66,8 @@ std::string OpenSSLCrypto::pemFromEVP(EVP_PKEY* pkey, bool pub) noexcept
     return s;
 }
 
-// parse PEM string to OpenSSL EVP_PKEY, try private first, then public
+// parse PEM string to OpenSSL EVP_PKEY, public keys are recognized by their PEM header,
+// anything else is tried as a private key first, then as a public one
 EVP_PKEY* OpenSSLCrypto::evpFromPem(const std::string& pem) noexcept
 {
     if (pem.empty()) return nullptr;
@@ -66,155 +76,184 @@ EVP_PKEY* OpenSSLCrypto::evpFromPem(const std::string& pem) noexcept
     BIO* bio = BIO_new_mem_buf(pem.data(), static_cast<int>(pem.size()));
     if (!bio) return nullptr;
 
-    // first try to read private key
-    EVP_PKEY* pkey = PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr);
-    if (pkey)
+    if (pem.find("-----BEGIN PUBLIC KEY-----") == std::string::npos)
     {
-        BIO_free(bio);
-        return pkey;
-    }
+        EVP_PKEY* pkey = PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr);
+        if (pkey)
+        {
+            BIO_free(bio);
+            return pkey;
+        }
 
-    BIO_free(bio);  // free old buffer in case of error
-    bio = BIO_new_mem_buf(pem.data(), static_cast<int>(pem.size()));
-    if (!bio) return nullptr;
+        BIO_free(bio);  // free old buffer in case of error
+        bio = BIO_new_mem_buf(pem.data(), static_cast<int>(pem.size()));
+        if (!bio) return nullptr;
+    }
 
-    pkey = PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);  // try to read public key
+    EVP_PKEY* pkey = PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);  // read public key
     BIO_free(bio);
     return pkey;  // may be nullptr
 }
 
-// encrypt message with AES-256-GCM
-// Advanced Encryption Standard (AES) is a symmetric block cipher
-// symmetric means that the same key uses for encryption and decryption
-// AES-256-GCM - creates 256-bit AES key for encryption and 128-bit GCM tag for authentication
-Bytes OpenSSLCrypto::aes_gcm_encrypt(const Bytes& key, const Bytes& plain)
+namespace
 {
-    const size_t IV_LEN = 12;   // initialization vector (IV) length - unique for each encryption
-    const size_t TAG_LEN = 16;  // tag length - confirms data integrity
-    Bytes iv = generateSecret(IV_LEN);
-    Bytes tag(TAG_LEN);
+// cache key of a PEM
+utils::Digest pemDigest(const Bytes& pem)
+{
+    return utils::sha256Digest(
+        std::string_view(reinterpret_cast<const char*>(pem.data()), pem.size()));
+}
+}  // namespace
 
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();  // create encryption OpenSSL context
-    if (!ctx) throw std::runtime_error("EVP_CIPHER_CTX_new failed");
+// parsed key from the cache, PEM is parsed only the first time a key is seen
+OpenSSLCrypto::KeyHandle OpenSSLCrypto::loadKey(const Bytes& pem)
+{
+    std::string keyPem(pem.begin(), pem.end());
+    PemDigest id = pemDigest(pem);
 
-    // initialize encryption context with AES-256-GCM algorithm
-    int rc = EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, nullptr, nullptr);
-    if (rc != 1)
     {
-        EVP_CIPHER_CTX_free(ctx);  // free context in case of error
-        throw std::runtime_error("EncryptInit failed");
+        std::lock_guard<std::mutex> lock(keysMutex);
+        auto it = keys.find(id);
+        if (it != keys.end())
+        {
+            keyOrder.splice(keyOrder.begin(), keyOrder, it->second.second);  // mark as used
+            return it->second.first;
+        }
     }
 
-    // set length of initialization vector
-    if (1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, static_cast<int>(IV_LEN), nullptr))
+    // parse outside the lock, two threads may parse the same key but only one is kept
+    KeyHandle handle(evpFromPem(keyPem), EVP_PKEY_free);
+    if (!handle.get()) return nullptr;  // invalid keys are not cached
+
+    std::lock_guard<std::mutex> lock(keysMutex);
+    auto it = keys.find(id);
+    if (it != keys.end()) return it->second.first;
+
+    if (keys.size() >= MAX_CACHED_KEYS)
     {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("set_ivlen failed");
+        keys.erase(keyOrder.back());
+        keyOrder.pop_back();
     }
-    // set key and initialization vector
-    if (1 != EVP_EncryptInit_ex(ctx, nullptr, nullptr, key.data(), iv.data()))
+    keyOrder.push_front(id);
+    keys.emplace(id, KeyEntry(handle, keyOrder.begin()));
+
+    return handle;
+}
+
+size_t OpenSSLCrypto::cachedKeysCount()
+{
+    std::lock_guard<std::mutex> lock(keysMutex);
+    return keys.size();
+}
+
+namespace
+{
+const size_t GCM_IV_LEN = 12;   // initialization vector (IV) length - unique for each encryption
+const size_t GCM_TAG_LEN = 16;  // tag length - confirms data integrity
+
+// AES-256-GCM contexts of the calling thread: the cipher is set up once,
+// every message only sets its key and IV, so no context is allocated per message
+struct GcmContexts
+{
+    // owned by unique_ptr, so a constructor that throws still frees what it allocated
+    using CipherContext = std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)>;
+
+    CipherContext encrypt{ EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free };
+    CipherContext decrypt{ EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free };
+
+    GcmContexts()
     {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("set_key_iv failed");
+        if (!encrypt || !decrypt) throw std::runtime_error("EVP_CIPHER_CTX_new failed");
+
+        if (1 != EVP_EncryptInit_ex(encrypt.get(), EVP_aes_256_gcm(), nullptr, nullptr, nullptr) ||
+            1 != EVP_DecryptInit_ex(decrypt.get(), EVP_aes_256_gcm(), nullptr, nullptr, nullptr))
+            throw std::runtime_error("GCM init failed");
+
+        int ivLen = static_cast<int>(GCM_IV_LEN);
+        if (1 != EVP_CIPHER_CTX_ctrl(encrypt.get(), EVP_CTRL_GCM_SET_IVLEN, ivLen, nullptr) ||
+            1 != EVP_CIPHER_CTX_ctrl(decrypt.get(), EVP_CTRL_GCM_SET_IVLEN, ivLen, nullptr))
+            throw std::runtime_error("set_ivlen failed");
     }
 
-    Bytes cipher(plain.size());
+    GcmContexts(const GcmContexts&) = delete;
+    GcmContexts& operator=(const GcmContexts&) = delete;
+};
+
+GcmContexts& threadGcmContexts()
+{
+    thread_local GcmContexts contexts;
+    return contexts;
+}
+}  // namespace
+
+// encrypt message with AES-256-GCM
+// Advanced Encryption Standard (AES) is a symmetric block cipher
+// symmetric means that the same key uses for encryption and decryption
+// AES-256-GCM - creates 256-bit AES key for encryption and 128-bit GCM tag for authentication
+void OpenSSLCrypto::aes_gcm_encrypt(const Bytes& key, const Bytes& plain, Bytes& out)
+{
+    EVP_CIPHER_CTX* ctx = threadGcmContexts().encrypt.get();
+
+    out.resize(GCM_IV_LEN + GCM_TAG_LEN + plain.size());  // IV(12)|tag(16)|cipher
+    uint8_t* iv = out.data();
+    uint8_t* tag = iv + GCM_IV_LEN;
+    uint8_t* cipher = tag + GCM_TAG_LEN;
+
+    if (1 != RAND_bytes(iv, static_cast<int>(GCM_IV_LEN)))
+        throw std::runtime_error("RAND_bytes failed");
+
+    // set key and initialization vector, the cipher is kept from the previous message
+    if (1 != EVP_EncryptInit_ex(ctx, nullptr, nullptr, key.data(), iv))
+        throw std::runtime_error("set_key_iv failed");
+
     int outlen = 0;
     // encrypt data
-    if (1 != EVP_EncryptUpdate(
-                 ctx, cipher.data(), &outlen, plain.data(), static_cast<int>(plain.size())))
-    {
-        EVP_CIPHER_CTX_free(ctx);
+    if (1 != EVP_EncryptUpdate(ctx, cipher, &outlen, plain.data(), static_cast<int>(plain.size())))
         throw std::runtime_error("EncryptUpdate failed");
-    }
-    int cipher_len = outlen;
-    if (1 != EVP_EncryptFinal_ex(ctx, cipher.data() + outlen, &outlen))  // finalize encryption
-    {
-        EVP_CIPHER_CTX_free(ctx);
+
+    int finalLen = 0;  // GCM is a stream mode, nothing is left for the final block
+    if (1 != EVP_EncryptFinal_ex(ctx, cipher + outlen, &finalLen))  // finalize encryption
         throw std::runtime_error("EncryptFinal failed");
-    }
-    cipher_len += outlen;
-    cipher.resize(cipher_len);
 
     // get authentication tag, it computes automatically while encrypting
-    if (1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, static_cast<int>(TAG_LEN), tag.data()))
-    {
-        EVP_CIPHER_CTX_free(ctx);
+    if (1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, static_cast<int>(GCM_TAG_LEN), tag))
         throw std::runtime_error("GetTag failed");
-    }
-
-    EVP_CIPHER_CTX_free(ctx);
-
-    Bytes out;
-    out.reserve(iv.size() + tag.size() + cipher.size());
-    out.insert(out.end(), iv.begin(), iv.end());          // IV
-    out.insert(out.end(), tag.begin(), tag.end());        // tag
-    out.insert(out.end(), cipher.begin(), cipher.end());  // cypher-text
-
-    return out;  // IV(12)|tag(16)|cipher
 }
 
 // decrypt message with AES-256-GCM
-Bytes OpenSSLCrypto::aes_gcm_decrypt(const Bytes& key, const Bytes& in)
+void OpenSSLCrypto::aes_gcm_decrypt(const Bytes& key, const Bytes& in, Bytes& out)
 {
-    const size_t IV_LEN = 12, TAG_LEN = 16;
-    if (in.size() < IV_LEN + TAG_LEN) throw std::runtime_error("cipher too short");
-
-    // parse IV, tag and cipher-text
-    Bytes iv(in.begin(), in.begin() + IV_LEN);
-    Bytes tag(in.begin() + IV_LEN, in.begin() + IV_LEN + TAG_LEN);
-    Bytes cipher(in.begin() + IV_LEN + TAG_LEN, in.end());
-
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();  // create decryption OpenSSL context
-    if (!ctx) throw std::runtime_error("EVP_CIPHER_CTX_new failed");
-    if (1 != EVP_DecryptInit_ex(
-                 ctx, EVP_aes_256_gcm(), nullptr, nullptr, nullptr))  // init decryption context
-    {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("DecryptInit failed");
-    }
-    if (1 !=
-        EVP_CIPHER_CTX_ctrl(
-            ctx, EVP_CTRL_GCM_SET_IVLEN, static_cast<int>(iv.size()), nullptr))  // set IV length
-    {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("set_ivlen failed");
-    }
-    if (1 != EVP_DecryptInit_ex(ctx, nullptr, nullptr, key.data(), iv.data()))
-    {  // set key and IV
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("set_key_iv failed");
-    }
+    if (in.size() < GCM_IV_LEN + GCM_TAG_LEN) throw std::runtime_error("cipher too short");
+
+    // parse IV, tag and cipher-text in place
+    const uint8_t* iv = in.data();
+    const uint8_t* tag = iv + GCM_IV_LEN;
+    const uint8_t* cipher = tag + GCM_TAG_LEN;
+    int cipherLen = static_cast<int>(in.size() - GCM_IV_LEN - GCM_TAG_LEN);
+
+    EVP_CIPHER_CTX* ctx = threadGcmContexts().decrypt.get();
+    if (1 != EVP_DecryptInit_ex(ctx, nullptr, nullptr, key.data(), iv))
+        throw std::runtime_error("set_key_iv failed");  // set key and IV
 
-    Bytes out(cipher.size());
+    out.resize(cipherLen);
     int outlen = 0;
-    if (1 != EVP_DecryptUpdate(ctx,
-                               out.data(),
-                               &outlen,
-                               cipher.data(),
-                               static_cast<int>(cipher.size())))  // data decryption
-    {
-        EVP_CIPHER_CTX_free(ctx);
+    if (1 != EVP_DecryptUpdate(ctx, out.data(), &outlen, cipher, cipherLen))  // data decryption
         throw std::runtime_error("DecryptUpdate failed");
-    }
+
     int total = outlen;
     if (1 != EVP_CIPHER_CTX_ctrl(
-                 ctx, EVP_CTRL_GCM_SET_TAG, static_cast<int>(tag.size()), (void*)tag.data()))
-    {  // set tag
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("SetTag failed");
-    }
+                 ctx, EVP_CTRL_GCM_SET_TAG, static_cast<int>(GCM_TAG_LEN), (void*)tag))
+        throw std::runtime_error("SetTag failed");  // set tag
+
+    // finalize decryption and tag checking (authentication)
     if (1 != EVP_DecryptFinal_ex(ctx, out.data() + outlen, &outlen))
-    {  // finalize decryption and tag checking (authentication)
-        EVP_CIPHER_CTX_free(ctx);
+    {
+        out.clear();  // never hand out plaintext that failed authentication
         throw std::runtime_error("DecryptFinal - tag mismatch");
     }
 
     total += outlen;
     out.resize(total);  // resize output to actual size
-    EVP_CIPHER_CTX_free(ctx);
-
-    return out;
 }
 
 OpenSSLCrypto::OpenSSLCrypto()
@@ -223,6 +262,12 @@ OpenSSLCrypto::OpenSSLCrypto()
     OPENSSL_init_crypto(0, nullptr);
 }
 
+OpenSSLCrypto::~OpenSSLCrypto()
+{
+    if (verifyPool) verifyPool->shutdown();
+    clearSessionKeys();
+}
+
 // cryptographically secure pseudorandom generator
 // depends on system entropy
 Bytes OpenSSLCrypto::generateSecret(size_t bytes)
@@ -238,49 +283,13 @@ Bytes OpenSSLCrypto::generateSecret(size_t bytes)
 
 // convert binary key to base64
 // base64 - data view format to converting binary to string
-std::string OpenSSLCrypto::keyToString(const Bytes& k)
-{
-    if (k.empty()) return {};
-
-    BIO* bio = BIO_new(BIO_s_mem());     // create OpenSSL memory buffer
-    BIO* b64 = BIO_new(BIO_f_base64());  // create BIO-filter for base64
+std::string OpenSSLCrypto::keyToString(const Bytes& k) { return utils::toBase64(k); }
 
-    bio = BIO_push(b64, bio);  // add b64 filter to buffer
-
-    BIO_set_flags(bio, BIO_FLAGS_BASE64_NO_NL);            // set `without newlines` flag
-    BIO_write(bio, k.data(), static_cast<int>(k.size()));  // filter and write binary data
-    BIO_flush(bio);                                        // commit writing (already base64)
-
-    BUF_MEM* bufferPtr;
-    BIO_get_mem_ptr(bio, &bufferPtr);  // get pointer to decoded base64 buffer
-
-    std::string encoded(bufferPtr->data, bufferPtr->length);  // copy cleared buffer
-    BIO_free_all(bio);                                        // free buffer
-
-    return encoded;
-}
-
-// convert base64 string to binary
+// convert base64 string to binary, empty if s is not valid base64
 Bytes OpenSSLCrypto::stringToKey(const std::string& s)
 {
-    if (s.empty()) return {};
-
-    BIO* bio =
-        BIO_new_mem_buf(s.data(), static_cast<int>(s.size()));  // create memory buffer from string
-    BIO* b64 = BIO_new(BIO_f_base64());                         // create BIO-filter for base64
-
-    bio = BIO_push(b64, bio);  // add b64 filter to buffer
-
-    BIO_set_flags(bio, BIO_FLAGS_BASE64_NO_NL);  // set `without newlines` flag
-
-    Bytes decoded(s.size());  // reserve memory
-    int len = BIO_read(
-        bio, decoded.data(), static_cast<int>(decoded.size()));  // read base64 and filter to binary
-    BIO_free_all(bio);
-
-    if (len < 0) len = 0;
-
-    decoded.resize(len);  // resize to actual size (cutting off the excess)
+    Bytes decoded;
+    utils::fromBase64(s, decoded);
     return decoded;
 }
 
@@ -330,46 +339,95 @@ KeyPair OpenSSLCrypto::generateKeyPair()
     return kp;
 }
 
+// session key for the pair of keys, ECDH + HKDF run only the first time the pair is seen
+Bytes OpenSSLCrypto::createSessionKey(const Bytes& privateKeyPem, const Bytes& peerPublicPem)
+{
+    SessionKeyId id(pemDigest(privateKeyPem), pemDigest(peerPublicPem));
+
+    {
+        std::lock_guard<std::mutex> lock(sessionKeysMutex);
+        auto it = sessionKeys.find(id);
+        if (it != sessionKeys.end())
+        {
+            sessionKeyOrder.splice(sessionKeyOrder.begin(), sessionKeyOrder, it->second.second);
+            return it->second.first;
+        }
+    }
+
+    Bytes key = deriveSessionKey(privateKeyPem, peerPublicPem);  // throws on invalid keys
+
+    std::lock_guard<std::mutex> lock(sessionKeysMutex);
+    if (sessionKeys.count(id)) return key;  // derived by another thread meanwhile
+
+    if (sessionKeys.size() >= MAX_CACHED_SESSION_KEYS)
+        eraseSessionKey(sessionKeys.find(sessionKeyOrder.back()));
+
+    sessionKeyOrder.push_front(id);
+    sessionKeys.emplace(id, SessionKeyEntry(key, sessionKeyOrder.begin()));
+
+    return key;
+}
+
+void OpenSSLCrypto::eraseSessionKey(std::map<SessionKeyId, SessionKeyEntry>::iterator it)
+{
+    Bytes& key = it->second.first;
+    OPENSSL_cleanse(key.data(), key.size());  // not optimized away unlike memset
+
+    sessionKeyOrder.erase(it->second.second);
+    sessionKeys.erase(it);
+}
+
+void OpenSSLCrypto::forgetSessionKeys(const Bytes& peerPublicKey)
+{
+    PemDigest peerId = pemDigest(peerPublicKey);
+
+    std::lock_guard<std::mutex> lock(sessionKeysMutex);
+    for (auto it = sessionKeys.begin(); it != sessionKeys.end();)
+    {
+        auto current = it++;
+        if (current->first.second == peerId) eraseSessionKey(current);
+    }
+}
+
+void OpenSSLCrypto::clearSessionKeys()
+{
+    std::lock_guard<std::mutex> lock(sessionKeysMutex);
+    while (!sessionKeys.empty()) eraseSessionKey(sessionKeys.begin());
+}
+
+size_t OpenSSLCrypto::cachedSessionKeysCount()
+{
+    std::lock_guard<std::mutex> lock(sessionKeysMutex);
+    return sessionKeys.size();
+}
+
 // create common session key (for A <-> B connection)
 // Diffie-Hellman (DH) - a method that allows 2 peers to create shared secret key over an unsecured
 // channel
 // Elliptic Curve Diffie-Hellman (ECDH) - an extension of DH that uses elliptic curve cryptography
 // HMAC-based Key Derivation Function (HKDF) - a key derivation function (функция формирования
 // ключа), generate ECDH shared key and make it stable
-Bytes OpenSSLCrypto::createSessionKey(const Bytes& privateKeyPem, const Bytes& peerPublicPem)
+Bytes OpenSSLCrypto::deriveSessionKey(const Bytes& privateKeyPem, const Bytes& peerPublicPem)
 {
     // parse keys to EVP_PKEY objects
-    EVP_PKEY* minePriv = evpFromPem(std::string(privateKeyPem.begin(), privateKeyPem.end()));
-    EVP_PKEY* peerPublic = evpFromPem(std::string(peerPublicPem.begin(), peerPublicPem.end()));
-    if (!minePriv || !peerPublic)
-    {
-        if (minePriv) EVP_PKEY_free(minePriv);
-        if (peerPublic) EVP_PKEY_free(peerPublic);
-        throw std::runtime_error("Invalid PEM keys");
-    }
+    KeyHandle minePriv = loadKey(privateKeyPem);
+    KeyHandle peerPublic = loadKey(peerPublicPem);
+    if (!minePriv || !peerPublic) throw std::runtime_error("Invalid PEM keys");
 
     // 1. ECDH - calculate common secret
 
-    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(minePriv, nullptr);  // create key derivation context
+    // create key derivation context
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(minePriv.get(), nullptr);
     // EVP_PKEY includes information about key generation algorithm (EC P-256)
-    if (!ctx)
-    {
-        EVP_PKEY_free(minePriv);
-        EVP_PKEY_free(peerPublic);
-        throw std::runtime_error("EVP_PKEY_CTX_new failed");
-    }
+    if (!ctx) throw std::runtime_error("EVP_PKEY_CTX_new failed");
 
     if (1 != EVP_PKEY_derive_init(ctx))  // initialize key derivation
     {
-        EVP_PKEY_free(minePriv);
-        EVP_PKEY_free(peerPublic);
         EVP_PKEY_CTX_free(ctx);
         throw std::runtime_error("derive_init failed");
     }
-    if (1 != EVP_PKEY_derive_set_peer(ctx, peerPublic))  // set interlocutor's public key
+    if (1 != EVP_PKEY_derive_set_peer(ctx, peerPublic.get()))  // set interlocutor's public key
     {
-        EVP_PKEY_free(minePriv);
-        EVP_PKEY_free(peerPublic);
         EVP_PKEY_CTX_free(ctx);
         throw std::runtime_error("derive_set_peer failed");
     }
@@ -377,22 +435,16 @@ Bytes OpenSSLCrypto::createSessionKey(const Bytes& privateKeyPem, const Bytes& p
     size_t secret_len = 0;
     if (1 != EVP_PKEY_derive(ctx, nullptr, &secret_len))  // get secret length
     {
-        EVP_PKEY_free(minePriv);
-        EVP_PKEY_free(peerPublic);
         EVP_PKEY_CTX_free(ctx);
         throw std::runtime_error("derive_len failed");
     }
     std::vector<uint8_t> secret(secret_len);
     if (1 != EVP_PKEY_derive(ctx, secret.data(), &secret_len))  // get secret (ECDH shared secret)
     {
-        EVP_PKEY_free(minePriv);
-        EVP_PKEY_free(peerPublic);
         EVP_PKEY_CTX_free(ctx);
         throw std::runtime_error("derive failed");
     }
 
-    EVP_PKEY_free(minePriv);
-    EVP_PKEY_free(peerPublic);
     EVP_PKEY_CTX_free(ctx);
 
     // 2. HKDF - improve ECDH shared secret and make it stable
@@ -419,6 +471,7 @@ Bytes OpenSSLCrypto::createSessionKey(const Bytes& privateKeyPem, const Bytes& p
         EVP_PKEY_CTX_free(kctx);
         throw std::runtime_error("HKDF set key failed");
     }
+    OPENSSL_cleanse(secret.data(), secret.size());  // HKDF keeps its own copy
     size_t olen = out.size();
     if (1 != EVP_PKEY_derive(kctx, out.data(), &olen))  // derive (compute) final key
     {
@@ -432,14 +485,28 @@ Bytes OpenSSLCrypto::createSessionKey(const Bytes& privateKeyPem, const Bytes& p
 
 Bytes OpenSSLCrypto::encrypt(const Bytes& message, const Bytes& key)
 {
-    if (key.size() < 32) throw std::runtime_error("Key too short for AES-256-GCM");
-    return aes_gcm_encrypt(key, message);  // encrypt with AES-256-GCM
+    Bytes out;
+    encryptInto(message, key, out);
+    return out;
 }
 
 Bytes OpenSSLCrypto::decrypt(const Bytes& cipher, const Bytes& key)
+{
+    Bytes out;
+    decryptInto(cipher, key, out);
+    return out;
+}
+
+void OpenSSLCrypto::encryptInto(const Bytes& message, const Bytes& key, Bytes& out)
+{
+    if (key.size() < 32) throw std::runtime_error("Key too short for AES-256-GCM");
+    aes_gcm_encrypt(key, message, out);  // encrypt with AES-256-GCM
+}
+
+void OpenSSLCrypto::decryptInto(const Bytes& cipher, const Bytes& key, Bytes& out)
 {
     if (key.size() < 32) throw std::runtime_error("Key too short for AES-256-GCM");
-    return aes_gcm_decrypt(key, cipher);  // decrypt with AES-256-GCM
+    aes_gcm_decrypt(key, cipher, out);  // decrypt with AES-256-GCM
 }
 
 // create cryptographic signature, that contains information about sender and confirms data
@@ -448,28 +515,21 @@ Bytes OpenSSLCrypto::decrypt(const Bytes& cipher, const Bytes& key)
 // curves
 Bytes OpenSSLCrypto::sign(const Bytes& message, const Bytes& privateKey)
 {
-    EVP_PKEY* pkey = evpFromPem(std::string(
-        privateKey.begin(), privateKey.end()));  // convert private key PEM-string to EVP_PKEY
+    KeyHandle pkey = loadKey(privateKey);  // convert private key PEM-string to EVP_PKEY
     if (!pkey) throw std::runtime_error("invalid private key PEM");
 
     EVP_MD_CTX* md = EVP_MD_CTX_new();  // create message digest context for sign computing
-    if (!md)
-    {
-        EVP_PKEY_free(pkey);
-        throw std::runtime_error("EVP_MD_CTX_new failed");
-    }
+    if (!md) throw std::runtime_error("EVP_MD_CTX_new failed");
     // initialize MD context with SHA-256 hashing algorithm
-    if (1 != EVP_DigestSignInit(md, nullptr, EVP_sha256(), nullptr, pkey))
+    if (1 != EVP_DigestSignInit(md, nullptr, EVP_sha256(), nullptr, pkey.get()))
     {
         EVP_MD_CTX_free(md);
-        EVP_PKEY_free(pkey);
         throw std::runtime_error("DigestSignInit failed");
     }
     if (1 != EVP_DigestSignUpdate(
                  md, message.data(), message.size()))  // add data to sign and compute hash
     {
         EVP_MD_CTX_free(md);
-        EVP_PKEY_free(pkey);
         throw std::runtime_error("DigestSignUpdate failed");
     }
 
@@ -477,7 +537,6 @@ Bytes OpenSSLCrypto::sign(const Bytes& message, const Bytes& privateKey)
     if (1 != EVP_DigestSignFinal(md, nullptr, &sig_len))  // get signature length
     {
         EVP_MD_CTX_free(md);
-        EVP_PKEY_free(pkey);
         throw std::runtime_error("DigestSignFinal(len) failed");
     }
 
@@ -485,14 +544,11 @@ Bytes OpenSSLCrypto::sign(const Bytes& message, const Bytes& privateKey)
     if (1 != EVP_DigestSignFinal(md, sig.data(), &sig_len))  // get signature
     {
         EVP_MD_CTX_free(md);
-        EVP_PKEY_free(pkey);
         throw std::runtime_error("DigestSignFinal failed");
     }
     sig.resize(sig_len);  // resize signature
 
-    // free resources
     EVP_MD_CTX_free(md);
-    EVP_PKEY_free(pkey);
 
     return sig;
 }
@@ -501,27 +557,20 @@ Bytes OpenSSLCrypto::sign(const Bytes& message, const Bytes& privateKey)
 // check that the signature was created with a private key corresponding to this public key
 bool OpenSSLCrypto::verify(const Bytes& message, const Bytes& signature, const Bytes& publicKey)
 {
-    EVP_PKEY* pkey = evpFromPem(
-        std::string(publicKey.begin(), publicKey.end()));  // parse public key to EVP_PKEY struct
+    KeyHandle pkey = loadKey(publicKey);  // parse public key to EVP_PKEY struct
     if (!pkey) return false;
 
     EVP_MD_CTX* md = EVP_MD_CTX_new();  // create message digest context for signature verification
-    if (!md)
-    {
-        EVP_PKEY_free(pkey);
-        return false;
-    }
+    if (!md) return false;
     // initialize MD for verifying, using SHA-256 (same as for signing)
-    if (1 != EVP_DigestVerifyInit(md, nullptr, EVP_sha256(), nullptr, pkey))
+    if (1 != EVP_DigestVerifyInit(md, nullptr, EVP_sha256(), nullptr, pkey.get()))
     {
         EVP_MD_CTX_free(md);
-        EVP_PKEY_free(pkey);
         return false;
     }
     if (1 != EVP_DigestVerifyUpdate(md, message.data(), message.size()))  // add message to verify
     {
         EVP_MD_CTX_free(md);
-        EVP_PKEY_free(pkey);
         return false;
     }
     int rc = EVP_DigestVerifyFinal(md, signature.data(), signature.size());  // verify signature
@@ -530,8 +579,110 @@ bool OpenSSLCrypto::verify(const Bytes& message, const Bytes& signature, const B
     // rc < 0 - error
 
     EVP_MD_CTX_free(md);
-    EVP_PKEY_free(pkey);
 
     return rc == 1;
 }
-}  // namespace crypto
\ No newline at end of file
+
+// ECDSA checks are independent, large batches are split into chunks verified on a thread pool
+// while the calling thread takes the first chunk itself
+void OpenSSLCrypto::verifyBatch(const std::vector<SignatureCheck>& checks,
+                                std::vector<bool>& results)
+{
+    std::vector<uint8_t> valid(checks.size(), 0);  // vector<bool> can not be written in parallel
+    auto verifyChunk = [this, &checks, &valid](size_t begin)
+    {
+        size_t end = std::min(begin + VERIFY_BATCH_CHUNK, checks.size());
+        for (size_t i = begin; i < end; ++i)
+            valid[i] = verify(checks[i].message, checks[i].signature, checks[i].publicKey);
+    };
+
+    if (checks.size() <= VERIFY_BATCH_CHUNK)
+    {
+        verifyChunk(0);
+    }
+    else
+    {
+        {
+            std::lock_guard<std::mutex> lock(verifyPoolMutex);
+            if (!verifyPool)
+            {
+                size_t workers = std::max(1u, std::thread::hardware_concurrency());
+                verifyPool = std::make_unique<concurrency::WorkerPool>(workers, workers * 4);
+            }
+        }
+
+        // every queued task references the locals below, so this function waits for all of them
+        // even when a check throws, and rethrows the first error after that
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t remaining = 0;
+        std::exception_ptr failure;
+
+        auto runChunk = [&](size_t begin)
+        {
+            try
+            {
+                verifyChunk(begin);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!failure) failure = std::current_exception();
+            }
+        };
+
+        try
+        {
+            for (size_t begin = VERIFY_BATCH_CHUNK; begin < checks.size();
+                 begin += VERIFY_BATCH_CHUNK)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++remaining;
+                }
+
+                bool submitted = false;
+                try
+                {
+                    submitted = verifyPool->submit(
+                        [&, begin]()
+                        {
+                            runChunk(begin);
+
+                            std::lock_guard<std::mutex> lock(mutex);
+                            if (--remaining == 0) done.notify_one();
+                        });
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    --remaining;
+                    throw;
+                }
+
+                if (!submitted)  // pool is shutting down, verify here
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        --remaining;
+                    }
+                    runChunk(begin);
+                }
+            }
+
+            runChunk(0);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failure) failure = std::current_exception();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&remaining]() { return remaining == 0; });
+        if (failure) std::rethrow_exception(failure);
+    }
+
+    results.assign(valid.begin(), valid.end());
+}
+}  // namespace crypto
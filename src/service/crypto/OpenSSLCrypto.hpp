@@ -1,22 +1,75 @@
 #pragma once
 #include <openssl/evp.h>
 
+#include <array>
+#include <cstring>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
 #include "ICrypto.hpp"
 
+namespace concurrency
+{
+class WorkerPool;
+}
 
 namespace crypto
 {
+constexpr const size_t MAX_CACHED_KEYS = 256;  // least recently used keys are parsed again
+constexpr const size_t MAX_CACHED_SESSION_KEYS = 256;  // least recently used ones are derived again
+constexpr const size_t VERIFY_BATCH_CHUNK = 32;  // checks per pool task, smaller batches run inline
+
 class OpenSSLCrypto : public ICrypto
 {
 private:
+    using KeyHandle = std::shared_ptr<EVP_PKEY>;
+    // SHA-256 of a PEM, caches are keyed by it so they hold no private key text
+    using PemDigest = std::array<uint8_t, 32>;
+
+    struct PemDigestHasher
+    {
+        size_t operator()(const PemDigest& digest) const
+        {
+            size_t value;
+            std::memcpy(&value, digest.data(), sizeof(value));
+            return value;
+        }
+    };
+
+    // parsed keys keyed by their PEM digest, most recently used at the front of keyOrder.
+    // handles are shared, so a key evicted by one thread stays valid for the one using it
+    using KeyEntry = std::pair<KeyHandle, std::list<PemDigest>::iterator>;
+    std::list<PemDigest> keyOrder;
+    std::unordered_map<PemDigest, KeyEntry, PemDigestHasher> keys;
+    std::mutex keysMutex;
+
+    // derived session keys keyed by (our private PEM digest, peer public PEM digest),
+    // wiped when dropped
+    using SessionKeyId = std::pair<PemDigest, PemDigest>;
+    using SessionKeyEntry = std::pair<Bytes, std::list<SessionKeyId>::iterator>;
+    std::list<SessionKeyId> sessionKeyOrder;
+    std::map<SessionKeyId, SessionKeyEntry> sessionKeys;
+    std::mutex sessionKeysMutex;
+
+    std::unique_ptr<concurrency::WorkerPool> verifyPool;  // created on first large batch
+    std::mutex verifyPoolMutex;
+
     std::string pemFromEVP(EVP_PKEY* pkey, bool pub) noexcept;
     EVP_PKEY* evpFromPem(const std::string& pem) noexcept;
+    KeyHandle loadKey(const Bytes& pem);
+    Bytes deriveSessionKey(const Bytes& privateKeyPem, const Bytes& peerPublicPem);
+    // caller holds sessionKeysMutex
+    void eraseSessionKey(std::map<SessionKeyId, SessionKeyEntry>::iterator it);
 
-    Bytes aes_gcm_encrypt(const Bytes& key, const Bytes& plain);
-    Bytes aes_gcm_decrypt(const Bytes& key, const Bytes& in);
+    void aes_gcm_encrypt(const Bytes& key, const Bytes& plain, Bytes& out);
+    void aes_gcm_decrypt(const Bytes& key, const Bytes& in, Bytes& out);
 
 public:
     OpenSSLCrypto();
+    ~OpenSSLCrypto() override;
 
     Bytes generateSecret(size_t bytes = 32) override;
 
@@ -25,11 +78,20 @@ public:
     Bytes stringToKey(const std::string& s) override;
 
     Bytes createSessionKey(const Bytes& privateKey, const Bytes& peerPublicKey) override;
+    void forgetSessionKeys(const Bytes& peerPublicKey) override;
+    void clearSessionKeys() override;
 
     Bytes encrypt(const Bytes& message, const Bytes& key) override;
     Bytes decrypt(const Bytes& cipher, const Bytes& key) override;
+    void encryptInto(const Bytes& message, const Bytes& key, Bytes& out) override;
+    void decryptInto(const Bytes& cipher, const Bytes& key, Bytes& out) override;
 
     Bytes sign(const Bytes& message, const Bytes& privateKey) override;
     bool verify(const Bytes& message, const Bytes& signature, const Bytes& publicKey) override;
+    void verifyBatch(const std::vector<SignatureCheck>& checks,
+                     std::vector<bool>& results) override;
+
+    size_t cachedKeysCount();
+    size_t cachedSessionKeysCount();
 };
 }  // namespace crypto
\ No newline at end of file
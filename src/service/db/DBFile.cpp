@@ -4,14 +4,106 @@
 
 namespace db
 {
+namespace
+{
+// returns a statement to its initial state when a query is done, even if a row callback throws
+struct StatementGuard
+{
+    sqlite3_stmt* stmt;
+    bool cached;
+
+    ~StatementGuard()
+    {
+        if (cached)
+        {
+            sqlite3_reset(stmt);  // also releases the read transaction of a select
+            sqlite3_clear_bindings(stmt);
+        }
+        else
+            sqlite3_finalize(stmt);
+    }
+};
+}  // namespace
+
+Row::Row(sqlite3_stmt* stmt) : stmt(stmt) {}
+
+int Row::columnCount() const { return sqlite3_column_count(stmt); }
+
+bool Row::isNull(int column) const { return sqlite3_column_type(stmt, column) == SQLITE_NULL; }
+
+int64_t Row::getInt64(int column) const { return sqlite3_column_int64(stmt, column); }
+
+std::string_view Row::getText(int column) const
+{
+    const unsigned char* text = sqlite3_column_text(stmt, column);
+    if (!text) return std::string_view();
+
+    // size has to be read after sqlite3_column_text, which may convert the value
+    return std::string_view(reinterpret_cast<const char*>(text),
+                            static_cast<size_t>(sqlite3_column_bytes(stmt, column)));
+}
+
+std::string Row::getString(int column) const { return std::string(getText(column)); }
+
+const uint8_t* Row::getBlob(int column, size_t& size) const
+{
+    const void* blob = sqlite3_column_blob(stmt, column);
+    size = static_cast<size_t>(sqlite3_column_bytes(stmt, column));
+
+    return static_cast<const uint8_t*>(blob);
+}
+
+DBFile::Transaction::Transaction(DBFile& db) : db(db), lock(db.mutex), depth(db.transactionDepth)
+{
+    // IMMEDIATE takes the write lock up front instead of failing halfway through the batch
+    db.exec(depth == 0 ? "BEGIN IMMEDIATE;" : "SAVEPOINT batch_" + std::to_string(depth) + ";");
+    ++db.transactionDepth;
+}
+
+DBFile::Transaction::~Transaction()
+{
+    if (finished) return;
+
+    try
+    {
+        rollback();
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << "[DEBUG] DBFile transaction rollback failed: " << error.what() << "\n";
+    }
+}
+
+void DBFile::Transaction::commit()
+{
+    if (finished) return;
+
+    // a failed COMMIT leaves sqlite inside the transaction, the destructor still rolls it back
+    db.exec(depth == 0 ? "COMMIT;" : "RELEASE batch_" + std::to_string(depth) + ";");
+
+    finished = true;
+    --db.transactionDepth;
+}
+
+void DBFile::Transaction::rollback()
+{
+    if (finished) return;
+    finished = true;
+    --db.transactionDepth;
+
+    if (depth == 0)
+        db.exec("ROLLBACK;");
+    else
+        db.exec("ROLLBACK TO batch_" + std::to_string(depth) + "; RELEASE batch_" +
+                std::to_string(depth) + ";");
+}
+
 DBFile::DBFile(std::string dbPath) : path(dbPath) {}
 
 DBFile::~DBFile() { close(); }
 
-void DBFile::open()
+void DBFile::openDatabase()
 {
-    std::lock_guard<std::mutex> lock(mutex);
-
     if (db) return;
 
     int rc = sqlite3_open(path.c_str(), &db);  // open database
@@ -27,21 +119,82 @@ void DBFile::open()
     sqlite3_exec(db, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr);
 }
 
+void DBFile::open()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    openDatabase();
+}
+
 void DBFile::close()
 {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     if (db)
     {
-        sqlite3_close(db);  // close database
+        transactionDepth = 0;  // sqlite rolls back whatever is still open
+        finalizeStatements();  // sqlite3_close fails while statements are alive
+        sqlite3_close(db);     // close database
         db = nullptr;
     }
 }
 
+void DBFile::finalizeStatements()
+{
+    for (auto& entry : statements) sqlite3_finalize(entry.second);
+    statements.clear();
+}
+
+sqlite3_stmt* DBFile::findStatement(const std::string& sql, bool& cached)
+{
+    auto it = statements.find(sql);
+    if (it != statements.end())
+    {
+        cached = true;
+        return it->second;
+    }
+
+    sqlite3_stmt* stmt = nullptr;  // for sqlite params
+    int rc = sqlite3_prepare_v2(
+        db, sql.c_str(), -1, &stmt, nullptr);  // prepare sql and create statement (stmt)
+    if (rc != SQLITE_OK)
+    {
+        sqlite3_finalize(stmt);
+        return nullptr;
+    }
+
+    cached = statements.size() < MAX_CACHED_STATEMENTS;
+    if (cached) statements.emplace(sql, stmt);
+
+    return stmt;
+}
+
+void DBFile::prepare(const std::string& sql)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    openDatabase();
+
+    bool cached = false;
+    sqlite3_stmt* stmt = findStatement(sql, cached);
+    if (!stmt)
+    {
+        std::string err = sqlite3_errmsg(db);
+        throw std::runtime_error("DBFile prepare failed: " + err);
+    }
+
+    if (!cached) sqlite3_finalize(stmt);
+}
+
+size_t DBFile::cachedStatementsCount()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return statements.size();
+}
+
 void DBFile::exec(const std::string& sql)
 {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard<std::recursive_mutex> lock(mutex);
 
-    if (!db) open();
+    openDatabase();
 
     char* errMsg = nullptr;
     int rc = sqlite3_exec(
@@ -55,24 +208,11 @@ void DBFile::exec(const std::string& sql)
     }
 }
 
-void DBFile::select(const std::string& sql,
-                    const std::function<void(const std::vector<std::string>&)>& callback)
+void DBFile::readRows(sqlite3_stmt* stmt,
+                      const std::function<void(const std::vector<std::string>&)>& callback)
 {
-    std::lock_guard<std::mutex> lock(mutex);
-
-    if (!db) open();
-
-    sqlite3_stmt* stmt = nullptr;  // for sqlite params
-    int rc = sqlite3_prepare_v2(
-        db, sql.c_str(), -1, &stmt, nullptr);  // prepare sql and create statement (stmt)
-    if (rc != SQLITE_OK)
-    {
-        std::string err = sqlite3_errmsg(db);
-        throw std::runtime_error("DBFile select prepare failed: " + err);
-    }
-
     // execute all sql lines
-    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    while (sqlite3_step(stmt) == SQLITE_ROW)
     {
         int colCount = sqlite3_column_count(stmt);
         std::vector<std::string> row;
@@ -86,70 +226,95 @@ void DBFile::select(const std::string& sql,
 
         callback(row);
     }
+}
 
-    sqlite3_finalize(stmt);  // delete sqlite stmt
+void DBFile::select(const std::string& sql,
+                    const std::function<void(const std::vector<std::string>&)>& callback)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    openDatabase();
+
+    bool cached = false;
+    sqlite3_stmt* stmt = findStatement(sql, cached);
+    if (!stmt)
+    {
+        std::string err = sqlite3_errmsg(db);
+        throw std::runtime_error("DBFile select prepare failed: " + err);
+    }
+
+    StatementGuard guard{ stmt, cached };
+    readRows(stmt, callback);
 }
 
 void DBFile::selectPrepared(const std::string& sql,
                             const std::vector<std::string>& params,
                             const std::function<void(const std::vector<std::string>&)>& callback)
 {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard<std::recursive_mutex> lock(mutex);
 
-    if (!db) open();
+    openDatabase();
 
-    sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
-    if (rc != SQLITE_OK)
+    bool cached = false;
+    sqlite3_stmt* stmt = findStatement(sql, cached);
+    if (!stmt)
     {
         std::string err = sqlite3_errmsg(db);
         throw std::runtime_error("DBFile selectPrepared prepare failed: " + err);
     }
 
+    StatementGuard guard{ stmt, cached };
+
     // bind params safely
     bindParams(stmt, params);
+    readRows(stmt, callback);
+}
 
-    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
-    {
-        int colCount = sqlite3_column_count(stmt);
-        std::vector<std::string> row;
-        row.reserve(colCount);
+void DBFile::selectRows(const std::string& sql,
+                        const std::vector<std::string>& params,
+                        const std::function<void(const Row&)>& callback)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
 
-        for (int i = 0; i < colCount; ++i)
-        {
-            const unsigned char* text = sqlite3_column_text(stmt, i);
-            row.emplace_back(text ? reinterpret_cast<const char*>(text) : "");
-        }
+    openDatabase();
 
-        callback(row);
+    bool cached = false;
+    sqlite3_stmt* stmt = findStatement(sql, cached);
+    if (!stmt)
+    {
+        std::string err = sqlite3_errmsg(db);
+        throw std::runtime_error("DBFile selectRows prepare failed: " + err);
     }
 
-    sqlite3_finalize(stmt);
+    StatementGuard guard{ stmt, cached };
+
+    bindParams(stmt, params);
+
+    Row row(stmt);
+    while (sqlite3_step(stmt) == SQLITE_ROW) callback(row);
 }
 
 bool DBFile::executePrepared(const std::string& sql, const std::vector<std::string>& params)
 {
-    std::lock_guard<std::mutex> lock(mutex);
-
-    if (!db) open();
+    std::lock_guard<std::recursive_mutex> lock(mutex);
 
-    sqlite3_stmt* stmt = nullptr;
+    openDatabase();
 
-    int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
-    if (rc != SQLITE_OK)
+    bool cached = false;
+    sqlite3_stmt* stmt = findStatement(sql, cached);
+    if (!stmt)
     {
         std::cerr << "[DEBUG] DBFile executePrepared prepare failed: " << sqlite3_errmsg(db)
                   << "\n";
         return false;
     }
 
+    StatementGuard guard{ stmt, cached };
+
     // bind params safely
     bindParams(stmt, params);
 
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-
-    return rc == SQLITE_DONE;
+    return sqlite3_step(stmt) == SQLITE_DONE;
 }
 
 void DBFile::bindParams(sqlite3_stmt* stmt, const std::vector<std::string>& params)
@@ -166,7 +331,7 @@ void DBFile::bindParams(sqlite3_stmt* stmt, const std::vector<std::string>& para
 
 bool DBFile::isOpen()
 {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     return db != nullptr;
 }
-}  // namespace db
\ No newline at end of file
+}  // namespace db
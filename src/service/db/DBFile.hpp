@@ -1,29 +1,87 @@
 #pragma once
 #include <sqlite3.h>
 
+#include <cstdint>
 #include <functional>
 #include <mutex>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace db
 {
+constexpr const size_t MAX_CACHED_STATEMENTS = 128;  // beyond that statements are prepared per call
+
+// current row of a running query, reads columns straight from sqlite without copying.
+// views are valid only until the callback returns
+class Row
+{
+private:
+    sqlite3_stmt* stmt;
+
+public:
+    explicit Row(sqlite3_stmt* stmt);
+
+    int columnCount() const;
+    bool isNull(int column) const;
+    int64_t getInt64(int column) const;
+    std::string_view getText(int column) const;
+    std::string getString(int column) const;
+    const uint8_t* getBlob(int column, size_t& size) const;
+};
+
 class DBFile
 {
 private:
     std::string path;
     sqlite3* db = nullptr;
-    std::mutex mutex;
+    // recursive, so the thread that owns a Transaction can keep querying inside it
+    std::recursive_mutex mutex;
+    int transactionDepth = 0;
+    // compiled statements keyed by sql text, reset and rebound on every use
+    std::unordered_map<std::string, sqlite3_stmt*> statements;
+
+    // caller holds mutex
+    void openDatabase();
+    sqlite3_stmt* findStatement(const std::string& sql, bool& cached);
+    void finalizeStatements();
 
     void bindParams(sqlite3_stmt* stmt, const std::vector<std::string>& params);
+    void readRows(sqlite3_stmt* stmt,
+                  const std::function<void(const std::vector<std::string>&)>& callback);
 
 public:
+    // groups statements into one sqlite transaction, rolled back unless commit() is called.
+    // other threads wait until the transaction ends, nested ones become savepoints
+    class Transaction
+    {
+    private:
+        DBFile& db;
+        std::unique_lock<std::recursive_mutex> lock;
+        int depth;
+        bool finished = false;
+
+    public:
+        explicit Transaction(DBFile& db);
+        ~Transaction();
+
+        Transaction(const Transaction&) = delete;
+        Transaction& operator=(const Transaction&) = delete;
+
+        void commit();
+        void rollback();
+    };
+
     explicit DBFile(std::string dbPath);
     ~DBFile();
 
     void open();
     void close();
+    // compiles sql ahead of time, repositories register their statements in init()
+    void prepare(const std::string& sql);
+    size_t cachedStatementsCount();
     void exec(const std::string& sql);
     void select(const std::string& sql,
                 const std::function<void(const std::vector<std::string>&)>& callback);
@@ -31,6 +89,10 @@ public:
     void selectPrepared(const std::string& sql,
                         const std::vector<std::string>& params,
                         const std::function<void(const std::vector<std::string>&)>& callback);
+    // like selectPrepared, without building a vector of strings per row
+    void selectRows(const std::string& sql,
+                    const std::vector<std::string>& params,
+                    const std::function<void(const Row&)>& callback);
 
     bool isOpen();
 };
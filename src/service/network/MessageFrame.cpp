@@ -0,0 +1,83 @@
+#include "MessageFrame.hpp"
+
+#include <stdexcept>
+
+namespace network
+{
+void FrameBuffer::append(const char* data, size_t size)
+{
+    // drop already consumed frames before growing the buffer
+    if (offset > 0 && offset >= buffer.size() / 2)
+    {
+        buffer.erase(0, offset);
+        offset = 0;
+    }
+    buffer.append(data, size);
+}
+
+bool FrameBuffer::nextFrame(std::string& frame)
+{
+    if (buffer.size() - offset < FRAME_HEADER_SIZE) return false;
+
+    const unsigned char* header = reinterpret_cast<const unsigned char*>(buffer.data() + offset);
+    size_t payloadSize = (static_cast<size_t>(header[0]) << 24) |
+                         (static_cast<size_t>(header[1]) << 16) |
+                         (static_cast<size_t>(header[2]) << 8) | static_cast<size_t>(header[3]);
+
+    if (payloadSize > MAX_FRAME_SIZE) throw std::runtime_error("Frame is too big");
+    if (buffer.size() - offset - FRAME_HEADER_SIZE < payloadSize) return false;
+
+    frame.assign(buffer, offset + FRAME_HEADER_SIZE, payloadSize);
+    offset += FRAME_HEADER_SIZE + payloadSize;
+
+    if (offset == buffer.size())
+    {
+        buffer.clear();
+        offset = 0;
+    }
+    return true;
+}
+
+void FrameBuffer::clear()
+{
+    buffer.clear();
+    offset = 0;
+}
+
+bool FrameBuffer::empty() const { return buffer.size() == offset; }
+
+std::string encodeFrame(const std::string& payload)
+{
+    if (payload.size() > MAX_FRAME_SIZE) throw std::runtime_error("Message is too big");
+
+    size_t size = payload.size();
+    std::string frame;
+    frame.reserve(FRAME_HEADER_SIZE + size);
+    frame.push_back(static_cast<char>((size >> 24) & 0xFF));
+    frame.push_back(static_cast<char>((size >> 16) & 0xFF));
+    frame.push_back(static_cast<char>((size >> 8) & 0xFF));
+    frame.push_back(static_cast<char>(size & 0xFF));
+    frame += payload;
+
+    return frame;
+}
+
+bool sendFrame(SOCKET socket, const std::string& payload)
+{
+    std::string frame = encodeFrame(payload);
+
+    // send() may write only a part of the buffer, repeat until the whole frame is out
+    size_t sent = 0;
+    while (sent < frame.size())
+    {
+        int result = send(socket,
+                          frame.data() + sent,
+                          static_cast<int>(frame.size() - sent),
+                          SOCKET_SEND_FLAGS);
+        if (result == SOCKET_ERROR || result == 0) return false;
+
+        sent += static_cast<size_t>(result);
+    }
+    return true;
+}
+}  // namespace network
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "SocketPlatform.hpp"
+
+namespace network
+{
+// every message on the wire is sent as a frame: 4-byte payload length (network byte order)
+// followed by the payload itself, so a receiver knows where one message ends
+constexpr const size_t FRAME_HEADER_SIZE = 4;
+constexpr const size_t MAX_FRAME_SIZE = 64 * 1024 * 1024;  // sanity limit for a single message
+
+// streaming reassembly buffer: collects raw bytes from recv() and cuts them into frames
+class FrameBuffer
+{
+private:
+    std::string buffer;
+    size_t offset = 0;  // start of the first unread frame in buffer
+
+public:
+    void append(const char* data, size_t size);
+    bool nextFrame(std::string& frame);
+    void clear();
+    bool empty() const;
+};
+
+std::string encodeFrame(const std::string& payload);
+bool sendFrame(SOCKET socket, const std::string& payload);
+}  // namespace network
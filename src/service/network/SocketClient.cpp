@@ -31,7 +31,9 @@ SocketClient::SocketClient(SocketClient&& other) noexcept
       clientSocket(other.clientSocket),
       serverAddr(other.serverAddr),
       initialized(other.initialized),
-      connected(other.connected)
+      connected(other.connected),
+      closedByPeer(other.closedByPeer),
+      frameBuffer(std::move(other.frameBuffer))
 {
     other.clientSocket = INVALID_SOCKET;
     other.connected = false;
@@ -49,6 +51,8 @@ SocketClient& SocketClient::operator=(SocketClient&& other) noexcept
         serverAddr = other.serverAddr;
         initialized = other.initialized;
         connected = other.connected;
+        closedByPeer = other.closedByPeer;
+        frameBuffer = std::move(other.frameBuffer);
 
         other.clientSocket = INVALID_SOCKET;
         other.connected = false;
@@ -92,25 +96,37 @@ bool SocketClient::connectTo(const std::string& host, u_short port)
 bool SocketClient::sendMessage(const std::string& message)
 {
     if (!connected) return false;
-    int result = send(clientSocket, message.c_str(), static_cast<int>(message.size()), 0);
-    return result != SOCKET_ERROR;
+    return sendFrame(clientSocket, message);
 }
 
 std::string SocketClient::receiveMessage()
 {
     if (!connected) throw std::runtime_error("Not connected to server");
 
+    std::string message;
     char buffer[BUFFER_SIZE];
-    int bytes = recv(clientSocket, buffer, BUFFER_SIZE - 1, 0);
+    bool receivedAny = false;
+    closedByPeer = false;
 
-    if (bytes <= 0)
+    // read until the frame buffer holds one complete message
+    while (!frameBuffer.nextFrame(message))
     {
-        connected = false;
-        return "";
+        int bytes = recv(clientSocket, buffer, BUFFER_SIZE, 0);
+
+        if (bytes <= 0)
+        {
+            closedByPeer = bytes == 0 && !receivedAny;
+            connected = false;
+            frameBuffer.clear();
+            return "";
+        }
+
+        receivedAny = true;
+
+        frameBuffer.append(buffer, static_cast<size_t>(bytes));
     }
 
-    buffer[bytes] = '\0';
-    return std::string(buffer);
+    return message;
 }
 
 void SocketClient::disconnect()
@@ -121,10 +137,49 @@ void SocketClient::disconnect()
         clientSocket = INVALID_SOCKET;
     }
     connected = false;
+    frameBuffer.clear();
 }
 
 bool SocketClient::isConnected() const { return connected; }
 
+bool SocketClient::wasClosedByPeer() const { return closedByPeer; }
+
+bool SocketClient::isAlive()
+{
+    if (!connected) return false;
+
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(clientSocket, &readSet);
+    timeval timeout{ 0, 0 };
+
+    // nfds is ignored by Winsock, POSIX needs the highest descriptor + 1
+    int ready = select(static_cast<int>(clientSocket) + 1, &readSet, nullptr, nullptr, &timeout);
+    if (ready == SOCKET_ERROR) return false;
+    if (ready == 0) return true;  // nothing pending, connection is idle
+
+    // an idle connection is readable only if the server closed it (or sent something unexpected)
+    char byte;
+    if (recv(clientSocket, &byte, 1, MSG_PEEK) <= 0) connected = false;
+    return false;
+}
+
+bool SocketClient::setTimeout(u_int timeoutMs)
+{
+    if (clientSocket == INVALID_SOCKET) return false;
+
+#ifdef _WIN32
+    DWORD timeout = timeoutMs;
+#else
+    timeval timeout{ static_cast<time_t>(timeoutMs / 1000),
+                     static_cast<suseconds_t>((timeoutMs % 1000) * 1000) };
+#endif
+    const char* value = reinterpret_cast<const char*>(&timeout);
+
+    return setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO, value, sizeof(timeout)) == 0 &&
+           setsockopt(clientSocket, SOL_SOCKET, SO_SNDTIMEO, value, sizeof(timeout)) == 0;
+}
+
 unsigned short SocketClient::findFreePort()
 {
     WSADATA wsaData;
@@ -150,7 +205,7 @@ unsigned short SocketClient::findFreePort()
     }
 
     sockaddr_in boundAddr{};
-    int addrLen = sizeof(boundAddr);
+    socklen_t addrLen = sizeof(boundAddr);
     if (getsockname(tempSocket, reinterpret_cast<sockaddr*>(&boundAddr), &addrLen) == SOCKET_ERROR)
     {
         closesocket(tempSocket);
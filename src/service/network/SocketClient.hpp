@@ -1,11 +1,11 @@
 #pragma once
 
-#include <winsock2.h>
-#include <ws2tcpip.h>
-
 #include <stdexcept>
 #include <string>
 
+#include "MessageFrame.hpp"
+#include "SocketPlatform.hpp"
+
 namespace network
 {
 class SocketClient
@@ -19,6 +19,8 @@ protected:
     sockaddr_in serverAddr{};
     bool initialized = false;
     bool connected = false;
+    bool closedByPeer = false;
+    FrameBuffer frameBuffer;
 
 public:
     SocketClient();
@@ -36,6 +38,12 @@ public:
 
     void disconnect();
     bool isConnected() const;
+    // true if the last receiveMessage() failed because the peer closed the connection before
+    // sending any byte of the reply, false after a timeout or a partial reply
+    bool wasClosedByPeer() const;
+    // true if the connection is still open and has no unread data, used before reusing it
+    bool isAlive();
+    bool setTimeout(u_int timeoutMs);
 
     static u_short findFreePort();
 };
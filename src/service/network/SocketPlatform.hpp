@@ -0,0 +1,56 @@
+#pragma once
+
+// socket API of the current platform: Winsock on Windows, BSD sockets elsewhere.
+// On POSIX the few Winsock names used by the network layer are mapped onto their equivalents
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+constexpr const int SOCKET_SEND_FLAGS = 0;
+
+inline bool setNonBlocking(SOCKET socket)
+{
+    u_long mode = 1;
+    return ioctlsocket(socket, FIONBIO, &mode) == 0;
+}
+
+// last send/recv failed only because a non-blocking socket is not ready yet
+inline bool socketWouldBlock() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+using SOCKET = int;
+
+constexpr const SOCKET INVALID_SOCKET = -1;
+constexpr const int SOCKET_ERROR = -1;
+constexpr const int SOCKET_SEND_FLAGS = MSG_NOSIGNAL;  // report a closed peer as an error, not SIGPIPE
+
+struct WSADATA
+{
+};
+
+#ifndef MAKEWORD
+#define MAKEWORD(low, high) ((low) | ((high) << 8))
+#endif
+
+inline int WSAStartup(int, WSADATA*) { return 0; }
+inline int WSACleanup() { return 0; }
+inline int closesocket(SOCKET socket) { return close(socket); }
+constexpr const int SD_BOTH = SHUT_RDWR;
+
+inline bool setNonBlocking(SOCKET socket)
+{
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+inline bool socketWouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK; }
+#endif
@@ -1,60 +1,354 @@
 #include "SocketServer.hpp"
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+#include <iostream>
+
 namespace network
 {
-void SocketServer::listenMessages(MessageHandler onMessage)
+bool SocketServer::acceptConnection(SOCKET clientSocket)
 {
-    // listen max queued connections
-    if (listen(listenSocket, SOMAXCONN) == SOCKET_ERROR)
-        throw std::runtime_error("Failed to listen on socket");
+#ifndef __linux__
+    if (connections.size() >= MAX_CONNECTIONS)
+    {
+        closesocket(clientSocket);  // fd_set is full
+        return false;
+    }
+#endif
+    // the event loop never blocks on a single peer, unsent responses wait in outBuffer
+    if (!setNonBlocking(clientSocket))
+    {
+        closesocket(clientSocket);
+        return false;
+    }
+    Connection connection;
+    connection.id = nextConnectionId++;
+    connections.emplace(clientSocket, std::move(connection));
+    return true;
+}
 
-    isListening.store(true, std::memory_order_release);
+bool SocketServer::readConnection(SOCKET clientSocket)
+{
+    char buffer[BUFFER_SIZE];
+    int bytesReceived = recv(clientSocket, buffer, BUFFER_SIZE, 0);
 
-    while (isListening.load(std::memory_order_acquire))
+    if (bytesReceived == SOCKET_ERROR && socketWouldBlock()) return true;  // spurious wakeup
+    if (bytesReceived <= 0) return false;  // peer closed the connection or error
+
+    // one chunk may carry several pipelined requests, cut all of them out
+    std::vector<std::string> messages;
+    uint64_t connectionId = 0;
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        auto it = connections.find(clientSocket);
+        if (it == connections.end()) return false;
+
+        Connection& connection = it->second;
+        connectionId = connection.id;
+        connection.frameBuffer.append(buffer, static_cast<size_t>(bytesReceived));
+
+        std::string message;
+        try
+        {
+            while (connection.frameBuffer.nextFrame(message))
+            {
+                messages.push_back(std::move(message));
+            }
+        }
+        catch (const std::exception&)
+        {
+            return false;  // malformed frame header
+        }
+    }
+
+    auto sendFunc = [this, clientSocket, connectionId](const std::string& msg)
+    { queueResponse(clientSocket, connectionId, msg); };
+
+    for (auto& message : messages)
+    {
+        dispatchMessage(clientSocket, connectionId, std::move(message), sendFunc);
+    }
+
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+    auto it = connections.find(clientSocket);
+    return it != connections.end() && !it->second.broken;
+}
+
+void SocketServer::dispatchMessage(SOCKET clientSocket,
+                                   uint64_t connectionId,
+                                   std::string message,
+                                   const std::function<void(const std::string&)>& sendCallback)
+{
+    if (!workerPool)
+    {
+        handleMessage(clientSocket, connectionId, message, sendCallback);
+        return;
+    }
+
+    // requests of one connection keep their order, different connections run in parallel
+    workerPool->submit(
+        connectionId,
+        [this, clientSocket, connectionId, message = std::move(message), sendCallback]()
+        { handleMessage(clientSocket, connectionId, message, sendCallback); });
+}
+
+void SocketServer::handleMessage(SOCKET clientSocket,
+                                 uint64_t connectionId,
+                                 const std::string& message,
+                                 const std::function<void(const std::string&)>& sendCallback)
+{
+    try
+    {
+        messageHandler(message.data(), static_cast<int>(message.size()), sendCallback);
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << "[DEBUG] SocketServer message handler failed: " << error.what() << "\n";
+        dropConnection(clientSocket, connectionId);
+    }
+    catch (...)
+    {
+        std::cerr << "[DEBUG] SocketServer message handler failed\n";
+        dropConnection(clientSocket, connectionId);
+    }
+}
+
+void SocketServer::dropConnection(SOCKET clientSocket, uint64_t connectionId)
+{
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+
+    auto it = connections.find(clientSocket);
+    if (it == connections.end() || it->second.id != connectionId) return;
+
+    // the event loop sees the shut down socket as closed by the peer and closes it
+    it->second.broken = true;
+    shutdown(clientSocket, SD_BOTH);
+}
+
+void SocketServer::queueResponse(SOCKET clientSocket,
+                                 uint64_t connectionId,
+                                 const std::string& message)
+{
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+
+    // the connection may have been closed (and its handle reused) while a worker was busy
+    auto it = connections.find(clientSocket);
+    if (it == connections.end() || it->second.id != connectionId || it->second.broken) return;
+
+    Connection& connection = it->second;
+    try
+    {
+        connection.outBuffer += encodeFrame(message);
+    }
+    catch (const std::exception&)
+    {
+        connection.broken = true;  // response is too big to be framed
+        return;
+    }
+
+    if (flushConnection(connection, clientSocket)) watchConnection(clientSocket, connection);
+}
+
+bool SocketServer::flushConnection(Connection& connection, SOCKET clientSocket)
+{
+    // the socket is non-blocking, a tail the peer is not ready for is sent by the event loop
+    while (connection.outOffset < connection.outBuffer.size())
     {
-        sockaddr_in clientAddr{};
-        int clientSize = sizeof(clientAddr);
+        int result = send(clientSocket,
+                          connection.outBuffer.data() + connection.outOffset,
+                          static_cast<int>(connection.outBuffer.size() - connection.outOffset),
+                          SOCKET_SEND_FLAGS);
 
-        // accept client connection
-        SOCKET clientSocket = accept(listenSocket, (sockaddr*)&clientAddr, &clientSize);
-        if (clientSocket == INVALID_SOCKET) continue;
+        if (result == SOCKET_ERROR && socketWouldBlock()) return true;
+        if (result <= 0)
+        {
+            connection.broken = true;
+            return false;
+        }
 
-        char clientIP[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &clientAddr.sin_addr, clientIP, sizeof(clientIP));
+        connection.outOffset += static_cast<size_t>(result);
+    }
 
-        char buffer[BUFFER_SIZE];
-        int bytesReceived = recv(clientSocket, buffer, sizeof(buffer) - 1, 0);
+    connection.outBuffer.clear();
+    connection.outOffset = 0;
+    return true;
+}
 
-        if (bytesReceived <= 0)
+void SocketServer::watchConnection(SOCKET clientSocket, const Connection& connection)
+{
+#ifdef __linux__
+    // wait for EPOLLOUT only while some response is still queued
+    epoll_event event{};
+    event.events = EPOLLIN;
+    if (!connection.outBuffer.empty()) event.events |= EPOLLOUT;
+    event.data.fd = clientSocket;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, clientSocket, &event);
+#else
+    (void)clientSocket;
+    (void)connection;
+#endif
+}
+
+void SocketServer::closeConnection(SOCKET clientSocket)
+{
+    closesocket(clientSocket);  // on Linux closing the descriptor also removes it from epoll
+    connections.erase(clientSocket);
+}
+
+void SocketServer::closeAllConnections()
+{
+    for (const auto& connection : connections)
+    {
+        closesocket(connection.first);
+    }
+    connections.clear();
+}
+
+#ifdef __linux__
+void SocketServer::listenMessages()
+{
+    setNonBlocking(listenSocket);
+
+    epoll_event listenEvent{};
+    listenEvent.events = EPOLLIN;
+    listenEvent.data.fd = listenSocket;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenSocket, &listenEvent);
+
+    std::vector<epoll_event> events(EPOLL_MAX_EVENTS);
+
+    while (isListening.load(std::memory_order_acquire))
+    {
+        // wake up periodically to notice stop()
+        int ready = epoll_wait(epollFd, events.data(), EPOLL_MAX_EVENTS, SELECT_TIMEOUT_MS);
+        if (ready == -1)
         {
-            closesocket(clientSocket);
-            continue;
+            if (errno == EINTR) continue;
+            break;
         }
 
-        buffer[bytesReceived] = '\0';
+        for (int i = 0; i < ready; ++i)
+        {
+            SOCKET socket = events[i].data.fd;
+            uint32_t flags = events[i].events;
+
+            if (socket == listenSocket)
+            {
+                // drain the whole accept backlog, the listen socket is non-blocking
+                SOCKET clientSocket;
+                while ((clientSocket = accept(listenSocket, nullptr, nullptr)) != INVALID_SOCKET)
+                {
+                    std::lock_guard<std::mutex> lock(connectionsMutex);
+                    if (!acceptConnection(clientSocket)) continue;
 
-        auto sendFunc = [clientSocket](const std::string& msg)
-        { send(clientSocket, msg.c_str(), static_cast<int>(msg.size()), 0); };
+                    epoll_event clientEvent{};
+                    clientEvent.events = EPOLLIN;
+                    clientEvent.data.fd = clientSocket;
+                    epoll_ctl(epollFd, EPOLL_CTL_ADD, clientSocket, &clientEvent);
+                }
+                continue;
+            }
 
-        try
+            bool keepOpen = (flags & (EPOLLERR | EPOLLHUP)) == 0 || (flags & EPOLLIN) != 0;
+
+            if (keepOpen && (flags & EPOLLOUT))
+            {
+                std::lock_guard<std::mutex> lock(connectionsMutex);
+                auto it = connections.find(socket);
+                keepOpen = it != connections.end() && flushConnection(it->second, socket);
+            }
+
+            if (keepOpen && (flags & EPOLLIN)) keepOpen = readConnection(socket);
+
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            auto it = connections.find(socket);
+            if (it == connections.end()) continue;
+
+            if (keepOpen)
+                watchConnection(socket, it->second);
+            else
+                closeConnection(socket);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+    closeAllConnections();
+}
+#else
+void SocketServer::listenMessages()
+{
+    while (isListening.load(std::memory_order_acquire))
+    {
+        fd_set readSet;
+        fd_set writeSet;
+        FD_ZERO(&readSet);
+        FD_ZERO(&writeSet);
+        FD_SET(listenSocket, &readSet);
+        SOCKET maxSocket = listenSocket;
+
+        // accepted sockets stay open between requests, clients reuse them.
+        // a response queued by a worker meanwhile is flushed on the next round at the latest
         {
-            onMessage(buffer, bytesReceived, sendFunc);
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            for (const auto& connection : connections)
+            {
+                FD_SET(connection.first, &readSet);
+                if (!connection.second.outBuffer.empty()) FD_SET(connection.first, &writeSet);
+                if (connection.first > maxSocket) maxSocket = connection.first;
+            }
         }
-        catch (...)
+
+        // wake up periodically to notice stop(), nfds is ignored by Winsock
+        timeval timeout{ 0, SELECT_TIMEOUT_MS * 1000 };
+        int ready =
+            select(static_cast<int>(maxSocket) + 1, &readSet, &writeSet, nullptr, &timeout);
+        if (ready == SOCKET_ERROR) break;
+        if (ready == 0) continue;
+
+        std::vector<SOCKET> readable;
         {
-            isListening.store(false, std::memory_order_release);
-            closesocket(clientSocket);
-            throw std::runtime_error("Failed to handle message");
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            std::vector<SOCKET> failed;
+            for (auto& connection : connections)
+            {
+                if (FD_ISSET(connection.first, &writeSet) &&
+                    !flushConnection(connection.second, connection.first))
+                    failed.push_back(connection.first);
+                else if (FD_ISSET(connection.first, &readSet))
+                    readable.push_back(connection.first);
+            }
+            for (SOCKET clientSocket : failed) closeConnection(clientSocket);
+
+            if (FD_ISSET(listenSocket, &readSet))
+            {
+                sockaddr_in clientAddr{};
+                socklen_t clientSize = sizeof(clientAddr);
+
+                // accept client connection
+                SOCKET clientSocket = accept(listenSocket, (sockaddr*)&clientAddr, &clientSize);
+                if (clientSocket != INVALID_SOCKET) acceptConnection(clientSocket);
+            }
         }
 
-        // close one connection, ready for next
-        closesocket(clientSocket);
+        for (SOCKET clientSocket : readable)
+        {
+            if (!readConnection(clientSocket))
+            {
+                std::lock_guard<std::mutex> lock(connectionsMutex);
+                closeConnection(clientSocket);
+            }
+        }
     }
+
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+    closeAllConnections();
 }
+#endif
 
-SocketServer::SocketServer(u_short port)
+SocketServer::SocketServer(u_short port, size_t workerCount) : workerCount(workerCount)
 {
-    // init winsock2.dll
+    // init winsock2.dll (no-op on POSIX)
     int result = WSAStartup(MAKEWORD(2, 2), &wsaData);
     if (result != 0) throw std::runtime_error("Failed to initialize Winsock");
 
@@ -69,6 +363,12 @@ SocketServer::SocketServer(u_short port)
     serverAddr.sin_port = htons(port);  // port number to TCP/IP format
     serverAddr.sin_addr.s_addr = INADDR_ANY;
 
+#ifndef _WIN32
+    // allow restarting a node while old connections are still in TIME_WAIT
+    int reuse = 1;
+    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+
     // bind server address to socket
     if (bind(listenSocket, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR)
     {
@@ -84,6 +384,9 @@ SocketServer::~SocketServer()
 {
     stop();
 
+#ifdef __linux__
+    if (epollFd != -1) close(epollFd);
+#endif
     closesocket(listenSocket);
     WSACleanup();
 }
@@ -92,10 +395,15 @@ SocketServer::SocketServer(SocketServer&& other) noexcept
     : wsaData(other.wsaData),
       listenSocket(other.listenSocket),
       serverAddr(other.serverAddr),
-      isListening(other.isListening.load(std::memory_order_acquire))
+      isListening(other.isListening.load(std::memory_order_acquire)),
+      workerCount(other.workerCount)
 {
     if (other.listenThread.joinable()) other.listenThread.detach();
 
+#ifdef __linux__
+    epollFd = other.epollFd;
+    other.epollFd = -1;
+#endif
     other.listenSocket = INVALID_SOCKET;
     other.isListening.store(false, std::memory_order_release);
 }
@@ -111,6 +419,10 @@ SocketServer& SocketServer::operator=(SocketServer&& other) noexcept
         listenSocket = other.listenSocket;
         serverAddr = other.serverAddr;
         isListening.store(other.isListening.load(std::memory_order_acquire));
+        workerCount = other.workerCount;
+#ifdef __linux__
+        std::swap(epollFd, other.epollFd);
+#endif
 
         other.listenSocket = INVALID_SOCKET;
         other.isListening.store(false, std::memory_order_release);
@@ -120,20 +432,39 @@ SocketServer& SocketServer::operator=(SocketServer&& other) noexcept
 
 bool SocketServer::startAsync(MessageHandler onMessage)
 {
-    if (!isListening.load(std::memory_order_acquire))
-    {
-        listenThread = std::thread(&SocketServer::listenMessages, this, onMessage);
-        listenThread.detach();
+    if (isListening.load(std::memory_order_acquire)) return false;
 
-        return true;
-    }
-    return false;
+    // listen max queued connections
+    if (listen(listenSocket, SOMAXCONN) == SOCKET_ERROR) return false;
+
+#ifdef __linux__
+    if (epollFd == -1) epollFd = epoll_create1(0);
+    if (epollFd == -1) return false;
+#endif
+
+    messageHandler = onMessage;
+    if (workerCount > 0)
+        workerPool = std::make_unique<concurrency::WorkerPool>(workerCount, MAX_QUEUED_REQUESTS);
+
+    isListening.store(true, std::memory_order_release);
+    listenThread = std::thread(&SocketServer::listenMessages, this);
+
+    return true;
 }
 
 void SocketServer::stop()
 {
-    if (listenThread.joinable()) listenThread.join();
+    // the event loop wakes up every SELECT_TIMEOUT_MS and exits once the flag is cleared
     isListening.store(false, std::memory_order_release);
+    if (listenThread.joinable() && listenThread.get_id() != std::this_thread::get_id())
+        listenThread.join();
+
+    // connections are closed by now, responses of still running requests are dropped
+    if (workerPool)
+    {
+        workerPool->shutdown();
+        workerPool.reset();
+    }
 }
 
 bool SocketServer::listening() const { return isListening.load(std::memory_order_acquire); }
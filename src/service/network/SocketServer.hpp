@@ -1,16 +1,26 @@
 #pragma once
 
-#include <winsock2.h>
-#include <ws2tcpip.h>
-
 #include <atomic>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "MessageFrame.hpp"
+#include "SocketPlatform.hpp"
+#include "WorkerPool.hpp"
 
 namespace network
 {
-constexpr const u_int BUFFER_SIZE = 32768;
+constexpr const u_int BUFFER_SIZE = 32768;  // size of a single recv() chunk
+constexpr const long SELECT_TIMEOUT_MS = 200;  // how often the event loop checks for stop()
+constexpr const size_t MAX_CONNECTIONS = FD_SETSIZE - 1;  // select() backend, one slot for listenSocket
+constexpr const int EPOLL_MAX_EVENTS = 256;               // epoll backend, events per epoll_wait()
+constexpr const size_t MAX_QUEUED_REQUESTS = 1024;  // the event loop stops reading when workers lag
 
 class SocketServer
 {
@@ -18,7 +28,37 @@ private:
     using MessageHandler = std::function<void(
         const char* buffer, int bufferSize, std::function<void(const std::string&)> sendCallback)>;
 
-    void listenMessages(MessageHandler onMessage);
+    // state of one accepted socket, kept between requests
+    struct Connection
+    {
+        uint64_t id = 0;          // unique per accept, a reused socket handle gets a new one
+        FrameBuffer frameBuffer;  // partially received request frames
+        std::string outBuffer;    // encoded responses not yet accepted by send()
+        size_t outOffset = 0;
+        bool broken = false;
+    };
+
+    // event loop: epoll on Linux, select() elsewhere
+    void listenMessages();
+    bool readConnection(SOCKET clientSocket);
+    void dispatchMessage(SOCKET clientSocket,
+                         uint64_t connectionId,
+                         std::string message,
+                         const std::function<void(const std::string&)>& sendCallback);
+    // a failing handler drops its connection, inline and on workers alike
+    void handleMessage(SOCKET clientSocket,
+                       uint64_t connectionId,
+                       const std::string& message,
+                       const std::function<void(const std::string&)>& sendCallback);
+    void dropConnection(SOCKET clientSocket, uint64_t connectionId);
+    void queueResponse(SOCKET clientSocket, uint64_t connectionId, const std::string& message);
+
+    // caller holds connectionsMutex
+    bool acceptConnection(SOCKET clientSocket);
+    bool flushConnection(Connection& connection, SOCKET clientSocket);
+    void watchConnection(SOCKET clientSocket, const Connection& connection);
+    void closeConnection(SOCKET clientSocket);
+    void closeAllConnections();
 
 protected:
     WSADATA wsaData;
@@ -26,9 +66,22 @@ protected:
     sockaddr_in serverAddr;
     std::thread listenThread;
     std::atomic<bool> isListening;  // atomic to avoid race conditions
+    MessageHandler messageHandler;
+
+    // workers send responses from their own threads, so the table is shared with the event loop
+    std::unordered_map<SOCKET, Connection> connections;
+    std::mutex connectionsMutex;
+    uint64_t nextConnectionId = 1;
+
+    // 0 workers: handle messages inline on the event loop thread
+    size_t workerCount;
+    std::unique_ptr<concurrency::WorkerPool> workerPool;
+#ifdef __linux__
+    int epollFd = -1;
+#endif
 
 public:
-    explicit SocketServer(u_short port);
+    explicit SocketServer(u_short port, size_t workerCount = 0);
     ~SocketServer();
 
     SocketServer(const SocketServer&) = delete;
@@ -0,0 +1,114 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace utils
+{
+// standard alphabet with '=' padding and no line breaks, same output as OpenSSL's base64 BIO
+// writes (size + 2) / 3 * 4 characters to out, no terminating zero
+inline void toBase64(const uint8_t* data, size_t size, char* out)
+{
+    static const char ALPHABET[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    size_t i = 0;
+    for (; i + 2 < size; i += 3)
+    {
+        uint32_t n = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+        *out++ = ALPHABET[(n >> 18) & 63];
+        *out++ = ALPHABET[(n >> 12) & 63];
+        *out++ = ALPHABET[(n >> 6) & 63];
+        *out++ = ALPHABET[n & 63];
+    }
+
+    if (i + 1 == size)
+    {
+        uint32_t n = data[i] << 16;
+        *out++ = ALPHABET[(n >> 18) & 63];
+        *out++ = ALPHABET[(n >> 12) & 63];
+        *out++ = '=';
+        *out++ = '=';
+    }
+    else if (i + 2 == size)
+    {
+        uint32_t n = (data[i] << 16) | (data[i + 1] << 8);
+        *out++ = ALPHABET[(n >> 18) & 63];
+        *out++ = ALPHABET[(n >> 12) & 63];
+        *out++ = ALPHABET[(n >> 6) & 63];
+        *out++ = '=';
+    }
+}
+
+inline std::string toBase64(const std::vector<uint8_t>& data)
+{
+    std::string out((data.size() + 2) / 3 * 4, '\0');
+    toBase64(data.data(), data.size(), out.data());
+    return out;
+}
+
+// value of every base64 character, -1 for characters outside the alphabet
+constexpr std::array<int8_t, 256> BASE64_VALUES = []()
+{
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::array<int8_t, 256> values{};
+    for (auto& value : values) value = -1;
+    for (int i = 0; i < 64; ++i) values[static_cast<uint8_t>(alphabet[i])] = static_cast<int8_t>(i);
+    return values;
+}();
+
+// decodes into out, which must hold text.size() / 4 * 3 bytes, and sets size to the decoded length
+// false on characters outside the alphabet or a length that is not a multiple of 4
+inline bool fromBase64(std::string_view text, uint8_t* out, size_t& size)
+{
+    size = 0;
+    if (text.size() % 4 != 0) return false;
+    if (text.empty()) return true;
+
+    // every group but the last is 4 full characters
+    size_t last = text.size() - 4;
+    for (size_t i = 0; i < last; i += 4)
+    {
+        int a = BASE64_VALUES[static_cast<uint8_t>(text[i])];
+        int b = BASE64_VALUES[static_cast<uint8_t>(text[i + 1])];
+        int c = BASE64_VALUES[static_cast<uint8_t>(text[i + 2])];
+        int d = BASE64_VALUES[static_cast<uint8_t>(text[i + 3])];
+        if ((a | b | c | d) < 0) return false;
+
+        uint32_t n = (a << 18) | (b << 12) | (c << 6) | d;
+        out[size++] = static_cast<uint8_t>(n >> 16);
+        out[size++] = static_cast<uint8_t>(n >> 8);
+        out[size++] = static_cast<uint8_t>(n);
+    }
+
+    size_t padding = 0;
+    if (text[last + 3] == '=') padding = text[last + 2] == '=' ? 2 : 1;
+
+    uint32_t n = 0;
+    for (size_t j = 0; j < 4; ++j)
+    {
+        int v = j < 4 - padding ? BASE64_VALUES[static_cast<uint8_t>(text[last + j])] : 0;
+        if (v < 0) return false;
+        n = (n << 6) | static_cast<uint32_t>(v);
+    }
+
+    out[size++] = static_cast<uint8_t>(n >> 16);
+    if (padding < 2) out[size++] = static_cast<uint8_t>(n >> 8);
+    if (padding < 1) out[size++] = static_cast<uint8_t>(n);
+    return true;
+}
+
+inline bool fromBase64(std::string_view text, std::vector<uint8_t>& out)
+{
+    out.resize(text.size() / 4 * 3);
+
+    size_t size = 0;
+    bool ok = fromBase64(text, out.data(), size);
+    out.resize(ok ? size : 0);
+    return ok;
+}
+}  // namespace utils
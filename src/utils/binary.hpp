@@ -0,0 +1,186 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "base64.hpp"
+#include "hex.hpp"
+
+namespace utils
+{
+// truncated or malformed binary data
+class BinaryFormatError : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// tags in front of text that may travel as raw bytes
+constexpr uint8_t TEXT_AS_IS = 0;
+constexpr uint8_t TEXT_AS_BYTES = 1;
+
+// appends little-endian integers, LEB128 varints and length-prefixed strings to out
+class BinaryWriter
+{
+private:
+    std::string& out;
+
+public:
+    explicit BinaryWriter(std::string& out) : out(out) {}
+
+    void writeByte(uint8_t value) { out.push_back(static_cast<char>(value)); }
+
+    void writeUint16(uint16_t value)
+    {
+        writeByte(static_cast<uint8_t>(value));
+        writeByte(static_cast<uint8_t>(value >> 8));
+    }
+
+    void writeVarint(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            writeByte(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        writeByte(static_cast<uint8_t>(value));
+    }
+
+    void writeRaw(const void* data, size_t size) { out.append(static_cast<const char*>(data), size); }
+
+    void writeBytes(const std::vector<uint8_t>& bytes)
+    {
+        writeVarint(bytes.size());
+        writeRaw(bytes.data(), bytes.size());
+    }
+
+    void writeString(std::string_view text)
+    {
+        writeVarint(text.size());
+        writeRaw(text.data(), text.size());
+    }
+
+    // lowercase hex goes out as its bytes, any other text (like the "0" hash) as it is
+    void writeHexString(std::string_view text)
+    {
+        bool lowercaseHex = !text.empty() && text.size() % 2 == 0;
+        for (char c : text)
+            if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) lowercaseHex = false;
+
+        if (!lowercaseHex)
+        {
+            writeByte(TEXT_AS_IS);
+            writeString(text);
+            return;
+        }
+
+        writeByte(TEXT_AS_BYTES);
+        writeVarint(text.size() / 2);
+        size_t offset = out.size();
+        out.resize(offset + text.size() / 2);
+        fromHex(text, reinterpret_cast<uint8_t*>(out.data() + offset));
+    }
+
+    // base64 goes out as its bytes when encoding them again gives back the same text
+    void writeBase64String(std::string_view text)
+    {
+        std::vector<uint8_t> bytes(text.size() / 4 * 3);
+        size_t size = 0;
+        if (!text.empty() && fromBase64(text, bytes.data(), size))
+        {
+            std::string encoded((size + 2) / 3 * 4, '\0');
+            toBase64(bytes.data(), size, encoded.data());
+            if (encoded == text)
+            {
+                writeByte(TEXT_AS_BYTES);
+                writeVarint(size);
+                writeRaw(bytes.data(), size);
+                return;
+            }
+        }
+
+        writeByte(TEXT_AS_IS);
+        writeString(text);
+    }
+};
+
+// reads what BinaryWriter wrote, throws BinaryFormatError instead of reading past the end
+class BinaryReader
+{
+private:
+    std::string_view data;
+    size_t position = 0;
+
+    const char* take(size_t size)
+    {
+        if (size > data.size() - position) throw BinaryFormatError("Truncated binary data");
+
+        const char* bytes = data.data() + position;
+        position += size;
+        return bytes;
+    }
+
+public:
+    explicit BinaryReader(std::string_view data) : data(data) {}
+
+    bool atEnd() const { return position == data.size(); }
+
+    uint8_t readByte() { return static_cast<uint8_t>(*take(1)); }
+
+    uint16_t readUint16()
+    {
+        uint16_t low = readByte();
+        return static_cast<uint16_t>(low | (readByte() << 8));
+    }
+
+    uint64_t readVarint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t byte = readByte();
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw BinaryFormatError("Varint is too long");
+    }
+
+    // the length prefix is checked against the remaining data before anything is allocated
+    std::string_view readRaw(size_t size) { return std::string_view(take(size), size); }
+
+    std::vector<uint8_t> readBytes()
+    {
+        std::string_view bytes = readRaw(readVarint());
+        return std::vector<uint8_t>(bytes.begin(), bytes.end());
+    }
+
+    std::string readString() { return std::string(readRaw(readVarint())); }
+
+    std::string readHexString()
+    {
+        uint8_t tag = readByte();
+        if (tag == TEXT_AS_IS) return readString();
+        if (tag != TEXT_AS_BYTES) throw BinaryFormatError("Unknown text tag");
+
+        std::string_view bytes = readRaw(readVarint());
+        std::string text(bytes.size() * 2, '\0');
+        toHex(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), text.data());
+        return text;
+    }
+
+    std::string readBase64String()
+    {
+        uint8_t tag = readByte();
+        if (tag == TEXT_AS_IS) return readString();
+        if (tag != TEXT_AS_BYTES) throw BinaryFormatError("Unknown text tag");
+
+        std::string_view bytes = readRaw(readVarint());
+        std::string text((bytes.size() + 2) / 3 * 4, '\0');
+        toBase64(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), text.data());
+        return text;
+    }
+};
+}  // namespace utils
@@ -1,28 +1,70 @@
 #pragma once
-#include <iomanip>
-#include <sstream>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace utils
 {
+// value of every hex digit (either case), -1 for other characters
+constexpr std::array<int8_t, 256> HEX_VALUES = []()
+{
+    std::array<int8_t, 256> values{};
+    for (auto& value : values) value = -1;
+    for (int i = 0; i < 10; ++i) values['0' + i] = static_cast<int8_t>(i);
+    for (int i = 0; i < 6; ++i)
+    {
+        values['a' + i] = static_cast<int8_t>(10 + i);
+        values['A' + i] = static_cast<int8_t>(10 + i);
+    }
+    return values;
+}();
+
+// writes 2 * size lowercase hex digits to out, no terminating zero
+inline void toHex(const uint8_t* data, size_t size, char* out)
+{
+    static const char DIGITS[] = "0123456789abcdef";
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        out[i * 2] = DIGITS[data[i] >> 4];
+        out[i * 2 + 1] = DIGITS[data[i] & 0x0f];
+    }
+}
+
 inline std::string toHex(const std::vector<uint8_t>& data)
 {
-    std::ostringstream oss;
-    oss << std::hex << std::setfill('0');
-    for (auto b : data) oss << std::setw(2) << static_cast<int>(b);
-    return oss.str();
+    std::string out(data.size() * 2, '\0');
+    toHex(data.data(), data.size(), out.data());
+    return out;
 }
 
-inline std::vector<uint8_t> fromHex(const std::string& hex)
+// writes hex.size() / 2 bytes to out, false on an odd length or a non-hex character
+inline bool fromHex(std::string_view hex, uint8_t* out)
 {
-    std::vector<uint8_t> out;
-    out.reserve(hex.size() / 2);
-    for (size_t i = 0; i + 1 < hex.size(); i += 2)
+    if (hex.size() % 2 != 0) return false;
+
+    for (size_t i = 0; i < hex.size(); i += 2)
     {
-        uint8_t byte = static_cast<uint8_t>(std::stoi(hex.substr(i, 2), nullptr, 16));
-        out.push_back(byte);
+        int high = HEX_VALUES[static_cast<uint8_t>(hex[i])];
+        int low = HEX_VALUES[static_cast<uint8_t>(hex[i + 1])];
+        if ((high | low) < 0) return false;
+
+        out[i / 2] = static_cast<uint8_t>((high << 4) | low);
     }
+
+    return true;
+}
+
+// a trailing odd digit is ignored, throws std::invalid_argument on non-hex characters
+inline std::vector<uint8_t> fromHex(const std::string& hex)
+{
+    std::vector<uint8_t> out(hex.size() / 2);
+    if (!fromHex(std::string_view(hex).substr(0, out.size() * 2), out.data()))
+        throw std::invalid_argument("fromHex: invalid hex digit");
     return out;
 }
-}  // namespace utils
\ No newline at end of file
+}  // namespace utils
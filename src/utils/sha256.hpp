@@ -1,17 +1,90 @@
+#pragma once
+#include <openssl/evp.h>
 #include <openssl/sha.h>
 
+#include <array>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "hex.hpp"
 
 namespace utils
 {
+using Digest = std::array<uint8_t, SHA256_DIGEST_LENGTH>;
+
+// incremental SHA-256 that needs no heap allocation once the thread has hashed something:
+// every thread keeps its idle digest contexts and reuses them, so hashers may be nested
+class Sha256Hasher
+{
+private:
+    EVP_MD_CTX* ctx;
+
+    struct ThreadContexts
+    {
+        std::vector<EVP_MD_CTX*> idle;
+        ~ThreadContexts()
+        {
+            for (EVP_MD_CTX* ctx : idle) EVP_MD_CTX_free(ctx);
+        }
+    };
+
+    static ThreadContexts& threadContexts()
+    {
+        thread_local ThreadContexts contexts;
+        return contexts;
+    }
+
+public:
+    Sha256Hasher()
+    {
+        std::vector<EVP_MD_CTX*>& idle = threadContexts().idle;
+        if (idle.empty())
+        {
+            ctx = EVP_MD_CTX_new();
+        }
+        else
+        {
+            ctx = idle.back();
+            idle.pop_back();
+        }
+
+        if (!ctx || 1 != EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr))
+        {
+            EVP_MD_CTX_free(ctx);
+            throw std::runtime_error("SHA-256 init failed");
+        }
+    }
+
+    ~Sha256Hasher() { threadContexts().idle.push_back(ctx); }
+
+    Sha256Hasher(const Sha256Hasher&) = delete;
+    Sha256Hasher& operator=(const Sha256Hasher&) = delete;
+
+    void update(const void* data, size_t size) { EVP_DigestUpdate(ctx, data, size); }
+    void update(std::string_view text) { update(text.data(), text.size()); }
+
+    Digest finish()
+    {
+        Digest digest;
+        EVP_DigestFinal_ex(ctx, digest.data(), nullptr);
+        return digest;
+    }
+};
+
+inline Digest sha256Digest(std::string_view data)
+{
+    Sha256Hasher hasher;
+    hasher.update(data);
+    return hasher.finish();
+}
+
 inline std::string sha256(const std::string& data)
 {
-    unsigned char digest[SHA256_DIGEST_LENGTH];
-    SHA256(reinterpret_cast<const unsigned char*>(data.data()), data.size(), digest);
-    std::vector<uint8_t> v(digest, digest + SHA256_DIGEST_LENGTH);
-    return utils::toHex(v);
+    Digest digest = sha256Digest(data);
+    std::string hex(digest.size() * 2, '\0');
+    toHex(digest.data(), digest.size(), hex.data());
+    return hex;
 }
-}  // namespace utils
\ No newline at end of file
+}  // namespace utils
@@ -104,15 +104,13 @@ protected:
     blockchain::Block createGenesisBlock(const crypto::KeyPair& keyPair)
     {
         blockchain::Block block;
-        block.previousHash = "0";
-        block.payloadHash = utils::sha256("genesis");
-        block.authorPublicKey = crypto->keyToString(keyPair.publicKey);
+        block.payloadHash = utils::sha256Digest("genesis");
+        block.authorPublicKey = keyPair.publicKey;
         block.timestamp = utils::getTimestamp();
 
         std::string canonical = block.toStringForHash();
         crypto::Bytes canonicalBytes(canonical.begin(), canonical.end());
-        crypto::Bytes signature = crypto->sign(canonicalBytes, keyPair.privateKey);
-        block.signature = crypto->keyToString(signature);
+        block.signature = crypto->sign(canonicalBytes, keyPair.privateKey);
 
         block.computeHash();
         return block;
@@ -160,7 +158,7 @@ protected:
                                                                  setup->consoleUI);
 
         setup->server = std::make_shared<network::TCPServer>(
-            port, setup->chatService, setup->blockchainService, setup->consoleUI);
+            port, setup->chatService, setup->blockchainService, setup->consoleUI, 2);
 
         blockchain::Block tip;
         setup->chainRepo->findTip(tip);
@@ -172,7 +170,7 @@ protected:
                                                              setup->blockchainService,
                                                              setup->messageService,
                                                              setup->consoleUI,
-                                                             tip.hash);
+                                                             blockchain::hashToHex(tip.hash));
 
         return setup;
     }
@@ -296,7 +294,7 @@ protected:
             blockchain::Block tip;
             if (peer->chainRepo->findTip(tip))
             {
-                uniqueTips.insert(tip.hash);
+                uniqueTips.insert(tip.hashHex());
             }
         }
         return uniqueTips.size();
@@ -329,7 +327,7 @@ protected:
             blockchain::Block tip;
             if (peer->chainRepo->findTip(tip))
             {
-                uniqueTips.insert(tip.hash);
+                uniqueTips.insert(tip.hashHex());
             }
         }
 
@@ -605,7 +603,7 @@ TEST_F(BlockchainForkStressTest, ForkDetectionAndRollbackTest)
 
     blockchain::Block tip2Before;
     peers[2]->chainRepo->findTip(tip2Before);
-    std::cout << "Peer 2 tip before sending: " << tip2Before.hash.substr(0, 16) << "..."
+    std::cout << "Peer 2 tip before sending: " << tip2Before.hashHex().substr(0, 16) << "..."
               << std::endl;
 
     peer::UserPeer from2(
@@ -637,7 +635,7 @@ TEST_F(BlockchainForkStressTest, ForkDetectionAndRollbackTest)
         peers[i]->chainRepo->findTip(tip);
 
         std::cout << "Peer " << i << ": " << blocks.size() << " blocks, tip: "
-                  << (tip.hash.empty() ? "empty" : tip.hash.substr(0, 16) + "...") << std::endl;
+                  << tip.hashHex().substr(0, 16) << "..." << std::endl;
 
         EXPECT_TRUE(peers[i]->blockchainService->validateLocalChain())
             << "Peer " << i << " has invalid chain";
@@ -854,16 +852,18 @@ TEST_F(BlockchainForkStressTest, NetworkPartitionTest)
     {
         blockchain::Block tip;
         peers[i]->chainRepo->findTip(tip);
-        group1Tips.insert(tip.hash);
-        std::cout << "  Peer " << i << " (G1): " << tip.hash.substr(0, 16) << "..." << std::endl;
+        group1Tips.insert(tip.hashHex());
+        std::cout << "  Peer " << i << " (G1): " << tip.hashHex().substr(0, 16) << "..."
+                  << std::endl;
     }
 
     for (size_t i = GROUP_SIZE; i < TOTAL_PEERS; ++i)
     {
         blockchain::Block tip;
         peers[i]->chainRepo->findTip(tip);
-        group2Tips.insert(tip.hash);
-        std::cout << "  Peer " << i << " (G2): " << tip.hash.substr(0, 16) << "..." << std::endl;
+        group2Tips.insert(tip.hashHex());
+        std::cout << "  Peer " << i << " (G2): " << tip.hashHex().substr(0, 16) << "..."
+                  << std::endl;
     }
 
     bool groupsDiverged = (group1Tips != group2Tips);
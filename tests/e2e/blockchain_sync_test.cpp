@@ -1,8 +1,12 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <thread>
+
 #include "BlockRangeMessage.hpp"
 #include "BlockchainService.hpp"
 #include "ChainDB.hpp"
+#include "ChainSync.hpp"
 #include "ConsoleUI.hpp"
 #include "DBFile.hpp"
 #include "JsonConfig.hpp"
@@ -26,20 +30,19 @@ protected:
 
     void TearDown() override { env->cleanup(); }
 
-    blockchain::Block createBlock(const std::string& previousHash,
+    blockchain::Block createBlock(const blockchain::Hash& previousHash,
                                   const std::string& payload,
                                   const crypto::KeyPair& keyPair)
     {
         blockchain::Block block;
         block.previousHash = previousHash;
-        block.payloadHash = utils::sha256(payload);
-        block.authorPublicKey = crypto->keyToString(keyPair.publicKey);
+        block.payloadHash = utils::sha256Digest(payload);
+        block.authorPublicKey = keyPair.publicKey;
         block.timestamp = utils::getTimestamp();
 
         std::string canonical = block.toStringForHash();
         crypto::Bytes canonicalBytes(canonical.begin(), canonical.end());
-        crypto::Bytes signature = crypto->sign(canonicalBytes, keyPair.privateKey);
-        block.signature = crypto->keyToString(signature);
+        block.signature = crypto->sign(canonicalBytes, keyPair.privateKey);
 
         block.computeHash();
         return block;
@@ -67,7 +70,7 @@ TEST_F(BlockchainSyncTest, SyncEmptyChainToChainWithBlocks)
 
     // Create chain with 5 blocks
     std::vector<blockchain::Block> blocks;
-    blockchain::Block block1 = createBlock("0", "genesis", keyPair);
+    blockchain::Block block1 = createBlock(blockchain::Hash{}, "genesis", keyPair);
     chainRepo1->insertBlock(block1);
     blocks.push_back(block1);
 
@@ -98,15 +101,15 @@ TEST_F(BlockchainSyncTest, SyncEmptyChainToChainWithBlocks)
         std::make_shared<blockchain::BlockchainService>(config2, crypto, chainRepo2, consoleUI2);
 
     // Check missing blocks
-    unsigned int missingCount = blockchainService2->countBlocksAfterHash("0");
+    unsigned int missingCount = blockchainService2->countBlocksAfterHash(blockchain::Hash{});
     EXPECT_EQ(missingCount, 0);  // Empty chain
 
-    missingCount = blockchainService1->countBlocksAfterHash("0");
+    missingCount = blockchainService1->countBlocksAfterHash(blockchain::Hash{});
     EXPECT_EQ(missingCount, 5);
 
     // Simulate sync: retrieve blocks from peer1
     std::vector<blockchain::Block> retrievedBlocks;
-    blockchainService1->getBlocksByIndexRange(0, 5, "0", retrievedBlocks);
+    blockchainService1->getBlocksByIndexRange(0, 5, blockchain::Hash{}, retrievedBlocks);
 
     ASSERT_EQ(retrievedBlocks.size(), 5);
 
@@ -154,7 +157,7 @@ TEST_F(BlockchainSyncTest, SyncPartialChain)
         std::make_shared<blockchain::BlockchainService>(config1, crypto, chainRepo1, consoleUI1);
 
     std::vector<blockchain::Block> allBlocks;
-    blockchain::Block block = createBlock("0", "block 1", keyPair);
+    blockchain::Block block = createBlock(blockchain::Hash{}, "block 1", keyPair);
     chainRepo1->insertBlock(block);
     allBlocks.push_back(block);
 
@@ -239,7 +242,7 @@ TEST_F(BlockchainSyncTest, DetectInvalidBlocksInSync)
         std::make_shared<blockchain::BlockchainService>(config, crypto, chainRepo, consoleUI);
 
     // Create valid chain
-    blockchain::Block block1 = createBlock("0", "block 1", keyPair);
+    blockchain::Block block1 = createBlock(blockchain::Hash{}, "block 1", keyPair);
     chainRepo->insertBlock(block1);
 
     std::this_thread::sleep_for(std::chrono::milliseconds(10));
@@ -249,7 +252,7 @@ TEST_F(BlockchainSyncTest, DetectInvalidBlocksInSync)
     std::this_thread::sleep_for(std::chrono::milliseconds(10));
 
     // Create invalid block (wrong previousHash)
-    blockchain::Block block3 = createBlock("wrong_hash", "block 3", keyPair);
+    blockchain::Block block3 = createBlock(utils::sha256Digest("wrong_hash"), "block 3", keyPair);
 
     // Try to sync blocks with broken chain
     std::vector<blockchain::Block> blocksToSync = { block2, block3 };
@@ -260,4 +263,212 @@ TEST_F(BlockchainSyncTest, DetectInvalidBlocksInSync)
 
     // Cleanup
     db->close();
-}
\ No newline at end of file
+}
+TEST_F(BlockchainSyncTest, ChainSyncSplitsRangesAcrossPeers)
+{
+    auto keyPair = crypto->generateKeyPair();
+
+    std::string config1Path = env->createTestConfig(test_helpers::TEST_PORT_PEER1,
+                                                    crypto->keyToString(keyPair.privateKey),
+                                                    crypto->keyToString(keyPair.publicKey));
+    auto config1 = std::make_shared<config::JsonConfig>(config1Path, crypto);
+
+    std::string db1Path = env->createTestDatabase("peer1_parallel");
+    auto db1 = std::make_shared<db::DBFile>(db1Path);
+    auto chainRepo1 = std::make_shared<blockchain::ChainDB>(db1, config1, crypto);
+    chainRepo1->init();
+
+    auto consoleUI1 = std::make_shared<ui::ConsoleUI>();
+    auto blockchainService1 =
+        std::make_shared<blockchain::BlockchainService>(config1, crypto, chainRepo1, consoleUI1);
+
+    std::vector<blockchain::Block> allBlocks;
+    allBlocks.push_back(createBlock(blockchain::Hash{}, "block 1", keyPair));
+    chainRepo1->insertBlock(allBlocks.back());
+
+    for (int i = 2; i <= 11; ++i)
+    {
+        allBlocks.push_back(
+            createBlock(allBlocks.back().hash, "block " + std::to_string(i), keyPair));
+        chainRepo1->insertBlock(allBlocks.back());
+    }
+
+    std::string config2Path = env->createTestConfig(test_helpers::TEST_PORT_PEER2,
+                                                    crypto->keyToString(keyPair.privateKey),
+                                                    crypto->keyToString(keyPair.publicKey));
+    auto config2 = std::make_shared<config::JsonConfig>(config2Path, crypto);
+
+    std::string db2Path = env->createTestDatabase("peer2_parallel");
+    auto db2 = std::make_shared<db::DBFile>(db2Path);
+    auto chainRepo2 = std::make_shared<blockchain::ChainDB>(db2, config2, crypto);
+    chainRepo2->init();
+    chainRepo2->insertBlock(allBlocks[0]);
+
+    auto consoleUI2 = std::make_shared<ui::ConsoleUI>();
+    auto blockchainService2 =
+        std::make_shared<blockchain::BlockchainService>(config2, crypto, chainRepo2, consoleUI2);
+
+    blockchain::Hash lastHash = allBlocks[0].hash;
+    u_int missing = blockchainService1->countBlocksAfterHash(lastHash);
+    ASSERT_EQ(missing, 10);
+
+    // peer 1 serves ranges, peer 2 always fails, peer 3 sends a tampered block
+    peer::UserPeer goodPeer = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto);
+    peer::UserPeer offlinePeer =
+        test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER2, crypto);
+    peer::UserPeer badPeer = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER3, crypto);
+
+    std::mutex servedMutex;
+    std::map<u_short, int> served;
+
+    auto fetch = [&](const peer::UserPeer& peer,
+                     u_int start,
+                     u_int count,
+                     const blockchain::BlockSink& sink) -> bool
+    {
+        {
+            std::lock_guard<std::mutex> lock(servedMutex);
+            served[peer.port]++;
+        }
+
+        if (peer.port == offlinePeer.port) return false;
+        // a slow good peer leaves ranges for the other peers to take
+        if (peer.port == goodPeer.port) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        std::vector<blockchain::Block> blocks;
+        blockchainService1->getBlocksByIndexRange(start, count, lastHash, blocks);
+        if (peer.port == badPeer.port && !blocks.empty())
+            blocks[0].payloadHash = utils::sha256Digest("tampered");
+
+        for (auto& block : blocks)
+            if (!sink(std::move(block))) return false;
+        return true;
+    };
+
+    blockchain::ChainSync chainSync(blockchainService2, consoleUI2, 3, 2);
+    EXPECT_EQ(chainSync.run({ goodPeer, offlinePeer, badPeer }, missing, fetch), 10);
+
+    blockchain::Block tip1, tip2;
+    chainRepo1->findTip(tip1);
+    chainRepo2->findTip(tip2);
+
+    EXPECT_EQ(tip1.hash, tip2.hash);
+    EXPECT_TRUE(blockchainService2->validateLocalChain());
+    EXPECT_GT(served[goodPeer.port], 0);
+    EXPECT_GT(served[offlinePeer.port], 0);
+    EXPECT_LE(served[offlinePeer.port], static_cast<int>(blockchain::SYNC_MAX_PEER_FAILURES));
+
+    db1->close();
+    db2->close();
+}
+
+TEST_F(BlockchainSyncTest, ChainSyncStopsWhenNoPeerHasRange)
+{
+    auto keyPair = crypto->generateKeyPair();
+
+    std::string configPath = env->createTestConfig(test_helpers::TEST_PORT_BASE,
+                                                   crypto->keyToString(keyPair.privateKey),
+                                                   crypto->keyToString(keyPair.publicKey));
+    auto config = std::make_shared<config::JsonConfig>(configPath, crypto);
+
+    std::string dbPath = env->createTestDatabase("stopped_sync");
+    auto db = std::make_shared<db::DBFile>(dbPath);
+    auto chainRepo = std::make_shared<blockchain::ChainDB>(db, config, crypto);
+    chainRepo->init();
+
+    auto consoleUI = std::make_shared<ui::ConsoleUI>();
+    auto blockchainService =
+        std::make_shared<blockchain::BlockchainService>(config, crypto, chainRepo, consoleUI);
+
+    std::vector<blockchain::Block> chain;
+    chain.push_back(createBlock(blockchain::Hash{}, "block 1", keyPair));
+    for (int i = 2; i <= 4; ++i)
+        chain.push_back(createBlock(chain.back().hash, "block " + std::to_string(i), keyPair));
+
+    // both peers only have the first 4 of 8 announced blocks
+    auto fetch = [&chain](const peer::UserPeer&,
+                          u_int start,
+                          u_int count,
+                          const blockchain::BlockSink& sink) -> bool
+    {
+        for (u_int i = start; i < start + count && i < chain.size(); ++i)
+            if (!sink(blockchain::Block(chain[i]))) return false;
+        return true;
+    };
+
+    std::vector<peer::UserPeer> peers = {
+        test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto),
+        test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER2, crypto)
+    };
+
+    blockchain::ChainSync chainSync(blockchainService, consoleUI, 2, 2);
+    EXPECT_EQ(chainSync.run(peers, 8, fetch), 4);
+
+    blockchain::Block tip;
+    ASSERT_TRUE(chainRepo->findTip(tip));
+    EXPECT_EQ(tip.hash, chain.back().hash);
+
+    db->close();
+}
+
+TEST_F(BlockchainSyncTest, ChainSyncCompletesDespiteForkedPeer)
+{
+    auto keyPair = crypto->generateKeyPair();
+
+    std::string configPath = env->createTestConfig(test_helpers::TEST_PORT_BASE,
+                                                   crypto->keyToString(keyPair.privateKey),
+                                                   crypto->keyToString(keyPair.publicKey));
+    auto config = std::make_shared<config::JsonConfig>(configPath, crypto);
+
+    std::string dbPath = env->createTestDatabase("forked_sync");
+    auto db = std::make_shared<db::DBFile>(dbPath);
+    auto chainRepo = std::make_shared<blockchain::ChainDB>(db, config, crypto);
+    chainRepo->init();
+
+    auto consoleUI = std::make_shared<ui::ConsoleUI>();
+    auto blockchainService =
+        std::make_shared<blockchain::BlockchainService>(config, crypto, chainRepo, consoleUI);
+
+    std::vector<blockchain::Block> chain;
+    std::vector<blockchain::Block> fork;
+    chain.push_back(createBlock(blockchain::Hash{}, "block 1", keyPair));
+    fork.push_back(createBlock(blockchain::Hash{}, "fork 1", keyPair));
+    for (int i = 2; i <= 12; ++i)
+    {
+        chain.push_back(createBlock(chain.back().hash, "block " + std::to_string(i), keyPair));
+        fork.push_back(createBlock(fork.back().hash, "fork " + std::to_string(i), keyPair));
+    }
+
+    std::vector<peer::UserPeer> peers = {
+        test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto),
+        test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER2, crypto),
+        test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER3, crypto)
+    };
+    const u_short forkPort = peers[2].port;
+
+    // the forked peer answers fast, with valid blocks that do not attach to the honest chain
+    auto fetch = [&](const peer::UserPeer& peer,
+                     u_int start,
+                     u_int count,
+                     const blockchain::BlockSink& sink) -> bool
+    {
+        bool forked = peer.port == forkPort;
+        if (forked && start == 0) return false;
+        if (!forked) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        const auto& blocks = forked ? fork : chain;
+        for (u_int i = start; i < start + count; ++i)
+            if (!sink(blockchain::Block(blocks[i]))) return false;
+        return true;
+    };
+
+    blockchain::ChainSync chainSync(blockchainService, consoleUI, 2, 2);
+    EXPECT_EQ(chainSync.run(peers, 12, fetch), 12);
+
+    blockchain::Block tip;
+    ASSERT_TRUE(chainRepo->findTip(tip));
+    EXPECT_EQ(tip.hash, chain.back().hash);
+    EXPECT_TRUE(blockchainService->validateLocalChain());
+
+    db->close();
+}
@@ -106,7 +106,7 @@ protected:
 
         // Initialize network
         setup->server = std::make_shared<network::TCPServer>(
-            port, setup->chatService, setup->blockchainService, setup->consoleUI);
+            port, setup->chatService, setup->blockchainService, setup->consoleUI, 2);
 
         blockchain::Block tip;
         setup->chainRepo->findTip(tip);
@@ -118,7 +118,7 @@ protected:
                                                              setup->blockchainService,
                                                              setup->messageService,
                                                              setup->consoleUI,
-                                                             tip.hash);
+                                                             blockchain::hashToHex(tip.hash));
 
         return setup;
     }
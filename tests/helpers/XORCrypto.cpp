@@ -65,19 +65,35 @@ Bytes XORCrypto::createSessionKey(const Bytes& privateKey, const Bytes& peerPubl
     return out;
 }
 
+// session keys are not cached here
+void XORCrypto::forgetSessionKeys(const Bytes&) {}
+
+void XORCrypto::clearSessionKeys() {}
+
 Bytes XORCrypto::encrypt(const Bytes& message, const Bytes& key)
 {
-    Bytes out(message.size());
-    if (key.empty()) return out;
+    Bytes out;
+    encryptInto(message, key, out);
+    return out;
+}
+
+Bytes XORCrypto::decrypt(const Bytes& cipher, const Bytes& key) { return encrypt(cipher, key); }
+
+void XORCrypto::encryptInto(const Bytes& message, const Bytes& key, Bytes& out)
+{
+    out.assign(message.size(), 0);
+    if (key.empty()) return;
 
     for (size_t i = 0; i < message.size(); ++i)
     {
         out[i] = message[i] ^ key[i % key.size()];
     }
-    return out;
 }
 
-Bytes XORCrypto::decrypt(const Bytes& cipher, const Bytes& key) { return encrypt(cipher, key); }
+void XORCrypto::decryptInto(const Bytes& cipher, const Bytes& key, Bytes& out)
+{
+    encryptInto(cipher, key, out);
+}
 
 Bytes XORCrypto::sign(const Bytes& message, const Bytes& privateKey)
 {
@@ -107,4 +123,11 @@ bool XORCrypto::verify(const Bytes& message, const Bytes& signature, const Bytes
 
     return diff == 0;
 }
-}  // namespace crypto
\ No newline at end of file
+
+void XORCrypto::verifyBatch(const std::vector<SignatureCheck>& checks, std::vector<bool>& results)
+{
+    results.clear();
+    for (const auto& check : checks)
+        results.push_back(verify(check.message, check.signature, check.publicKey));
+}
+}  // namespace crypto
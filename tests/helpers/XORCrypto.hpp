@@ -21,11 +21,17 @@ public:
     Bytes stringToKey(const std::string& s) override;
 
     Bytes createSessionKey(const Bytes& privateKey, const Bytes& peerPublicKey) override;
+    void forgetSessionKeys(const Bytes& peerPublicKey) override;
+    void clearSessionKeys() override;
 
     Bytes encrypt(const Bytes& message, const Bytes& key) override;
     Bytes decrypt(const Bytes& cipher, const Bytes& key) override;
+    void encryptInto(const Bytes& message, const Bytes& key, Bytes& out) override;
+    void decryptInto(const Bytes& cipher, const Bytes& key, Bytes& out) override;
 
     Bytes sign(const Bytes& message, const Bytes& privateKey) override;
     bool verify(const Bytes& message, const Bytes& signature, const Bytes& publicKey) override;
+    void verifyBatch(const std::vector<SignatureCheck>& checks,
+                     std::vector<bool>& results) override;
 };
 }  // namespace crypto
\ No newline at end of file
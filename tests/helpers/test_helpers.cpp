@@ -1,7 +1,5 @@
 #include "test_helpers.hpp"
 
-#include <winsock2.h>
-
 #include <chrono>
 #include <cstdlib>
 #include <ctime>
@@ -9,6 +7,7 @@
 #include <thread>
 
 #include "JsonFile.hpp"
+#include "SocketPlatform.hpp"
 #include "timestamp.hpp"
 #include "uuid.hpp"
 
@@ -87,21 +86,21 @@ peer::UserPeer createTestPeer(unsigned short port, const std::shared_ptr<crypto:
     return peer::UserPeer("127.0.0.1", port, crypto->keyToString(keyPair.publicKey));
 }
 
-blockchain::Block createTestBlock(const std::string& previousHash,
-                                  const std::string& payloadHash,
+blockchain::Block createTestBlock(const blockchain::Hash& previousHash,
+                                  const blockchain::Hash& payloadHash,
                                   const std::shared_ptr<crypto::ICrypto>& crypto,
                                   const crypto::Bytes& privateKey)
 {
     blockchain::Block block;
     block.previousHash = previousHash;
     block.payloadHash = payloadHash;
-    block.authorPublicKey = "test_author";
+    std::string author = "test_author";
+    block.authorPublicKey.assign(author.begin(), author.end());
     block.timestamp = utils::getTimestamp();
 
     std::string canonical = block.toStringForHash();
     crypto::Bytes canonicalBytes(canonical.begin(), canonical.end());
-    crypto::Bytes signature = crypto->sign(canonicalBytes, privateKey);
-    block.signature = crypto->keyToString(signature);
+    block.signature = crypto->sign(canonicalBytes, privateKey);
 
     block.computeHash();
     return block;
@@ -39,8 +39,8 @@ public:
 
 peer::UserPeer createTestPeer(unsigned short port, const std::shared_ptr<crypto::ICrypto>& crypto);
 
-blockchain::Block createTestBlock(const std::string& previousHash,
-                                  const std::string& payloadHash,
+blockchain::Block createTestBlock(const blockchain::Hash& previousHash,
+                                  const blockchain::Hash& payloadHash,
                                   const std::shared_ptr<crypto::ICrypto>& crypto,
                                   const crypto::Bytes& privateKey);
 
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
+
 #include "BlockchainService.hpp"
 #include "ChainDB.hpp"
 #include "ConsoleUI.hpp"
@@ -12,6 +14,24 @@
 #include "timestamp.hpp"
 #include "uuid.hpp"
 
+// counts the windows read while validating
+class CountingChainDB : public blockchain::ChainDB
+{
+public:
+    using ChainDB::ChainDB;
+
+    std::atomic<int> rangeReads{ 0 };
+
+    void getBlocksByIndexRange(u_int start,
+                               u_int count,
+                               const blockchain::Hash& lastHash,
+                               std::vector<blockchain::Block>& outBlocks) override
+    {
+        ++rangeReads;
+        ChainDB::getBlocksByIndexRange(start, count, lastHash, outBlocks);
+    }
+};
+
 class BlockchainServiceTest : public ::testing::Test
 {
 protected:
@@ -54,18 +74,18 @@ protected:
         env->cleanup();
     }
 
-    blockchain::Block createValidBlock(const std::string& previousHash, const std::string& payload)
+    blockchain::Block createValidBlock(const blockchain::Hash& previousHash,
+                                       const std::string& payload)
     {
         blockchain::Block block;
         block.previousHash = previousHash;
-        block.payloadHash = utils::sha256(payload);
-        block.authorPublicKey = crypto->keyToString(keyPair.publicKey);
+        block.payloadHash = utils::sha256Digest(payload);
+        block.authorPublicKey = keyPair.publicKey;
         block.timestamp = utils::getTimestamp();
 
         std::string canonical = block.toStringForHash();
         crypto::Bytes canonicalBytes(canonical.begin(), canonical.end());
-        crypto::Bytes signature = crypto->sign(canonicalBytes, keyPair.privateKey);
-        block.signature = crypto->keyToString(signature);
+        block.signature = crypto->sign(canonicalBytes, keyPair.privateKey);
 
         block.computeHash();
         return block;
@@ -79,7 +99,7 @@ TEST_F(BlockchainServiceTest, ValidateLocalChainWithEmptyChainSucceeds)
 
 TEST_F(BlockchainServiceTest, ValidateLocalChainWithSingleBlockSucceeds)
 {
-    blockchain::Block block = createValidBlock("0", "genesis block");
+    blockchain::Block block = createValidBlock(blockchain::Hash{}, "genesis block");
 
     EXPECT_TRUE(chainRepo->insertBlock(block));
     EXPECT_TRUE(blockchainService->validateLocalChain());
@@ -87,7 +107,7 @@ TEST_F(BlockchainServiceTest, ValidateLocalChainWithSingleBlockSucceeds)
 
 TEST_F(BlockchainServiceTest, ValidateLocalChainWithMultipleBlocksSucceeds)
 {
-    blockchain::Block block1 = createValidBlock("0", "first block");
+    blockchain::Block block1 = createValidBlock(blockchain::Hash{}, "first block");
     EXPECT_TRUE(chainRepo->insertBlock(block1));
 
     std::this_thread::sleep_for(std::chrono::milliseconds(10));
@@ -105,7 +125,7 @@ TEST_F(BlockchainServiceTest, ValidateLocalChainWithMultipleBlocksSucceeds)
 
 TEST_F(BlockchainServiceTest, ValidateSingleBlockSucceeds)
 {
-    blockchain::Block block = createValidBlock("0", "test block");
+    blockchain::Block block = createValidBlock(blockchain::Hash{}, "test block");
 
     std::string error;
     EXPECT_TRUE(blockchainService->validateIncomingBlock(block, error));
@@ -114,8 +134,8 @@ TEST_F(BlockchainServiceTest, ValidateSingleBlockSucceeds)
 
 TEST_F(BlockchainServiceTest, ValidateBlockWithInvalidSignatureFails)
 {
-    blockchain::Block block = createValidBlock("0", "test block");
-    block.signature = "invalid_signature";
+    blockchain::Block block = createValidBlock(blockchain::Hash{}, "test block");
+    block.signature = { 1, 2, 3 };
 
     std::string error;
     EXPECT_FALSE(blockchainService->validateIncomingBlock(block, error));
@@ -124,8 +144,8 @@ TEST_F(BlockchainServiceTest, ValidateBlockWithInvalidSignatureFails)
 
 TEST_F(BlockchainServiceTest, ValidateBlockWithInvalidHashFails)
 {
-    blockchain::Block block = createValidBlock("0", "test block");
-    block.hash = "wrong_hash";
+    blockchain::Block block = createValidBlock(blockchain::Hash{}, "test block");
+    block.hash = utils::sha256Digest("wrong_hash");
 
     std::string error;
     EXPECT_FALSE(blockchainService->validateIncomingBlock(block, error));
@@ -134,14 +154,13 @@ TEST_F(BlockchainServiceTest, ValidateBlockWithInvalidHashFails)
 
 TEST_F(BlockchainServiceTest, ValidateBlockWithFutureTimestampFails)
 {
-    blockchain::Block block = createValidBlock("0", "test block");
+    blockchain::Block block = createValidBlock(blockchain::Hash{}, "test block");
     block.timestamp = utils::getTimestamp() + 400000;  // More than 5 minutes in future
 
     // Recompute hash and signature with new timestamp
     std::string canonical = block.toStringForHash();
     crypto::Bytes canonicalBytes(canonical.begin(), canonical.end());
-    crypto::Bytes signature = crypto->sign(canonicalBytes, keyPair.privateKey);
-    block.signature = crypto->keyToString(signature);
+    block.signature = crypto->sign(canonicalBytes, keyPair.privateKey);
     block.computeHash();
 
     std::string error;
@@ -159,11 +178,11 @@ TEST_F(BlockchainServiceTest, CreateBlockFromMessageSucceeds)
     blockchain::Block block;
     blockchainService->createBlockFromMessage(textMsg, block);
 
-    EXPECT_EQ(block.previousHash, "0");
-    EXPECT_EQ(block.authorPublicKey, from.publicKey);
-    EXPECT_FALSE(block.hash.empty());
+    EXPECT_EQ(block.previousHash, blockchain::Hash{});
+    EXPECT_EQ(block.authorPublicKeyBase64(), from.publicKey);
+    EXPECT_NE(block.hash, blockchain::Hash{});
     EXPECT_FALSE(block.signature.empty());
-    EXPECT_EQ(block.payloadHash, utils::sha256("Hello, World!"));
+    EXPECT_EQ(block.payloadHash, utils::sha256Digest("Hello, World!"));
 }
 
 TEST_F(BlockchainServiceTest, CompareBlockWithMessageSucceeds)
@@ -203,7 +222,7 @@ TEST_F(BlockchainServiceTest, CompareBlockWithDifferentMessageFails)
 
 TEST_F(BlockchainServiceTest, CountBlocksAfterHashWorks)
 {
-    blockchain::Block block1 = createValidBlock("0", "block 1");
+    blockchain::Block block1 = createValidBlock(blockchain::Hash{}, "block 1");
     chainRepo->insertBlock(block1);
 
     std::this_thread::sleep_for(std::chrono::milliseconds(10));
@@ -216,7 +235,7 @@ TEST_F(BlockchainServiceTest, CountBlocksAfterHashWorks)
     blockchain::Block block3 = createValidBlock(block2.hash, "block 3");
     chainRepo->insertBlock(block3);
 
-    EXPECT_EQ(blockchainService->countBlocksAfterHash("0"), 3);
+    EXPECT_EQ(blockchainService->countBlocksAfterHash(blockchain::Hash{}), 3);
     EXPECT_EQ(blockchainService->countBlocksAfterHash(block1.hash), 2);
     EXPECT_EQ(blockchainService->countBlocksAfterHash(block2.hash), 1);
     EXPECT_EQ(blockchainService->countBlocksAfterHash(block3.hash), 0);
@@ -226,7 +245,7 @@ TEST_F(BlockchainServiceTest, GetBlocksByIndexRangeWorks)
 {
     std::vector<blockchain::Block> originalBlocks;
 
-    blockchain::Block block1 = createValidBlock("0", "block 1");
+    blockchain::Block block1 = createValidBlock(blockchain::Hash{}, "block 1");
     chainRepo->insertBlock(block1);
     originalBlocks.push_back(block1);
 
@@ -243,16 +262,357 @@ TEST_F(BlockchainServiceTest, GetBlocksByIndexRangeWorks)
     originalBlocks.push_back(block3);
 
     std::vector<blockchain::Block> retrieved;
-    blockchainService->getBlocksByIndexRange(0, 2, "0", retrieved);
+    blockchainService->getBlocksByIndexRange(0, 2, blockchain::Hash{}, retrieved);
 
     ASSERT_EQ(retrieved.size(), 2);
     EXPECT_EQ(retrieved[0].hash, block1.hash);
     EXPECT_EQ(retrieved[1].hash, block2.hash);
 
     retrieved.clear();
-    blockchainService->getBlocksByIndexRange(1, 2, "0", retrieved);
+    blockchainService->getBlocksByIndexRange(1, 2, blockchain::Hash{}, retrieved);
 
     ASSERT_EQ(retrieved.size(), 2);
     EXPECT_EQ(retrieved[0].hash, block2.hash);
     EXPECT_EQ(retrieved[1].hash, block3.hash);
-}
\ No newline at end of file
+}
+TEST_F(BlockchainServiceTest, BroadcastSendsToPeersConcurrently)
+{
+    std::vector<peer::UserPeer> peers;
+    for (unsigned short i = 0; i < 20; ++i)
+        peers.push_back(
+            test_helpers::createTestPeer(test_helpers::TEST_PORT_BASE + 100 + i, crypto));
+
+    auto sendCallback = [](const std::string&, const peer::UserPeer&) -> bool
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        return true;
+    };
+
+    blockchain::Block block = createValidBlock(blockchain::Hash{}, "broadcast");
+    blockchain::BroadcastResult result;
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(blockchainService->storeAndBroadcastBlock(block, peers, sendCallback, result));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_LT(elapsed, std::chrono::milliseconds(1000));
+    EXPECT_EQ(result.accepted.size(), peers.size());
+    EXPECT_TRUE(result.rejected.empty());
+    EXPECT_TRUE(result.timedOut.empty());
+    EXPECT_TRUE(result.stored);
+    EXPECT_TRUE(chainRepo->hasBlock(block.hash));
+}
+
+TEST_F(BlockchainServiceTest, BroadcastRejectedByPeerIsNotStored)
+{
+    peer::UserPeer goodPeer = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto);
+    peer::UserPeer badPeer = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER2, crypto);
+
+    auto sendCallback = [&badPeer](const std::string&, const peer::UserPeer& peer) -> bool
+    {
+        if (peer.port == badPeer.port) throw std::runtime_error("connection reset");
+        return true;
+    };
+
+    blockchain::Block block = createValidBlock(blockchain::Hash{}, "rejected");
+    blockchain::BroadcastResult result;
+
+    EXPECT_FALSE(blockchainService->storeAndBroadcastBlock(
+        block, { goodPeer, badPeer }, sendCallback, result));
+    ASSERT_EQ(result.accepted.size(), 1);
+    ASSERT_EQ(result.rejected.size(), 1);
+    EXPECT_EQ(result.rejected[0].port, badPeer.port);
+    EXPECT_FALSE(result.stored);
+}
+
+TEST_F(BlockchainServiceTest, BroadcastSlowPeerTimesOut)
+{
+    peer::UserPeer fastPeer = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto);
+    peer::UserPeer slowPeer = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER2, crypto);
+
+    auto sendCallback = [&slowPeer](const std::string&, const peer::UserPeer& peer) -> bool
+    {
+        if (peer.port == slowPeer.port) std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        return true;
+    };
+
+    blockchain::BroadcastPolicy policy;
+    policy.timeoutMs = 100;
+    policy.quorum = 1;
+
+    blockchain::Block block = createValidBlock(blockchain::Hash{}, "timeout");
+    blockchain::BroadcastResult result;
+
+    EXPECT_TRUE(blockchainService->storeAndBroadcastBlock(
+        block, { fastPeer, slowPeer }, sendCallback, result, policy));
+    ASSERT_EQ(result.timedOut.size(), 1);
+    EXPECT_EQ(result.timedOut[0].port, slowPeer.port);
+    EXPECT_EQ(result.accepted.size(), 1);
+
+    policy.quorum = 2;
+    blockchain::Block next = createValidBlock(block.hash, "quorum");
+    EXPECT_FALSE(blockchainService->storeAndBroadcastBlock(
+        next, { fastPeer, slowPeer }, sendCallback, result, policy));
+    EXPECT_FALSE(result.stored);
+}
+
+TEST_F(BlockchainServiceTest, BroadcastDoesNotWaitForFullPool)
+{
+    // more peers than the broadcast pool can queue, and none of them answers in time
+    std::vector<peer::UserPeer> peers;
+    for (unsigned short i = 0; i < blockchain::BROADCAST_WORKERS * 16 + 10; ++i)
+        peers.emplace_back("127.0.0.1", test_helpers::TEST_PORT_BASE + 100 + i, "key");
+
+    std::atomic<bool> release(false);
+    auto sendCallback = [&release](const std::string&, const peer::UserPeer&) -> bool
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (!release.load() && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return true;
+    };
+
+    blockchain::BroadcastPolicy policy;
+    policy.timeoutMs = 100;
+
+    blockchain::Block block = createValidBlock(blockchain::Hash{}, "full pool");
+    blockchain::BroadcastResult result;
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(blockchainService->storeAndBroadcastBlock(
+        block, peers, sendCallback, result, policy));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    release.store(true);
+
+    EXPECT_LT(elapsed, std::chrono::milliseconds(1000));
+    EXPECT_EQ(result.rejected.size(), 10u);
+    EXPECT_EQ(result.timedOut.size(), peers.size() - 10);
+}
+
+TEST_F(BlockchainServiceTest, InsertBlocksStoresSegmentAtomically)
+{
+    blockchain::Block genesis = createValidBlock(blockchain::Hash{}, "genesis");
+    ASSERT_TRUE(chainRepo->insertBlock(genesis));
+
+    std::vector<blockchain::Block> segment;
+    blockchain::Hash previousHash = genesis.hash;
+    for (int i = 0; i < 50; ++i)
+    {
+        segment.push_back(createValidBlock(previousHash, "block " + std::to_string(i)));
+        previousHash = segment.back().hash;
+    }
+
+    EXPECT_TRUE(chainRepo->insertBlocks(segment));
+    EXPECT_EQ(blockchainService->countBlocksAfterHash(genesis.hash), 50);
+
+    // a segment that breaks halfway leaves nothing behind
+    blockchain::Block next = createValidBlock(previousHash, "next");
+    blockchain::Block broken = createValidBlock(utils::sha256Digest("unknown"), "broken");
+    EXPECT_FALSE(chainRepo->insertBlocks({ next, broken }));
+    EXPECT_FALSE(chainRepo->hasBlock(next.hash));
+
+    // a segment forking off an inner block is rejected
+    blockchain::Block fork = createValidBlock(genesis.hash, "fork");
+    EXPECT_FALSE(chainRepo->insertBlocks({ fork }));
+    EXPECT_TRUE(blockchainService->validateLocalChain());
+}
+
+TEST_F(BlockchainServiceTest, InitMigratesChainWithoutHeightColumn)
+{
+    std::string dbPath = env->createTestDatabase("legacy_chain");
+    auto legacyDb = std::make_shared<db::DBFile>(dbPath);
+
+    // schema used before blocks had a height column
+    legacyDb->exec(R"(
+        CREATE TABLE blocks (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            hash TEXT NOT NULL UNIQUE,
+            previous_hash TEXT NOT NULL,
+            payload_hash TEXT NOT NULL,
+            author_public_key TEXT NOT NULL,
+            signature TEXT NOT NULL,
+            timestamp INTEGER NOT NULL
+        );
+    )");
+
+    std::vector<blockchain::Block> blocks;
+    blockchain::Hash previousHash{};
+    for (int i = 0; i < 5; ++i)
+    {
+        blocks.push_back(createValidBlock(previousHash, "legacy " + std::to_string(i)));
+        previousHash = blocks.back().hash;
+
+        // gaps in id must not leave gaps in height
+        legacyDb->executePrepared(
+            "INSERT INTO blocks(id, hash, previous_hash, payload_hash, author_public_key, "
+            "signature, timestamp) VALUES (?,?,?,?,?,?,?);",
+            { std::to_string(i * 10 + 1),
+              blocks.back().hashHex(),
+              blockchain::hashToHex(blocks.back().previousHash),
+              blockchain::hashToHex(blocks.back().payloadHash),
+              blocks.back().authorPublicKeyBase64(),
+              blocks.back().signatureBase64(),
+              std::to_string(blocks.back().timestamp) });
+    }
+
+    auto legacyRepo = std::make_shared<blockchain::ChainDB>(legacyDb, config, crypto);
+    ASSERT_NO_THROW(legacyRepo->init());
+
+    u_int tipIndex = 0;
+    ASSERT_TRUE(legacyRepo->findTipIndex(tipIndex));
+    EXPECT_EQ(tipIndex, 4);
+    EXPECT_EQ(legacyRepo->countBlocksAfterHash(blocks[1].hash), 3);
+
+    std::vector<blockchain::Block> range;
+    legacyRepo->getBlocksByIndexRange(0, 2, blocks[1].hash, range);
+    ASSERT_EQ(range.size(), 2);
+    EXPECT_EQ(range[0].hash, blocks[2].hash);
+    EXPECT_EQ(range[1].hash, blocks[3].hash);
+
+    blockchain::Block next = createValidBlock(previousHash, "after migration");
+    EXPECT_TRUE(legacyRepo->insertBlock(next));
+    EXPECT_EQ(legacyRepo->countBlocksAfterHash(blockchain::Hash{}), 6);
+
+    // running init again on a migrated database changes nothing
+    ASSERT_NO_THROW(legacyRepo->init());
+    EXPECT_EQ(legacyRepo->countBlocksAfterHash(blocks[4].hash), 1);
+
+    legacyDb->close();
+}
+
+TEST_F(BlockchainServiceTest, ChainIndexMatchesDatabaseAfterReload)
+{
+    blockchain::Block block1 = createValidBlock(blockchain::Hash{}, "index 1");
+    blockchain::Block block2 = createValidBlock(block1.hash, "index 2");
+    blockchain::Block block3 = createValidBlock(block2.hash, "index 3");
+
+    ASSERT_TRUE(chainRepo->insertBlock(block1));
+    ASSERT_TRUE(chainRepo->insertBlocks({ block2, block3 }));
+
+    // failed inserts must not reach the index
+    blockchain::Block fork = createValidBlock(block1.hash, "fork");
+    EXPECT_FALSE(chainRepo->insertBlock(fork));
+    EXPECT_FALSE(chainRepo->hasBlock(fork.hash));
+
+    auto reloaded = std::make_shared<blockchain::ChainDB>(db, config, crypto);
+    reloaded->init();
+
+    for (const auto& repo : { chainRepo, std::shared_ptr<blockchain::IChainRepo>(reloaded) })
+    {
+        blockchain::Block tip;
+        ASSERT_TRUE(repo->findTip(tip));
+        EXPECT_EQ(tip.hash, block3.hash);
+        EXPECT_EQ(tip.signature, block3.signature);
+
+        u_int tipIndex = 0;
+        ASSERT_TRUE(repo->findTipIndex(tipIndex));
+        EXPECT_EQ(tipIndex, 2);
+        EXPECT_TRUE(repo->hasBlock(block2.hash));
+        EXPECT_EQ(repo->countBlocksAfterHash(block1.hash), 2);
+    }
+}
+
+TEST_F(BlockchainServiceTest, ValidateLocalChainResumesFromCheckpoint)
+{
+    blockchain::Block block1 = createValidBlock(blockchain::Hash{}, "checkpoint 1");
+    blockchain::Block block2 = createValidBlock(block1.hash, "checkpoint 2");
+    ASSERT_TRUE(chainRepo->insertBlocks({ block1, block2 }));
+
+    EXPECT_TRUE(blockchainService->validateLocalChain());
+
+    u_int height = 0;
+    blockchain::Hash hash;
+    ASSERT_TRUE(chainRepo->findCheckpoint(height, hash));
+    EXPECT_EQ(height, 1);
+    EXPECT_EQ(hash, block2.hash);
+
+    // blocks behind the checkpoint are not checked again unless asked to
+    db->executePrepared("UPDATE blocks SET signature=? WHERE hash=?;",
+                        { block2.signatureBase64(), block1.hashHex() });
+
+    blockchain::Block block3 = createValidBlock(block2.hash, "checkpoint 3");
+    ASSERT_TRUE(chainRepo->insertBlock(block3));
+
+    EXPECT_TRUE(blockchainService->validateLocalChain());
+    ASSERT_TRUE(chainRepo->findCheckpoint(height, hash));
+    EXPECT_EQ(height, 2);
+    EXPECT_EQ(hash, block3.hash);
+
+    EXPECT_FALSE(blockchainService->validateLocalChain(true));
+    EXPECT_FALSE(chainRepo->findCheckpoint(height, hash));
+    EXPECT_FALSE(blockchainService->validateLocalChain());
+}
+
+TEST_F(BlockchainServiceTest, CheckpointMissingFromChainIsIgnored)
+{
+    blockchain::Block block1 = createValidBlock(blockchain::Hash{}, "stale 1");
+    ASSERT_TRUE(chainRepo->insertBlock(block1));
+
+    chainRepo->saveCheckpoint(0, utils::sha256Digest("unknown hash"));
+
+    u_int height = 0;
+    blockchain::Hash hash;
+    EXPECT_FALSE(chainRepo->findCheckpoint(height, hash));
+
+    chainRepo->saveCheckpoint(3, block1.hash);  // right block, wrong height
+    EXPECT_FALSE(chainRepo->findCheckpoint(height, hash));
+
+    EXPECT_TRUE(blockchainService->validateLocalChain());
+    ASSERT_TRUE(chainRepo->findCheckpoint(height, hash));
+    EXPECT_EQ(height, 0);
+    EXPECT_EQ(hash, block1.hash);
+}
+
+TEST_F(BlockchainServiceTest, ValidateLocalChainWalksChainInWindows)
+{
+    // spans several validation windows, the last one partially filled
+    std::vector<blockchain::Block> blocks;
+    blockchain::Hash previousHash{};
+    for (u_int i = 0; i < blockchain::VALIDATION_WINDOW * 2 + 17; ++i)
+    {
+        blocks.push_back(createValidBlock(previousHash, "window " + std::to_string(i)));
+        previousHash = blocks.back().hash;
+    }
+    ASSERT_TRUE(chainRepo->insertBlocks(blocks));
+
+    EXPECT_TRUE(blockchainService->validateLocalChain(true));
+
+    u_int height = 0;
+    blockchain::Hash hash;
+    ASSERT_TRUE(chainRepo->findCheckpoint(height, hash));
+    EXPECT_EQ(height, blocks.size() - 1);
+    EXPECT_EQ(hash, blocks.back().hash);
+
+    // broken block right after a window boundary
+    const blockchain::Block& broken = blocks[blockchain::VALIDATION_WINDOW + 1];
+    db->executePrepared("UPDATE blocks SET payload_hash=? WHERE hash=?;",
+                        { utils::sha256("tampered"), broken.hashHex() });
+
+    EXPECT_FALSE(blockchainService->validateLocalChain(true));
+}
+
+TEST_F(BlockchainServiceTest, ValidateLocalChainStopsAtFirstInvalidWindow)
+{
+    auto countingRepo = std::make_shared<CountingChainDB>(db, config, crypto);
+    countingRepo->init();
+    auto service =
+        std::make_shared<blockchain::BlockchainService>(config, crypto, countingRepo, consoleUI);
+
+    std::vector<blockchain::Block> blocks;
+    blockchain::Hash previousHash{};
+    for (u_int i = 0; i < blockchain::VALIDATION_WINDOW * 4; ++i)
+    {
+        blocks.push_back(createValidBlock(previousHash, "window " + std::to_string(i)));
+        previousHash = blocks.back().hash;
+    }
+    ASSERT_TRUE(countingRepo->insertBlocks(blocks));
+
+    // broken block near genesis
+    db->executePrepared("UPDATE blocks SET payload_hash=? WHERE hash=?;",
+                        { utils::sha256("tampered"), blocks[1].hashHex() });
+
+    countingRepo->rangeReads = 0;
+    EXPECT_FALSE(service->validateLocalChain(true));
+    // the first window and at most the one read ahead of it
+    EXPECT_LE(countingRepo->rangeReads.load(), 2);
+}
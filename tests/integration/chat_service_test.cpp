@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include "BlockRangeMessage.hpp"
 #include "BlockchainService.hpp"
 #include "ChainDB.hpp"
 #include "ChatService.hpp"
@@ -14,6 +15,8 @@
 #include "PeerListMessage.hpp"
 #include "PeerService.hpp"
 #include "TextMessage.hpp"
+#include "binary.hpp"
+#include "sha256.hpp"
 #include "test_helpers.hpp"
 #include "timestamp.hpp"
 #include "uuid.hpp"
@@ -138,6 +141,120 @@ TEST_F(ChatServiceTest, HandleIncomingPeerListMessageSucceeds)
     EXPECT_LE(payload.size(), 2);
 }
 
+TEST_F(ChatServiceTest, PeerListCanNotReplaceKeyOfKnownPeer)
+{
+    peer::UserPeer known = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto);
+    peerService->addPeer(known);
+
+    // a relayed list claims the known address with another key
+    peer::UserPeer spoofed = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto);
+    peer::UserPeer from = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER2, crypto);
+    peer::UserPeer to(
+        "127.0.0.1", test_helpers::TEST_PORT_BASE, crypto->keyToString(keyPair.publicKey));
+
+    message::PeerListMessageResponse peerList =
+        message::PeerListMessageResponse::create(from, to, { spoofed });
+    chatService->handleOutgoingMessage(peerList.toWire(message::WireFormat::JSON));
+
+    ASSERT_EQ(peerService->getPeersCount(), 1);
+    EXPECT_EQ(peerService->findPeer(known).publicKey, known.publicKey);
+}
+
+TEST_F(ChatServiceTest, ConnectionNegotiatesBinaryFormat)
+{
+    peer::UserPeer from = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto);
+    peer::UserPeer to(
+        "127.0.0.1", test_helpers::TEST_PORT_BASE, crypto->keyToString(keyPair.publicKey));
+
+    // the first CONNECT goes out as JSON, the format is not agreed on yet
+    message::ConnectionMessage connMsg = message::ConnectionMessage::create(from, to, "0");
+    nlohmann::json jData;
+    connMsg.serialize(jData);
+
+    std::string response;
+    chatService->handleIncomingMessage(jData, response);
+
+    message::ConnectionMessageResponse connResponse(nlohmann::json::parse(response));
+    EXPECT_EQ(connResponse.getPayload().wireVersion, message::WIRE_VERSION);
+    EXPECT_EQ(peerService->getWireVersion(from), message::WIRE_VERSION);
+
+    // later requests are binary and get binary answers
+    message::PeerListMessage peerListMsg = message::PeerListMessage::create(from, to, 0, 10);
+    std::string frame = peerListMsg.toWire(message::WireFormat::BINARY);
+
+    chatService->handleIncomingBinaryMessage(frame, response);
+    ASSERT_TRUE(message::Message::isBinaryFrame(response));
+    EXPECT_EQ(message::Message::peekBinaryType(response),
+              message::MessageType::PEER_LIST_RESPONSE);
+
+    utils::BinaryReader reader(response);
+    message::PeerListMessageResponse peerList(reader);
+    EXPECT_TRUE(peerList.getPayload().peers.empty());  // the only peer is the requestor
+}
+
+TEST_F(ChatServiceTest, ConnectionFromPeerWithoutBinaryFormatStaysJson)
+{
+    peer::UserPeer from = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto);
+    peer::UserPeer to(
+        "127.0.0.1", test_helpers::TEST_PORT_BASE, crypto->keyToString(keyPair.publicKey));
+
+    message::ConnectionMessage connMsg = message::ConnectionMessage::create(from, to, "0", 0);
+    nlohmann::json jData;
+    connMsg.serialize(jData);
+
+    std::string response;
+    chatService->handleIncomingMessage(jData, response);
+
+    message::ConnectionMessageResponse connResponse(nlohmann::json::parse(response));
+    EXPECT_EQ(connResponse.getPayload().wireVersion, 0);
+    EXPECT_EQ(peerService->getWireVersion(from), 0);
+
+    // the client side records what the server agreed on
+    message::ConnectionMessageResponse binaryResponse =
+        message::ConnectionMessageResponse::create(from, to, 0, 0, message::WIRE_VERSION);
+    chatService->handleOutgoingMessage(binaryResponse.toWire(message::WireFormat::BINARY));
+    EXPECT_EQ(peerService->getWireVersion(from), message::WIRE_VERSION);
+}
+
+TEST_F(ChatServiceTest, MalformedBinaryRequestGetsErrorResponse)
+{
+    std::string frame("\0\1\3truncated", 12);
+
+    std::string response;
+    chatService->handleIncomingBinaryMessage(frame, response);
+
+    nlohmann::json jResponse = nlohmann::json::parse(response);
+    EXPECT_EQ(jResponse["type"], "ERROR_RESPONSE");
+    EXPECT_EQ(jResponse["error"], "Invalid data format");
+}
+
+TEST_F(ChatServiceTest, FailingBinaryRequestGetsErrorResponseWithoutDetails)
+{
+    peer::UserPeer from = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto);
+    peer::UserPeer to(
+        "127.0.0.1", test_helpers::TEST_PORT_BASE, crypto->keyToString(keyPair.publicKey));
+
+    // reading the blocks fails, the database error must not reach the peer.
+    // closing first drops the cached statements, so the query is prepared again
+    db->close();
+    db->exec("DROP TABLE blocks;");
+
+    message::BlockRangeMessage blockRangeMsg =
+        message::BlockRangeMessage::create(from, to, 0, 2, "0");
+
+    std::string response;
+    chatService->handleIncomingBinaryMessage(blockRangeMsg.toWire(message::WireFormat::BINARY),
+                                             response);
+
+    ASSERT_TRUE(message::Message::isBinaryFrame(response));
+    utils::BinaryReader reader(response);
+    message::ErrorMessageResponse error(reader);
+    EXPECT_EQ(error.getType(), message::MessageType::ERROR_RESPONSE);
+    EXPECT_EQ(error.getTo().port, from.port);
+    EXPECT_EQ(error.getPayload().error, "Invalid request");
+    EXPECT_EQ(response.find("blocks"), std::string::npos);
+}
+
 TEST_F(ChatServiceTest, HandleOutgoingConnectionMessageUpdatesPeerCount)
 {
     peer::UserPeer from = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto);
@@ -196,27 +313,55 @@ TEST_F(ChatServiceTest, HandleIncomingTextMessageStoresMessage)
     EXPECT_EQ(messages[0].getPayload().message, messageContent);
 }
 
+TEST_F(ChatServiceTest, IncomingTextMessageIsStoredAsReceived)
+{
+    auto keyPair2 = crypto->generateKeyPair();
+
+    peer::UserPeer from(
+        "127.0.0.1", test_helpers::TEST_PORT_PEER1, crypto->keyToString(keyPair2.publicKey));
+    peer::UserPeer to(
+        "127.0.0.1", test_helpers::TEST_PORT_BASE, crypto->keyToString(keyPair.publicKey));
+
+    message::TextMessage textMsg(
+        utils::uuidv4(), from, to, utils::getTimestamp(), "stored as sent", "test_block_hash");
+
+    nlohmann::json jData;
+    textMsg.serialize(jData, crypto->keyToString(keyPair2.privateKey), crypto);
+    std::string text = jData.dump(2);  // not what dump() of the parsed document would give
+
+    std::string response;
+    chatService->handleIncomingMessage(text, nlohmann::json::parse(text), response);
+    EXPECT_EQ(nlohmann::json::parse(response)["type"], "TEXT_MESSAGE_RESPONSE");
+
+    std::vector<std::string> stored;
+    db->selectRows("SELECT message_json FROM messages;",
+                   {},
+                   [&stored](const db::Row& row) { stored.emplace_back(row.getText(0)); });
+
+    ASSERT_EQ(stored.size(), 1u);
+    EXPECT_EQ(stored[0], text);
+}
+
 TEST_F(ChatServiceTest, HandleIncomingBlockRangeMessageReturnsBlocks)
 {
     // Create and insert some test blocks
     blockchain::Block block1;
-    block1.hash = "hash1";
-    block1.previousHash = "0";
-    block1.payloadHash = "payload1";
-    block1.authorPublicKey = crypto->keyToString(keyPair.publicKey);
+    block1.hash = utils::sha256Digest("hash1");
+    block1.payloadHash = utils::sha256Digest("payload1");
+    block1.authorPublicKey = keyPair.publicKey;
     block1.timestamp = utils::getTimestamp();
-    block1.signature = "sig1";
+    block1.signature = { 's', 'i', 'g', '1' };
     chainRepo->insertBlock(block1);
 
     std::this_thread::sleep_for(std::chrono::milliseconds(10));
 
     blockchain::Block block2;
-    block2.hash = "hash2";
-    block2.previousHash = "hash1";
-    block2.payloadHash = "payload2";
-    block2.authorPublicKey = crypto->keyToString(keyPair.publicKey);
+    block2.hash = utils::sha256Digest("hash2");
+    block2.previousHash = block1.hash;
+    block2.payloadHash = utils::sha256Digest("payload2");
+    block2.authorPublicKey = keyPair.publicKey;
     block2.timestamp = utils::getTimestamp();
-    block2.signature = "sig2";
+    block2.signature = { 's', 'i', 'g', '2' };
     chainRepo->insertBlock(block2);
 
     peer::UserPeer from = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto);
@@ -287,6 +432,32 @@ TEST_F(ChatServiceTest, HandleIncomingInvalidMessageReturnsError)
     EXPECT_EQ(jResponse3["type"].get<std::string>(), "ERROR_RESPONSE");
 }
 
+TEST_F(ChatServiceTest, MessagesWithoutServerHandlerAreRejected)
+{
+    peer::UserPeer from = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto);
+    peer::UserPeer to(
+        "127.0.0.1", test_helpers::TEST_PORT_BASE, crypto->keyToString(keyPair.publicKey));
+
+    // responses are only read on the client side
+    message::ConnectionMessageResponse connResponse =
+        message::ConnectionMessageResponse::create(from, to, 0, 0);
+    nlohmann::json jData;
+    connResponse.serialize(jData);
+
+    std::string response;
+    chatService->handleIncomingMessage(jData, response);
+    EXPECT_EQ(nlohmann::json::parse(response)["error"], "Invalid message type");
+
+    chatService->handleIncomingBinaryMessage(connResponse.toWire(message::WireFormat::BINARY),
+                                             response);
+    EXPECT_EQ(nlohmann::json::parse(response)["error"], "Invalid message type");
+
+    jData.erase("type");
+    chatService->handleIncomingMessage(jData, response);
+    EXPECT_EQ(nlohmann::json::parse(response)["error"], "Invalid message type");
+    EXPECT_TRUE(peerService->getPeers().empty());
+}
+
 TEST_F(ChatServiceTest, HandleIncomingMalformedJSONReturnsError)
 {
     nlohmann::json malformedJson;
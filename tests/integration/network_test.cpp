@@ -3,6 +3,7 @@
 #include <atomic>
 #include <thread>
 
+#include "ConnectionPool.hpp"
 #include "SocketClient.hpp"
 #include "SocketServer.hpp"
 #include "test_helpers.hpp"
@@ -178,4 +179,289 @@ TEST_F(NetworkTest, FindFreePortReturnsValidPort)
         server.startAsync([](const char*, int, std::function<void(const std::string&)>) {}));
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
     server.stop();
-}
\ No newline at end of file
+}
+
+TEST_F(NetworkTest, SocketClientSendsMessageLargerThanBufferIntact)
+{
+    const unsigned short port = test_helpers::TEST_PORT_BASE + 4;
+    std::string largeMessage(network::BUFFER_SIZE * 4 + 123, 'x');
+    largeMessage.front() = '{';
+    largeMessage.back() = '}';
+
+    std::atomic<size_t> receivedSize(0);
+
+    std::thread serverThread(
+        [&receivedSize, port]()
+        {
+            network::SocketServer server(port);
+
+            server.startAsync(
+                [&receivedSize](const char* buffer,
+                                int bufferSize,
+                                std::function<void(const std::string&)> send)
+                {
+                    receivedSize.store(static_cast<size_t>(bufferSize));
+                    send(std::string(buffer, bufferSize));  // echo back
+                });
+
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+            server.stop();
+        });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    network::SocketClient client;
+    ASSERT_TRUE(client.connectTo("127.0.0.1", port));
+    EXPECT_TRUE(client.sendMessage(largeMessage));
+
+    std::string response = client.receiveMessage();
+    EXPECT_EQ(receivedSize.load(), largeMessage.size());
+    EXPECT_EQ(response, largeMessage);
+
+    client.disconnect();
+    serverThread.join();
+}
+
+
+TEST_F(NetworkTest, SocketServerServesManyRequestsOnOneConnection)
+{
+    const unsigned short port = test_helpers::TEST_PORT_BASE + 5;
+    std::atomic<int> requestCount(0);
+
+    std::thread serverThread(
+        [&requestCount, port]()
+        {
+            network::SocketServer server(port);
+
+            server.startAsync(
+                [&requestCount](
+                    const char* buffer, int bufferSize, std::function<void(const std::string&)> send)
+                {
+                    requestCount.fetch_add(1);
+                    send("echo:" + std::string(buffer, bufferSize));
+                });
+
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+            server.stop();
+        });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    network::SocketClient client;
+    ASSERT_TRUE(client.connectTo("127.0.0.1", port));
+
+    for (int i = 0; i < 3; ++i)
+    {
+        std::string message = "request " + std::to_string(i);
+        EXPECT_TRUE(client.sendMessage(message));
+        EXPECT_EQ(client.receiveMessage(), "echo:" + message);
+        EXPECT_TRUE(client.isAlive());
+    }
+
+    EXPECT_EQ(requestCount.load(), 3);
+
+    client.disconnect();
+    serverThread.join();
+}
+
+TEST_F(NetworkTest, ConnectionPoolReusesConnectionToSameHost)
+{
+    const unsigned short port = test_helpers::TEST_PORT_BASE + 6;
+
+    std::thread serverThread(
+        [port]()
+        {
+            network::SocketServer server(port);
+
+            server.startAsync([](const char*, int, std::function<void(const std::string&)> send)
+                              { send("ACK"); });
+
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+            server.stop();
+        });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    network::ConnectionPool pool;
+    peer::UserHost host("127.0.0.1", port);
+    std::string response;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        ASSERT_TRUE(pool.request(host, "ping", response));
+        EXPECT_EQ(response, "ACK");
+        EXPECT_EQ(pool.idleCount(), 1u);
+    }
+
+    pool.closeAll();
+    EXPECT_EQ(pool.idleCount(), 0u);
+
+    EXPECT_FALSE(pool.request(peer::UserHost("127.0.0.1", 19999), "ping", response));
+
+    serverThread.join();
+}
+
+TEST_F(NetworkTest, ConnectionPoolDoesNotResendAfterTimeout)
+{
+    const unsigned short port = test_helpers::TEST_PORT_BASE + 10;
+    std::atomic<int> slowCount(0);
+
+    network::SocketServer server(port);
+    ASSERT_TRUE(server.startAsync(
+        [&slowCount](
+            const char* buffer, int bufferSize, std::function<void(const std::string&)> send)
+        {
+            // the peer handles the request but answers after the client gave up waiting
+            if (std::string(buffer, bufferSize) == "slow")
+            {
+                slowCount.fetch_add(1);
+                std::this_thread::sleep_for(std::chrono::milliseconds(600));
+            }
+            send("ACK");
+        }));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    network::ConnectionPool pool(200);
+    peer::UserHost host("127.0.0.1", port);
+    std::string response;
+
+    ASSERT_TRUE(pool.request(host, "ping", response));
+    ASSERT_EQ(pool.idleCount(), 1u);
+
+    EXPECT_FALSE(pool.request(host, "slow", response));
+    std::this_thread::sleep_for(std::chrono::milliseconds(800));
+    EXPECT_EQ(slowCount.load(), 1);
+
+    server.stop();
+}
+
+TEST_F(NetworkTest, SocketServerKeepsManyConnectionsOpen)
+{
+    const unsigned short port = test_helpers::TEST_PORT_BASE + 7;
+    const int numClients = 50;  // stays below the select() backend limit on Windows
+
+    network::SocketServer server(port);
+    ASSERT_TRUE(server.startAsync(
+        [](const char* buffer, int bufferSize, std::function<void(const std::string&)> send)
+        { send(std::string(buffer, bufferSize)); }));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // all clients are connected at the same time before any of them sends a request
+    std::vector<network::SocketClient> clients(numClients);
+    for (auto& client : clients)
+    {
+        ASSERT_TRUE(client.connectTo("127.0.0.1", port));
+    }
+
+    for (int i = 0; i < numClients; ++i)
+    {
+        std::string message = "client " + std::to_string(i);
+        ASSERT_TRUE(clients[i].sendMessage(message));
+        EXPECT_EQ(clients[i].receiveMessage(), message);
+    }
+
+    server.stop();
+}
+
+TEST_F(NetworkTest, SlowPeerDoesNotBlockOtherClients)
+{
+    const unsigned short port = test_helpers::TEST_PORT_BASE + 8;
+
+    network::SocketServer server(port);
+    ASSERT_TRUE(server.startAsync(
+        [](const char*, int, std::function<void(const std::string&)> send) { send("ACK"); }));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // the slow peer sends only half of a frame header and then stalls
+    SOCKET slowSocket = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    ASSERT_NE(connect(slowSocket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), SOCKET_ERROR);
+    send(slowSocket, "\0\0", 2, 0);
+
+    network::SocketClient client;
+    ASSERT_TRUE(client.connectTo("127.0.0.1", port));
+    ASSERT_TRUE(client.sendMessage("ping"));
+    EXPECT_EQ(client.receiveMessage(), "ACK");
+
+    closesocket(slowSocket);
+    server.stop();
+}
+
+TEST_F(NetworkTest, SocketServerWithWorkersKeepsPerConnectionOrder)
+{
+    const unsigned short port = test_helpers::TEST_PORT_BASE + 9;
+
+    network::SocketServer server(port, 4);
+    ASSERT_TRUE(server.startAsync(
+        [](const char* buffer, int bufferSize, std::function<void(const std::string&)> send)
+        {
+            // a slow request must not overtake or be overtaken on the same connection
+            if (std::string(buffer, bufferSize) == "slow")
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            send(std::string(buffer, bufferSize));
+        }));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    network::SocketClient slowClient;
+    network::SocketClient fastClient;
+    ASSERT_TRUE(slowClient.connectTo("127.0.0.1", port));
+    ASSERT_TRUE(fastClient.connectTo("127.0.0.1", port));
+
+    // pipeline two requests on one connection
+    ASSERT_TRUE(slowClient.sendMessage("slow"));
+    ASSERT_TRUE(slowClient.sendMessage("after slow"));
+
+    // another connection is served while the slow request is still running
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(fastClient.sendMessage("fast"));
+    EXPECT_EQ(fastClient.receiveMessage(), "fast");
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(150));
+
+    EXPECT_EQ(slowClient.receiveMessage(), "slow");
+    EXPECT_EQ(slowClient.receiveMessage(), "after slow");
+
+    server.stop();
+}
+
+TEST_F(NetworkTest, SocketServerDropsConnectionWhenHandlerThrows)
+{
+    // inline handling and workers treat a failing handler the same way
+    for (size_t workerCount : { 0, 2 })
+    {
+        const unsigned short port =
+            test_helpers::TEST_PORT_BASE + 11 + static_cast<unsigned short>(workerCount);
+
+        network::SocketServer server(port, workerCount);
+        ASSERT_TRUE(server.startAsync(
+            [](const char* buffer, int bufferSize, std::function<void(const std::string&)> send)
+            {
+                if (std::string(buffer, bufferSize) == "fail")
+                    throw std::runtime_error("handler failed");
+                send("ACK");
+            }));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        network::SocketClient failingClient;
+        ASSERT_TRUE(failingClient.connectTo("127.0.0.1", port));
+        ASSERT_TRUE(failingClient.sendMessage("fail"));
+        EXPECT_EQ(failingClient.receiveMessage(), "");
+        EXPECT_TRUE(failingClient.wasClosedByPeer());
+
+        // the server keeps serving other connections
+        network::SocketClient client;
+        ASSERT_TRUE(client.connectTo("127.0.0.1", port));
+        ASSERT_TRUE(client.sendMessage("ping"));
+        EXPECT_EQ(client.receiveMessage(), "ACK");
+        EXPECT_TRUE(server.listening());
+
+        server.stop();
+    }
+}
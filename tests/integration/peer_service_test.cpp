@@ -145,4 +145,55 @@ TEST_F(PeerServiceTest, FindPublicKeyForNonExistentPeerReturnsFalse)
     std::string publicKey;
 
     EXPECT_FALSE(peerService->findPublicKeyByUserHost(nonExistent, publicKey));
-}
\ No newline at end of file
+}
+TEST_F(PeerServiceTest, FindPeerByPublicKeySucceeds)
+{
+    peer::UserPeer peer1 = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto);
+    peer::UserPeer peer2 = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER2, crypto);
+
+    peerService->addPeer(peer1);
+    peerService->addPeer(peer2);
+
+    peer::UserPeer found;
+    ASSERT_TRUE(peerService->findPeerByPublicKey(peer2.publicKey, found));
+    EXPECT_EQ(found.port, peer2.port);
+
+    peerService->removePeer(peer2);
+    EXPECT_FALSE(peerService->findPeerByPublicKey(peer2.publicKey, found));
+}
+
+TEST_F(PeerServiceTest, KnownAddressKeepsItsKeyUntilRemoved)
+{
+    peer::UserPeer peer = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto);
+    peer::UserPeer other = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto);
+
+    peerService->addPeer(peer);
+    peerService->addPeer(other);
+
+    ASSERT_EQ(peerService->getPeersCount(), 1);
+    EXPECT_EQ(peerService->findPeer(peer).publicKey, peer.publicKey);
+
+    peer::UserPeer found;
+    EXPECT_FALSE(peerService->findPeerByPublicKey(other.publicKey, found));
+
+    // once the peer is gone the address may come back with a new key
+    peerService->removePeer(peer);
+    peerService->addPeer(other);
+    EXPECT_EQ(peerService->findPeer(peer).publicKey, other.publicKey);
+}
+
+TEST_F(PeerServiceTest, PeerTableIsNotChangedByLaterWrites)
+{
+    peer::UserPeer peer1 = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER1, crypto);
+    peer::UserPeer peer2 = test_helpers::createTestPeer(test_helpers::TEST_PORT_PEER2, crypto);
+
+    peerService->addPeer(peer1);
+    std::shared_ptr<const peer::PeerTable> table = peerService->getPeerTable();
+
+    peerService->addPeer(peer2);
+    peerService->removePeer(peer1);
+
+    ASSERT_EQ(table->peers.size(), 1);
+    EXPECT_EQ(table->peers[0].publicKey, peer1.publicKey);
+    EXPECT_EQ(peerService->getPeerTable()->peers[0].publicKey, peer2.publicKey);
+}
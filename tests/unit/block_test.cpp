@@ -3,6 +3,7 @@
 #include <gtest/gtest.h>
 
 #include "OpenSSLCrypto.hpp"
+#include "sha256.hpp"
 #include "timestamp.hpp"
 #include "uuid.hpp"
 
@@ -18,21 +19,22 @@ TEST_F(BlockTest, DefaultConstructorInitializesCorrectly)
 {
     blockchain::Block block;
 
-    EXPECT_EQ(block.hash, "0");
-    EXPECT_EQ(block.previousHash, "0");
-    EXPECT_EQ(block.payloadHash, "0");
-    EXPECT_EQ(block.authorPublicKey, "0");
-    EXPECT_EQ(block.signature, "0");
+    EXPECT_EQ(block.hash, blockchain::Hash{});
+    EXPECT_EQ(block.previousHash, blockchain::Hash{});
+    EXPECT_EQ(block.payloadHash, blockchain::Hash{});
+    EXPECT_TRUE(block.authorPublicKey.empty());
+    EXPECT_TRUE(block.signature.empty());
     EXPECT_EQ(block.timestamp, 0);
+    EXPECT_EQ(block.hashHex(), "0");
 }
 
 TEST_F(BlockTest, ParameterizedConstructorWorks)
 {
-    std::string hash = "hash123";
-    std::string prevHash = "prevHash456";
-    std::string payloadHash = "payloadHash789";
-    std::string authorKey = "authorKey";
-    std::string signature = "signature";
+    blockchain::Hash hash = utils::sha256Digest("hash123");
+    blockchain::Hash prevHash = utils::sha256Digest("prevHash456");
+    blockchain::Hash payloadHash = utils::sha256Digest("payloadHash789");
+    std::vector<uint8_t> authorKey = { 1, 2, 3 };
+    std::vector<uint8_t> signature = { 4, 5, 6, 7 };
     uint64_t timestamp = utils::getTimestamp();
 
     blockchain::Block block(hash, prevHash, payloadHash, authorKey, signature, timestamp);
@@ -48,35 +50,35 @@ TEST_F(BlockTest, ParameterizedConstructorWorks)
 TEST_F(BlockTest, ComputeHashProducesConsistentHash)
 {
     blockchain::Block block;
-    block.previousHash = "prev123";
-    block.payloadHash = "payload456";
-    block.authorPublicKey = "author789";
+    block.previousHash = utils::sha256Digest("prev123");
+    block.payloadHash = utils::sha256Digest("payload456");
+    block.authorPublicKey = { 7, 8, 9 };
     block.timestamp = 1234567890;
 
     block.computeHash();
-    std::string hash1 = block.hash;
+    blockchain::Hash hash1 = block.hash;
 
-    block.hash = "";
+    block.hash = blockchain::Hash{};
     block.computeHash();
-    std::string hash2 = block.hash;
+    blockchain::Hash hash2 = block.hash;
 
     EXPECT_EQ(hash1, hash2);
-    EXPECT_NE(hash1, "");
+    EXPECT_NE(hash1, blockchain::Hash{});
 }
 
 TEST_F(BlockTest, DifferentBlocksHaveDifferentHashes)
 {
     blockchain::Block block1;
-    block1.previousHash = "prev1";
-    block1.payloadHash = "payload1";
-    block1.authorPublicKey = "author1";
+    block1.previousHash = utils::sha256Digest("prev1");
+    block1.payloadHash = utils::sha256Digest("payload1");
+    block1.authorPublicKey = { 1 };
     block1.timestamp = 1000;
     block1.computeHash();
 
     blockchain::Block block2;
-    block2.previousHash = "prev2";
-    block2.payloadHash = "payload2";
-    block2.authorPublicKey = "author2";
+    block2.previousHash = utils::sha256Digest("prev2");
+    block2.payloadHash = utils::sha256Digest("payload2");
+    block2.authorPublicKey = { 2 };
     block2.timestamp = 2000;
     block2.computeHash();
 
@@ -86,27 +88,61 @@ TEST_F(BlockTest, DifferentBlocksHaveDifferentHashes)
 TEST_F(BlockTest, ToStringForHashIncludesAllFields)
 {
     blockchain::Block block;
-    block.previousHash = "prev";
-    block.payloadHash = "payload";
-    block.authorPublicKey = "author";
+    block.previousHash = utils::sha256Digest("prev");
+    block.payloadHash = utils::sha256Digest("payload");
+    block.authorPublicKey = { 'a', 'u', 't', 'h', 'o', 'r' };
     block.timestamp = 1234567890;
 
     std::string canonical = block.toStringForHash();
 
-    EXPECT_NE(canonical.find("prev"), std::string::npos);
-    EXPECT_NE(canonical.find("payload"), std::string::npos);
-    EXPECT_NE(canonical.find("author"), std::string::npos);
+    EXPECT_NE(canonical.find(utils::sha256("prev")), std::string::npos);
+    EXPECT_NE(canonical.find(utils::sha256("payload")), std::string::npos);
+    EXPECT_NE(canonical.find("YXV0aG9y"), std::string::npos);
     EXPECT_NE(canonical.find("1234567890"), std::string::npos);
 }
 
+TEST_F(BlockTest, HashMatchesTextFormOfTheBlock)
+{
+    // blocks stored before the binary fields were hashed over hex and base64 text
+    auto keyPair = crypto->generateKeyPair();
+    std::string publicKey = crypto->keyToString(keyPair.publicKey);
+
+    blockchain::Block block;
+    block.payloadHash = utils::sha256Digest("hello");
+    block.authorPublicKey = keyPair.publicKey;
+    block.timestamp = 1234567890;
+    block.computeHash();
+
+    std::string text = "0|" + utils::sha256("hello") + "|" + publicKey + "|1234567890";
+    EXPECT_EQ(block.toStringForHash(), text);
+    EXPECT_EQ(block.hashHex(), utils::sha256(text));
+    EXPECT_EQ(block.toJson()["authorPubKey"], publicKey);
+}
+
+TEST_F(BlockTest, StreamedHashMatchesCanonicalText)
+{
+    // key sizes around the base64 chunk used while hashing
+    for (size_t keySize : { 0, 1, 2, 47, 48, 49, 96, 200 })
+    {
+        blockchain::Block block;
+        block.previousHash = utils::sha256Digest("prev");
+        block.payloadHash = utils::sha256Digest("payload");
+        block.authorPublicKey.assign(keySize, 0xab);
+        block.timestamp = 18446744073709551615ULL;
+
+        EXPECT_EQ(block.calculateHash(), utils::sha256Digest(block.toStringForHash()))
+            << "key size " << keySize;
+    }
+}
+
 TEST_F(BlockTest, JsonSerializationRoundTrip)
 {
     blockchain::Block original;
-    original.hash = "hash123";
-    original.previousHash = "prevHash456";
-    original.payloadHash = "payloadHash789";
-    original.authorPublicKey = "authorKey";
-    original.signature = "signature";
+    original.hash = utils::sha256Digest("hash123");
+    original.previousHash = utils::sha256Digest("prevHash456");
+    original.payloadHash = utils::sha256Digest("payloadHash789");
+    original.authorPublicKey = { 1, 2, 3, 4, 5 };
+    original.signature = { 6, 7, 8, 9 };
     original.timestamp = 1234567890;
 
     nlohmann::json jData = original.toJson();
@@ -120,19 +156,35 @@ TEST_F(BlockTest, JsonSerializationRoundTrip)
     EXPECT_EQ(recovered.timestamp, original.timestamp);
 }
 
+TEST_F(BlockTest, MalformedJsonFieldsAreRejected)
+{
+    blockchain::Block block;
+    block.authorPublicKey = { 1, 2, 3 };
+    block.signature = { 4, 5, 6 };
+    block.computeHash();
+
+    nlohmann::json badHash = block.toJson();
+    badHash["hash"] = "wrong_hash";
+    EXPECT_THROW(blockchain::Block{ badHash }, std::runtime_error);
+
+    nlohmann::json badSignature = block.toJson();
+    badSignature["signature"] = "not base64!";
+    EXPECT_THROW(blockchain::Block{ badSignature }, std::runtime_error);
+}
+
 TEST_F(BlockTest, ModifyingFieldChangesHash)
 {
     blockchain::Block block;
-    block.previousHash = "prev";
-    block.payloadHash = "payload";
-    block.authorPublicKey = "author";
+    block.previousHash = utils::sha256Digest("prev");
+    block.payloadHash = utils::sha256Digest("payload");
+    block.authorPublicKey = { 1 };
     block.timestamp = 1000;
     block.computeHash();
-    std::string hash1 = block.hash;
+    blockchain::Hash hash1 = block.hash;
 
     block.timestamp = 2000;
     block.computeHash();
-    std::string hash2 = block.hash;
+    blockchain::Hash hash2 = block.hash;
 
     EXPECT_NE(hash1, hash2);
-}
\ No newline at end of file
+}
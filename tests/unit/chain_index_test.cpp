@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include "ChainIndex.hpp"
+#include "sha256.hpp"
+
+namespace
+{
+// stands in for a real block hash, "0" is the zero hash
+blockchain::Hash id(const std::string& name)
+{
+    return name == "0" ? blockchain::Hash{} : utils::sha256Digest(name);
+}
+
+blockchain::Block makeHeader(const std::string& hash, const std::string& previousHash)
+{
+    blockchain::Block block;
+    block.hash = id(hash);
+    block.previousHash = id(previousHash);
+    return block;
+}
+}  // namespace
+
+TEST(ChainIndexTest, EmptyIndexHasNoTip)
+{
+    blockchain::ChainIndex index;
+
+    blockchain::Block tip;
+    int64_t height = 0;
+    EXPECT_FALSE(index.findTip(tip));
+    EXPECT_FALSE(index.findTipHeight(height));
+    EXPECT_FALSE(index.contains(id("0")));
+    EXPECT_EQ(index.size(), 0);
+}
+
+TEST(ChainIndexTest, AppendMovesTipAndAssignsHeights)
+{
+    blockchain::ChainIndex index;
+    index.append(makeHeader("a", "0"));
+    index.append(makeHeader("b", "a"));
+    index.append(makeHeader("c", "b"));
+
+    blockchain::Block tip;
+    ASSERT_TRUE(index.findTip(tip));
+    EXPECT_EQ(tip.hash, id("c"));
+
+    int64_t height = -1;
+    ASSERT_TRUE(index.findTipHeight(height));
+    EXPECT_EQ(height, 2);
+
+    ASSERT_TRUE(index.findHeight(id("a"), height));
+    EXPECT_EQ(height, 0);
+    ASSERT_TRUE(index.findHeight(id("b"), height));
+    EXPECT_EQ(height, 1);
+    EXPECT_FALSE(index.findHeight(id("missing"), height));
+    EXPECT_EQ(index.size(), 3);
+}
+
+TEST(ChainIndexTest, LoadedIndexContinuesFromTip)
+{
+    blockchain::ChainIndex index;
+    index.add(id("a"), 0);
+    index.add(id("b"), 1);
+    index.setTip(makeHeader("c", "b"), 2);
+
+    index.append(makeHeader("d", "c"));
+
+    int64_t height = -1;
+    ASSERT_TRUE(index.findHeight(id("d"), height));
+    EXPECT_EQ(height, 3);
+
+    index.clear();
+    EXPECT_FALSE(index.contains(id("a")));
+    EXPECT_FALSE(index.findTipHeight(height));
+}
@@ -1,8 +1,24 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <thread>
+
 #include "OpenSSLCrypto.hpp"
 #include "XORCrypto.hpp"
 
+// fails on one marked message, the way a check may fail on an allocation
+class ThrowingVerifyCrypto : public crypto::OpenSSLCrypto
+{
+public:
+    bool verify(const crypto::Bytes& message,
+                const crypto::Bytes& signature,
+                const crypto::Bytes& publicKey) override
+    {
+        if (!message.empty() && message.back() == '!') throw std::runtime_error("verify failed");
+        return OpenSSLCrypto::verify(message, signature, publicKey);
+    }
+};
+
 class CryptoTest : public ::testing::Test
 {
 protected:
@@ -88,6 +104,48 @@ TEST_F(CryptoTest, DecryptWithWrongKeyFails)
     EXPECT_THROW({ crypto->decrypt(encrypted, key2); }, std::runtime_error);
 }
 
+TEST_F(CryptoTest, EncryptIntoReusesBufferAndRekeysPerMessage)
+{
+    auto key1 = crypto->generateSecret(32);
+    auto key2 = crypto->generateSecret(32);
+    crypto::Bytes message = crypto->generateSecret(200);
+
+    crypto::Bytes cipher;
+    crypto::Bytes plain;
+    cipher.reserve(512);
+    plain.reserve(512);
+    const uint8_t* cipherData = cipher.data();
+    const uint8_t* plainData = plain.data();
+
+    for (int i = 0; i < 4; ++i)
+    {
+        const crypto::Bytes& key = i % 2 ? key2 : key1;
+        crypto->encryptInto(message, key, cipher);
+        crypto->decryptInto(cipher, key, plain);
+        EXPECT_EQ(plain, message);
+
+        // a failed tag check must not break the next message on this thread
+        EXPECT_THROW(crypto->decryptInto(cipher, i % 2 ? key1 : key2, plain), std::runtime_error);
+        EXPECT_TRUE(plain.empty());
+    }
+
+    EXPECT_EQ(cipher.data(), cipherData);
+    EXPECT_EQ(plain.data(), plainData);
+}
+
+TEST_F(CryptoTest, CipherTextDecryptsOnAnotherThread)
+{
+    auto key = crypto->generateSecret(32);
+    crypto::Bytes message = crypto->generateSecret(64);
+    crypto::Bytes cipher = crypto->encrypt(message, key);
+
+    crypto::Bytes decrypted;
+    std::thread other([&]() { decrypted = crypto->decrypt(cipher, key); });
+    other.join();
+
+    EXPECT_EQ(decrypted, message);
+}
+
 TEST_F(CryptoTest, SignAndVerifyWorks)
 {
     auto keyPair = crypto->generateKeyPair();
@@ -152,4 +210,168 @@ TEST_F(CryptoTest, SessionKeyIsSymmetric)
     auto sessionKey_2_1 = crypto->createSessionKey(keyPair2.privateKey, keyPair1.publicKey);
 
     EXPECT_EQ(sessionKey_1_2, sessionKey_2_1);
-}
\ No newline at end of file
+}
+TEST(OpenSSLCryptoTest, ParsedKeysAreCachedAndBounded)
+{
+    crypto::OpenSSLCrypto crypto;
+    auto keyPair = crypto.generateKeyPair();
+
+    std::string data = "Data to be signed";
+    crypto::Bytes message(data.begin(), data.end());
+
+    for (int i = 0; i < 10; ++i)
+    {
+        auto signature = crypto.sign(message, keyPair.privateKey);
+        EXPECT_TRUE(crypto.verify(message, signature, keyPair.publicKey));
+    }
+    EXPECT_EQ(crypto.cachedKeysCount(), 2);
+
+    // invalid keys are rejected and never cached
+    crypto::Bytes garbage = { 'n', 'o', 't', ' ', 'a', ' ', 'k', 'e', 'y' };
+    EXPECT_FALSE(crypto.verify(message, garbage, garbage));
+    EXPECT_EQ(crypto.cachedKeysCount(), 2);
+
+    for (size_t i = 0; i < crypto::MAX_CACHED_KEYS; ++i)
+    {
+        auto other = crypto.generateKeyPair();
+        crypto.verify(message, garbage, other.publicKey);
+    }
+    EXPECT_EQ(crypto.cachedKeysCount(), crypto::MAX_CACHED_KEYS);
+
+    // evicted keys are parsed again
+    auto signature = crypto.sign(message, keyPair.privateKey);
+    EXPECT_TRUE(crypto.verify(message, signature, keyPair.publicKey));
+}
+
+TEST(OpenSSLCryptoTest, CachedKeysAreSharedBetweenThreads)
+{
+    crypto::OpenSSLCrypto crypto;
+    auto keyPair = crypto.generateKeyPair();
+    auto peerKeyPair = crypto.generateKeyPair();
+    auto sessionKey = crypto.createSessionKey(keyPair.privateKey, peerKeyPair.publicKey);
+
+    std::atomic<int> failures{ 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t)
+    {
+        threads.emplace_back(
+            [&, t]()
+            {
+                for (int i = 0; i < 50; ++i)
+                {
+                    std::string data = "message " + std::to_string(t) + " " + std::to_string(i);
+                    crypto::Bytes message(data.begin(), data.end());
+
+                    auto signature = crypto.sign(message, keyPair.privateKey);
+                    if (!crypto.verify(message, signature, keyPair.publicKey)) failures++;
+                    if (crypto.createSessionKey(keyPair.privateKey, peerKeyPair.publicKey) !=
+                        sessionKey)
+                        failures++;
+                }
+            });
+    }
+    for (auto& thread : threads) thread.join();
+
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(crypto.cachedKeysCount(), 3);
+}
+
+TEST(OpenSSLCryptoTest, SessionKeysAreCachedPerKeyPair)
+{
+    crypto::OpenSSLCrypto crypto;
+    auto keyPair = crypto.generateKeyPair();
+    auto peer1 = crypto.generateKeyPair();
+    auto peer2 = crypto.generateKeyPair();
+
+    auto sessionKey1 = crypto.createSessionKey(keyPair.privateKey, peer1.publicKey);
+    for (int i = 0; i < 10; ++i)
+        EXPECT_EQ(crypto.createSessionKey(keyPair.privateKey, peer1.publicKey), sessionKey1);
+    EXPECT_EQ(crypto.cachedSessionKeysCount(), 1);
+
+    auto sessionKey2 = crypto.createSessionKey(keyPair.privateKey, peer2.publicKey);
+    EXPECT_NE(sessionKey1, sessionKey2);
+    EXPECT_EQ(crypto.cachedSessionKeysCount(), 2);
+
+    crypto::Bytes garbage = { 'n', 'o', 't', ' ', 'a', ' ', 'k', 'e', 'y' };
+    EXPECT_THROW(crypto.createSessionKey(keyPair.privateKey, garbage), std::runtime_error);
+    EXPECT_EQ(crypto.cachedSessionKeysCount(), 2);
+}
+
+TEST(OpenSSLCryptoTest, ForgottenSessionKeysAreDerivedAgain)
+{
+    crypto::OpenSSLCrypto crypto;
+    auto keyPair = crypto.generateKeyPair();
+    auto peer1 = crypto.generateKeyPair();
+    auto peer2 = crypto.generateKeyPair();
+
+    auto sessionKey1 = crypto.createSessionKey(keyPair.privateKey, peer1.publicKey);
+    crypto.createSessionKey(keyPair.privateKey, peer2.publicKey);
+
+    crypto.forgetSessionKeys(peer1.publicKey);
+    EXPECT_EQ(crypto.cachedSessionKeysCount(), 1);
+    EXPECT_EQ(crypto.createSessionKey(keyPair.privateKey, peer1.publicKey), sessionKey1);
+
+    crypto.clearSessionKeys();
+    EXPECT_EQ(crypto.cachedSessionKeysCount(), 0);
+
+    for (size_t i = 0; i < crypto::MAX_CACHED_SESSION_KEYS + 10; ++i)
+        crypto.createSessionKey(keyPair.privateKey, crypto.generateKeyPair().publicKey);
+    EXPECT_EQ(crypto.cachedSessionKeysCount(), crypto::MAX_CACHED_SESSION_KEYS);
+}
+
+TEST_F(CryptoTest, VerifyBatchReportsEveryCheck)
+{
+    auto keyPair = crypto->generateKeyPair();
+    auto otherKeyPair = crypto->generateKeyPair();
+
+    // large enough to be split across the verification pool
+    std::vector<crypto::SignatureCheck> checks(crypto::VERIFY_BATCH_CHUNK * 3 + 5);
+    for (size_t i = 0; i < checks.size(); ++i)
+    {
+        std::string data = "message " + std::to_string(i);
+        checks[i].message.assign(data.begin(), data.end());
+        checks[i].signature = crypto->sign(checks[i].message, keyPair.privateKey);
+        checks[i].publicKey = i % 7 == 3 ? otherKeyPair.publicKey : keyPair.publicKey;
+    }
+    checks[0].message.push_back('!');
+
+    std::vector<bool> results;
+    crypto->verifyBatch(checks, results);
+
+    ASSERT_EQ(results.size(), checks.size());
+    EXPECT_FALSE(results[0]);
+    for (size_t i = 1; i < checks.size(); ++i) EXPECT_EQ(results[i], i % 7 != 3) << i;
+
+    crypto->verifyBatch({}, results);
+    EXPECT_TRUE(results.empty());
+}
+
+TEST_F(CryptoTest, VerifyBatchRethrowsOnlyAfterEveryChunkIsDone)
+{
+    ThrowingVerifyCrypto throwingCrypto;
+    auto keyPair = throwingCrypto.generateKeyPair();
+
+    std::vector<crypto::SignatureCheck> checks(crypto::VERIFY_BATCH_CHUNK * 4);
+    for (size_t i = 0; i < checks.size(); ++i)
+    {
+        std::string data = "message " + std::to_string(i);
+        checks[i].message.assign(data.begin(), data.end());
+        checks[i].signature = throwingCrypto.sign(checks[i].message, keyPair.privateKey);
+        checks[i].publicKey = keyPair.publicKey;
+    }
+
+    // a check on a pool chunk throws, then one on the chunk of the calling thread
+    checks[crypto::VERIFY_BATCH_CHUNK * 2 + 1].message.push_back('!');
+    std::vector<bool> results;
+    EXPECT_THROW(throwingCrypto.verifyBatch(checks, results), std::runtime_error);
+
+    checks[crypto::VERIFY_BATCH_CHUNK * 2 + 1].message.pop_back();
+    checks[1].message.push_back('!');
+    EXPECT_THROW(throwingCrypto.verifyBatch(checks, results), std::runtime_error);
+
+    // the pool is still usable afterwards
+    checks[1].message.pop_back();
+    throwingCrypto.verifyBatch(checks, results);
+    ASSERT_EQ(results.size(), checks.size());
+    for (size_t i = 0; i < checks.size(); ++i) EXPECT_TRUE(results[i]) << i;
+}
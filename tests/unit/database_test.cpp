@@ -169,6 +169,203 @@ TEST_F(DatabaseTest, WALModeIsEnabled)
     EXPECT_EQ(journalMode, "wal");
 }
 
+TEST_F(DatabaseTest, PreparedStatementsAreCachedAndReused)
+{
+    db->open();
+    db->exec("CREATE TABLE cache_test (id INTEGER PRIMARY KEY, value TEXT);");
+
+    const std::string insertSql = "INSERT INTO cache_test(id, value) VALUES (?,?);";
+    const std::string selectSql = "SELECT value FROM cache_test WHERE id=?;";
+
+    db->prepare(insertSql);
+    db->prepare(selectSql);
+    EXPECT_EQ(db->cachedStatementsCount(), 2);
+
+    for (int i = 0; i < 10; ++i)
+        EXPECT_TRUE(db->executePrepared(insertSql, { std::to_string(i), "v" + std::to_string(i) }));
+
+    for (int i = 0; i < 10; ++i)
+    {
+        std::vector<std::string> values;
+        db->selectPrepared(selectSql,
+                           { std::to_string(i) },
+                           [&values](const std::vector<std::string>& row)
+                           { values.push_back(row[0]); });
+
+        ASSERT_EQ(values.size(), 1);
+        EXPECT_EQ(values[0], "v" + std::to_string(i));
+    }
+
+    EXPECT_EQ(db->cachedStatementsCount(), 2);
+}
+
+TEST_F(DatabaseTest, CachedStatementIsResetAfterCallbackThrows)
+{
+    db->open();
+    db->exec("CREATE TABLE reset_test (id INTEGER PRIMARY KEY);");
+    db->exec("INSERT INTO reset_test(id) VALUES (1), (2), (3);");
+
+    const std::string sql = "SELECT id FROM reset_test ORDER BY id;";
+
+    EXPECT_THROW(db->select(sql,
+                            [](const std::vector<std::string>&)
+                            { throw std::runtime_error("stop"); }),
+                 std::runtime_error);
+
+    // a statement left mid-step would keep the read transaction and skip the first row
+    std::vector<std::string> ids;
+    db->select(sql, [&ids](const std::vector<std::string>& row) { ids.push_back(row[0]); });
+    EXPECT_EQ(ids, (std::vector<std::string>{ "1", "2", "3" }));
+
+    EXPECT_NO_THROW(db->exec("DROP TABLE reset_test;"));
+}
+
+TEST_F(DatabaseTest, PrepareInvalidStatementThrows)
+{
+    db->open();
+
+    EXPECT_THROW(db->prepare("SELECT * FROM missing_table;"), std::runtime_error);
+    EXPECT_EQ(db->cachedStatementsCount(), 0);
+}
+
+TEST_F(DatabaseTest, CloseFinalizesCachedStatements)
+{
+    db->open();
+    db->exec("CREATE TABLE close_test (id INTEGER PRIMARY KEY);");
+    db->prepare("SELECT id FROM close_test;");
+
+    db->close();
+    EXPECT_FALSE(db->isOpen());
+    EXPECT_EQ(db->cachedStatementsCount(), 0);
+
+    int count = -1;
+    db->select("SELECT COUNT(*) FROM close_test;",
+               [&count](const std::vector<std::string>& row) { count = std::stoi(row[0]); });
+    EXPECT_EQ(count, 0);
+}
+
+TEST_F(DatabaseTest, TransactionCommitStoresAllRows)
+{
+    db->open();
+    db->exec("CREATE TABLE batch_test (id INTEGER PRIMARY KEY);");
+
+    {
+        db::DBFile::Transaction transaction(*db);
+        for (int i = 0; i < 100; ++i)
+            EXPECT_TRUE(db->executePrepared("INSERT INTO batch_test(id) VALUES (?);",
+                                            { std::to_string(i) }));
+        transaction.commit();
+    }
+
+    EXPECT_EQ(countRows("batch_test"), 100);
+}
+
+TEST_F(DatabaseTest, TransactionWithoutCommitRollsBack)
+{
+    db->open();
+    db->exec("CREATE TABLE batch_test (id INTEGER PRIMARY KEY);");
+
+    {
+        db::DBFile::Transaction transaction(*db);
+        db->executePrepared("INSERT INTO batch_test(id) VALUES (?);", { "1" });
+    }
+
+    EXPECT_EQ(countRows("batch_test"), 0);
+}
+
+TEST_F(DatabaseTest, NestedTransactionRollsBackOnlyItsOwnRows)
+{
+    db->open();
+    db->exec("CREATE TABLE batch_test (id INTEGER PRIMARY KEY);");
+
+    {
+        db::DBFile::Transaction outer(*db);
+        db->executePrepared("INSERT INTO batch_test(id) VALUES (?);", { "1" });
+
+        {
+            db::DBFile::Transaction inner(*db);
+            db->executePrepared("INSERT INTO batch_test(id) VALUES (?);", { "2" });
+            inner.rollback();
+        }
+
+        outer.commit();
+    }
+
+    EXPECT_EQ(countRows("batch_test"), 1);
+}
+
+TEST_F(DatabaseTest, FailedCommitIsRolledBack)
+{
+    db->open();
+    db->exec("PRAGMA foreign_keys = ON;");
+    db->exec("CREATE TABLE parent (id INTEGER PRIMARY KEY);");
+    db->exec("CREATE TABLE child (id INTEGER PRIMARY KEY, parent_id INTEGER "
+             "REFERENCES parent(id) DEFERRABLE INITIALLY DEFERRED);");
+
+    {
+        // the deferred foreign key is only checked by COMMIT, which then fails
+        db::DBFile::Transaction transaction(*db);
+        db->executePrepared("INSERT INTO child(id, parent_id) VALUES (?, ?);", { "1", "42" });
+        EXPECT_THROW(transaction.commit(), std::runtime_error);
+    }
+
+    EXPECT_EQ(countRows("child"), 0);
+
+    // the connection is out of the failed transaction and can start a new one
+    {
+        db::DBFile::Transaction transaction(*db);
+        db->executePrepared("INSERT INTO parent(id) VALUES (?);", { "42" });
+        transaction.commit();
+    }
+
+    EXPECT_EQ(countRows("parent"), 1);
+}
+
+TEST_F(DatabaseTest, SelectRowsReadsTypedColumns)
+{
+    db->open();
+    db->exec("CREATE TABLE typed_test (id INTEGER PRIMARY KEY, name TEXT, data BLOB, note TEXT);");
+    db->exec("INSERT INTO typed_test VALUES (9007199254740993, 'alice', x'00ff10', NULL);");
+
+    int rows = 0;
+    db->selectRows("SELECT id, name, data, note FROM typed_test;",
+                   {},
+                   [&rows](const db::Row& row)
+                   {
+                       ++rows;
+                       EXPECT_EQ(row.columnCount(), 4);
+                       EXPECT_EQ(row.getInt64(0), 9007199254740993LL);
+                       EXPECT_EQ(row.getText(1), "alice");
+
+                       size_t size = 0;
+                       const uint8_t* data = row.getBlob(2, size);
+                       ASSERT_EQ(size, 3);
+                       EXPECT_EQ(data[0], 0x00);
+                       EXPECT_EQ(data[1], 0xff);
+                       EXPECT_EQ(data[2], 0x10);
+
+                       EXPECT_TRUE(row.isNull(3));
+                       EXPECT_TRUE(row.getText(3).empty());
+                   });
+
+    EXPECT_EQ(rows, 1);
+}
+
+TEST_F(DatabaseTest, SelectRowsBindsParams)
+{
+    db->open();
+    db->exec("CREATE TABLE typed_test (id INTEGER PRIMARY KEY, name TEXT);");
+    db->executePrepared("INSERT INTO typed_test(id, name) VALUES (?,?);", { "1", "it's" });
+    db->executePrepared("INSERT INTO typed_test(id, name) VALUES (?,?);", { "2", "bob" });
+
+    std::vector<std::string> names;
+    db->selectRows("SELECT name FROM typed_test WHERE id >= ? ORDER BY id;",
+                   { "1" },
+                   [&names](const db::Row& row) { names.push_back(row.getString(0)); });
+
+    EXPECT_EQ(names, (std::vector<std::string>{ "it's", "bob" }));
+}
+
 class SQLInjectionTest : public DatabaseTest
 {
 protected:
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include "MessageFrame.hpp"
+
+TEST(MessageFrameTest, EncodeFramePrefixesPayloadLength)
+{
+    std::string frame = network::encodeFrame("hello");
+
+    ASSERT_EQ(frame.size(), network::FRAME_HEADER_SIZE + 5);
+    EXPECT_EQ(frame[0], '\0');
+    EXPECT_EQ(frame[1], '\0');
+    EXPECT_EQ(frame[2], '\0');
+    EXPECT_EQ(frame[3], '\5');
+    EXPECT_EQ(frame.substr(network::FRAME_HEADER_SIZE), "hello");
+}
+
+TEST(MessageFrameTest, FrameBufferReassemblesPartialChunks)
+{
+    std::string frame = network::encodeFrame(R"({"type":"CONNECT"})");
+    network::FrameBuffer buffer;
+    std::string message;
+
+    // feed one byte at a time, as a slow connection would
+    for (size_t i = 0; i + 1 < frame.size(); ++i)
+    {
+        buffer.append(frame.data() + i, 1);
+        EXPECT_FALSE(buffer.nextFrame(message));
+    }
+
+    buffer.append(frame.data() + frame.size() - 1, 1);
+    ASSERT_TRUE(buffer.nextFrame(message));
+    EXPECT_EQ(message, R"({"type":"CONNECT"})");
+    EXPECT_TRUE(buffer.empty());
+}
+
+TEST(MessageFrameTest, FrameBufferSplitsSeveralFramesFromOneChunk)
+{
+    std::string chunk =
+        network::encodeFrame("first") + network::encodeFrame("") + network::encodeFrame("third");
+    network::FrameBuffer buffer;
+    buffer.append(chunk.data(), chunk.size());
+
+    std::string message;
+    ASSERT_TRUE(buffer.nextFrame(message));
+    EXPECT_EQ(message, "first");
+    ASSERT_TRUE(buffer.nextFrame(message));
+    EXPECT_EQ(message, "");
+    ASSERT_TRUE(buffer.nextFrame(message));
+    EXPECT_EQ(message, "third");
+    EXPECT_FALSE(buffer.nextFrame(message));
+}
+
+TEST(MessageFrameTest, FrameBufferRejectsOversizedFrame)
+{
+    const char header[] = { '\x7F', '\xFF', '\xFF', '\xFF' };
+    network::FrameBuffer buffer;
+    buffer.append(header, sizeof(header));
+
+    std::string message;
+    EXPECT_THROW(buffer.nextFrame(message), std::runtime_error);
+}
@@ -1,8 +1,14 @@
 #include <gtest/gtest.h>
 
+#include "BlockRangeMessage.hpp"
+#include "BlockchainErrorMessage.hpp"
 #include "ConnectionMessage.hpp"
+#include "DisconnectionMessage.hpp"
+#include "ErrorMessage.hpp"
 #include "OpenSSLCrypto.hpp"
 #include "PeerListMessage.hpp"
+#include "binary.hpp"
+#include "sha256.hpp"
 #include "timestamp.hpp"
 #include "uuid.hpp"
 
@@ -31,7 +37,7 @@ TEST_F(MessageTest, ConnectionMessageSerializationWorks)
     uint64_t timestamp = utils::getTimestamp();
     std::string lastHash = "lasthash123";
 
-    message::ConnectionMessage original(id, from, to, timestamp, lastHash);
+    message::ConnectionMessage original(id, from, to, timestamp, lastHash, message::WIRE_VERSION);
 
     nlohmann::json jData;
     original.serialize(jData);
@@ -44,6 +50,19 @@ TEST_F(MessageTest, ConnectionMessageSerializationWorks)
     EXPECT_EQ(recovered.getTo().host, original.getTo().host);
     EXPECT_EQ(recovered.getTo().port, original.getTo().port);
     EXPECT_EQ(recovered.getPayload().lastBlockHash, original.getPayload().lastBlockHash);
+    EXPECT_EQ(recovered.getPayload().wireVersion, message::WIRE_VERSION);
+}
+
+TEST_F(MessageTest, ConnectionMessageFromOldPeerOffersJsonOnly)
+{
+    message::ConnectionMessage original = message::ConnectionMessage::create(from, to, "0");
+
+    nlohmann::json jData;
+    original.serialize(jData);
+    jData["payload"].erase("wireVersion");
+
+    message::ConnectionMessage recovered(jData);
+    EXPECT_EQ(recovered.getPayload().wireVersion, 0);
 }
 
 TEST_F(MessageTest, PeerListMessageSerializationWorks)
@@ -75,8 +94,239 @@ TEST_F(MessageTest, MessageTypeConversionWorks)
               message::MessageType::TEXT_MESSAGE);
 }
 
+TEST_F(MessageTest, EveryMessageTypeNameRoundTrips)
+{
+    for (size_t i = 0; i < message::MESSAGE_TYPE_COUNT; ++i)
+    {
+        auto type = static_cast<message::MessageType>(i);
+        std::string name = message::Message::fromMessageTypeToString(type);
+
+        message::MessageType found = message::MessageType::NONE;
+        ASSERT_TRUE(message::Message::findMessageType(name, found)) << name;
+        EXPECT_EQ(found, type);
+    }
+
+    message::MessageType found = message::MessageType::CONNECT;
+    EXPECT_FALSE(message::Message::findMessageType("connect", found));
+    EXPECT_FALSE(message::Message::findMessageType("", found));
+    EXPECT_EQ(found, message::MessageType::CONNECT);
+}
+
 TEST_F(MessageTest, InvalidMessageTypeThrows)
 {
     EXPECT_THROW(
         { message::Message::fromStringToMessageType("INVALID_TYPE"); }, std::runtime_error);
-}
\ No newline at end of file
+}
+
+TEST_F(MessageTest, ConnectionMessagesSurviveBinaryRoundTrip)
+{
+    std::string lastHash = utils::sha256("tip");
+    message::ConnectionMessage request = message::ConnectionMessage::create(from, to, lastHash);
+
+    std::string frame;
+    request.encode(frame);
+    ASSERT_TRUE(message::Message::isBinaryFrame(frame));
+    EXPECT_EQ(message::Message::peekBinaryType(frame), message::MessageType::CONNECT);
+    EXPECT_EQ(message::Message::peekBinarySender(frame), from);
+
+    utils::BinaryReader reader(frame);
+    message::ConnectionMessage recovered(reader);
+    EXPECT_TRUE(reader.atEnd());
+    EXPECT_EQ(recovered.getWireFormat(), message::WireFormat::BINARY);
+    EXPECT_EQ(recovered.getId(), request.getId());
+    EXPECT_EQ(recovered.getTimestamp(), request.getTimestamp());
+    EXPECT_EQ(recovered.getFrom(), from);
+    EXPECT_EQ(recovered.getTo(), to);
+    EXPECT_EQ(recovered.getPayload().lastBlockHash, lastHash);
+    EXPECT_EQ(recovered.getPayload().wireVersion, message::WIRE_VERSION);
+
+    message::ConnectionMessageResponse response =
+        message::ConnectionMessageResponse::create(to, from, 7, 300, message::WIRE_VERSION);
+    std::string responseFrame = response.toWire(message::WireFormat::BINARY);
+
+    utils::BinaryReader responseReader(responseFrame);
+    message::ConnectionMessageResponse recoveredResponse(responseReader);
+    EXPECT_EQ(recoveredResponse.getPayload().peersToReceive, 7u);
+    EXPECT_EQ(recoveredResponse.getPayload().missingBlocksCount, 300u);
+    EXPECT_EQ(recoveredResponse.getPayload().wireVersion, message::WIRE_VERSION);
+}
+
+TEST_F(MessageTest, NonHexAndNonBase64TextSurvivesBinaryRoundTrip)
+{
+    // the zero hash and keys that are not valid base64 go out as text
+    peer::UserPeer oddPeer("localhost", 9000, "test_public_key");
+    message::BlockRangeMessage request =
+        message::BlockRangeMessage::create(oddPeer, to, 5, 20, "0");
+
+    std::string frame = request.toWire(message::WireFormat::BINARY);
+    utils::BinaryReader reader(frame);
+    message::BlockRangeMessage recovered(reader);
+
+    EXPECT_EQ(recovered.getFrom(), oddPeer);
+    EXPECT_EQ(recovered.getPayload().start, 5u);
+    EXPECT_EQ(recovered.getPayload().count, 20u);
+    EXPECT_EQ(recovered.getPayload().lastHash, "0");
+}
+
+TEST_F(MessageTest, PeerListAndErrorResponsesSurviveBinaryRoundTrip)
+{
+    std::vector<peer::UserPeer> peers = { from, to, peer::UserPeer("10.0.0.1", 65535, "") };
+    message::PeerListMessageResponse peerList =
+        message::PeerListMessageResponse::create(from, to, peers);
+
+    std::string frame = peerList.toWire(message::WireFormat::BINARY);
+    utils::BinaryReader reader(frame);
+    message::PeerListMessageResponse recoveredList(reader);
+    EXPECT_EQ(recoveredList.getPayload().peers, peers);
+
+    message::ErrorMessageResponse error =
+        message::ErrorMessageResponse::create(from, to, "Invalid request");
+    frame = error.toWire(message::WireFormat::BINARY);
+    utils::BinaryReader errorReader(frame);
+    EXPECT_EQ(message::ErrorMessageResponse(errorReader).getPayload().error, "Invalid request");
+
+    message::BlockchainErrorMessageResponse blockchainError =
+        message::BlockchainErrorMessageResponse::create(
+            from, "Block was not stored", utils::sha256("block"), "message-1");
+    frame = blockchainError.toWire(message::WireFormat::BINARY);
+    utils::BinaryReader blockchainErrorReader(frame);
+    message::BlockchainErrorMessageResponse recoveredError(blockchainErrorReader);
+    EXPECT_EQ(recoveredError.getPayload().error, "Block was not stored");
+    EXPECT_EQ(recoveredError.getPayload().blockHash, utils::sha256("block"));
+    EXPECT_EQ(recoveredError.getPayload().messageId, "message-1");
+}
+
+TEST_F(MessageTest, BinaryBlockRangeResponseIsFarSmallerThanJson)
+{
+    auto keyPair = crypto->generateKeyPair();
+
+    std::vector<blockchain::Block> blocks;
+    blockchain::Hash previousHash{};
+    for (int i = 0; i < 50; ++i)
+    {
+        blockchain::Block block;
+        block.previousHash = previousHash;
+        block.payloadHash = utils::sha256Digest("payload " + std::to_string(i));
+        block.authorPublicKey = keyPair.publicKey;
+        block.timestamp = utils::getTimestamp();
+        std::string canonical = block.toStringForHash();
+        block.signature =
+            crypto->sign(crypto::Bytes(canonical.begin(), canonical.end()), keyPair.privateKey);
+        block.computeHash();
+
+        previousHash = block.hash;
+        blocks.push_back(block);
+    }
+
+    message::BlockRangeMessageResponse response =
+        message::BlockRangeMessageResponse::create(from, to, blocks);
+
+    std::string jsonText = response.toWire(message::WireFormat::JSON);
+    std::string frame = response.toWire(message::WireFormat::BINARY);
+    // the PEM author key is most of a block, raw bytes still save over 40%
+    EXPECT_LT(frame.size() * 5, jsonText.size() * 3);
+
+    utils::BinaryReader reader(frame);
+    message::BlockRangeMessageResponse recovered(reader);
+    const std::vector<blockchain::Block>& recoveredBlocks = recovered.getPayload().blocks;
+    ASSERT_EQ(recoveredBlocks.size(), blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        EXPECT_EQ(recoveredBlocks[i].toJson(), blocks[i].toJson());
+        EXPECT_EQ(recoveredBlocks[i].calculateHash(), blocks[i].hash);
+    }
+}
+
+TEST_F(MessageTest, BlockRangeResponseStreamsBlocksToSink)
+{
+    std::vector<blockchain::Block> blocks;
+    blockchain::Hash previousHash{};
+    for (int i = 0; i < 5; ++i)
+    {
+        blockchain::Block block;
+        block.previousHash = previousHash;
+        block.payloadHash = utils::sha256Digest("payload " + std::to_string(i));
+        block.authorPublicKey = { 'k', 'e', 'y' };
+        block.signature = { 0x30, 0x01, static_cast<uint8_t>(i) };
+        block.timestamp = utils::getTimestamp();
+        block.computeHash();
+
+        previousHash = block.hash;
+        blocks.push_back(block);
+    }
+
+    message::BlockRangeMessageResponse response =
+        message::BlockRangeMessageResponse::create(from, to, blocks);
+
+    for (message::WireFormat format : { message::WireFormat::JSON, message::WireFormat::BINARY })
+    {
+        std::string frame = response.toWire(format);
+
+        std::vector<blockchain::Block> received;
+        message::MessageType type = message::MessageType::NONE;
+        auto takeAll = [&received](blockchain::Block&& block)
+        {
+            received.push_back(std::move(block));
+            return true;
+        };
+        EXPECT_TRUE(message::BlockRangeMessageResponse::decodeBlocks(frame, takeAll, type));
+        EXPECT_EQ(type, message::MessageType::BLOCK_RANGE_RESPONSE);
+        ASSERT_EQ(received.size(), blocks.size());
+        for (size_t i = 0; i < blocks.size(); ++i)
+            EXPECT_EQ(received[i].toJson(), blocks[i].toJson());
+
+        // the sink stops after two blocks, the type is still reported
+        received.clear();
+        type = message::MessageType::NONE;
+        auto takeTwo = [&received](blockchain::Block&& block)
+        {
+            if (received.size() == 2) return false;
+            received.push_back(std::move(block));
+            return true;
+        };
+        EXPECT_FALSE(message::BlockRangeMessageResponse::decodeBlocks(frame, takeTwo, type));
+        EXPECT_EQ(type, message::MessageType::BLOCK_RANGE_RESPONSE);
+        EXPECT_EQ(received.size(), 2u);
+
+        // other responses give no blocks and their own type
+        received.clear();
+        std::string error =
+            message::ErrorMessageResponse::create(from, to, "Invalid request").toWire(format);
+        EXPECT_FALSE(message::BlockRangeMessageResponse::decodeBlocks(error, takeAll, type));
+        EXPECT_EQ(type, message::MessageType::ERROR_RESPONSE);
+        EXPECT_TRUE(received.empty());
+    }
+
+    std::string jsonText = response.toWire(message::WireFormat::JSON);
+    message::MessageType type = message::MessageType::NONE;
+    auto takeAll = [](blockchain::Block&&) { return true; };
+    EXPECT_THROW(message::BlockRangeMessageResponse::decodeBlocks(
+                     jsonText.substr(0, jsonText.size() / 2), takeAll, type),
+                 std::runtime_error);
+}
+
+TEST_F(MessageTest, MalformedBinaryFramesAreRejected)
+{
+    message::BlockRangeMessage request =
+        message::BlockRangeMessage::create(from, to, 0, 10, utils::sha256("tip"));
+    std::string frame = request.toWire(message::WireFormat::BINARY);
+
+    // every cut must fail cleanly instead of reading past the end
+    for (size_t size = 0; size < frame.size(); ++size)
+    {
+        utils::BinaryReader reader(std::string_view(frame).substr(0, size));
+        EXPECT_THROW(message::BlockRangeMessage recovered(reader), utils::BinaryFormatError);
+    }
+
+    std::string newerVersion = frame;
+    newerVersion[1] = static_cast<char>(message::WIRE_VERSION + 1);
+    EXPECT_THROW(message::Message::peekBinaryType(newerVersion), utils::BinaryFormatError);
+
+    // a frame of another type is not silently read as a block range request
+    std::string disconnect = message::DisconnectionMessage::create(from, to).toWire(
+        message::WireFormat::BINARY);
+    utils::BinaryReader reader(disconnect);
+    EXPECT_THROW(message::BlockRangeMessage recovered(reader), std::runtime_error);
+
+    EXPECT_FALSE(message::Message::isBinaryFrame(request.toWire(message::WireFormat::JSON)));
+}
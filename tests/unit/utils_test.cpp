@@ -1,9 +1,16 @@
 #include <gtest/gtest.h>
+#include <openssl/buffer.h>
+#include <openssl/evp.h>
 
 #include <chrono>
+#include <iomanip>
+#include <iostream>
 #include <set>
+#include <sstream>
 #include <thread>
 
+#include "base64.hpp"
+#include "binary.hpp"
 #include "hex.hpp"
 #include "sha256.hpp"
 #include "timestamp.hpp"
@@ -81,6 +88,32 @@ TEST(UtilsTest, SHA256EmptyStringWorks)
     EXPECT_FALSE(hash.empty());
 }
 
+TEST(UtilsTest, Sha256HasherMatchesOneShotDigest)
+{
+    std::string data = "The quick brown fox jumps over the lazy dog";
+
+    utils::Sha256Hasher hasher;
+    for (size_t i = 0; i < data.size(); i += 5) hasher.update(data.substr(i, 5));
+    utils::Digest digest = hasher.finish();
+
+    EXPECT_EQ(digest, utils::sha256Digest(data));
+    EXPECT_EQ(utils::sha256(data),
+              "d7a8fbb307d7809469ca9abcb0082e4f8d5651e46d3cdb762d02d0bf37c9e592");
+}
+
+TEST(UtilsTest, NestedSha256HashersDoNotShareState)
+{
+    utils::Sha256Hasher outer;
+    outer.update("The quick brown fox ");
+
+    // a digest taken while another hasher is running on the same thread
+    EXPECT_EQ(utils::sha256(""),
+              "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+
+    outer.update("jumps over the lazy dog");
+    EXPECT_EQ(outer.finish(), utils::sha256Digest("The quick brown fox jumps over the lazy dog"));
+}
+
 TEST(UtilsTest, HexConversionRoundTrip)
 {
     std::vector<uint8_t> original = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF };
@@ -114,6 +147,223 @@ TEST(UtilsTest, HexConversionUpperAndLowerCase)
     EXPECT_EQ(recovered2, data);
 }
 
+TEST(UtilsTest, Base64ConversionRoundTrip)
+{
+    std::vector<uint8_t> data = { 'f', 'o', 'o', 'b', 'a', 'r' };
+
+    for (size_t size = 0; size <= data.size(); ++size)
+    {
+        std::vector<uint8_t> original(data.begin(), data.begin() + size);
+        std::vector<uint8_t> recovered;
+        ASSERT_TRUE(utils::fromBase64(utils::toBase64(original), recovered));
+        EXPECT_EQ(recovered, original);
+    }
+
+    EXPECT_EQ(utils::toBase64({ 'f' }), "Zg==");
+    EXPECT_EQ(utils::toBase64({ 'f', 'o' }), "Zm8=");
+    EXPECT_EQ(utils::toBase64(data), "Zm9vYmFy");
+}
+
+TEST(UtilsTest, Base64RejectsMalformedInput)
+{
+    std::vector<uint8_t> out;
+    EXPECT_FALSE(utils::fromBase64("Zm9", out));
+    EXPECT_FALSE(utils::fromBase64("Zm9*", out));
+    EXPECT_FALSE(utils::fromBase64("Z===", out));
+}
+
+TEST(UtilsTest, HexDecodeIntoBufferRejectsMalformedInput)
+{
+    uint8_t out[2] = {};
+    EXPECT_TRUE(utils::fromHex("aB0f", out));
+    EXPECT_EQ(out[0], 0xab);
+    EXPECT_EQ(out[1], 0x0f);
+
+    EXPECT_FALSE(utils::fromHex("abc", out));
+    EXPECT_FALSE(utils::fromHex("zz", out));
+    EXPECT_THROW(utils::fromHex(std::string("0g")), std::invalid_argument);
+}
+
+TEST(UtilsTest, Base64DecodeIntoBufferReportsSize)
+{
+    uint8_t out[6] = {};
+    size_t size = 0;
+    ASSERT_TRUE(utils::fromBase64("Zm9vYg==", out, size));
+    EXPECT_EQ(size, 4);
+    EXPECT_EQ(std::string(reinterpret_cast<char*>(out), size), "foob");
+}
+
+namespace
+{
+// the codecs the table-driven ones replaced, kept here to compare against
+std::string streamHex(const std::vector<uint8_t>& data)
+{
+    std::ostringstream oss;
+    oss << std::hex << std::setfill('0');
+    for (auto b : data) oss << std::setw(2) << static_cast<int>(b);
+    return oss.str();
+}
+
+std::vector<uint8_t> stoiHex(const std::string& hex)
+{
+    std::vector<uint8_t> out;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2)
+        out.push_back(static_cast<uint8_t>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+    return out;
+}
+
+std::string bioBase64(const std::vector<uint8_t>& data)
+{
+    BIO* bio = BIO_push(BIO_new(BIO_f_base64()), BIO_new(BIO_s_mem()));
+    BIO_set_flags(bio, BIO_FLAGS_BASE64_NO_NL);
+    BIO_write(bio, data.data(), static_cast<int>(data.size()));
+    BIO_flush(bio);
+
+    BUF_MEM* buffer;
+    BIO_get_mem_ptr(bio, &buffer);
+    std::string encoded(buffer->data, buffer->length);
+    BIO_free_all(bio);
+    return encoded;
+}
+
+std::vector<uint8_t> bioFromBase64(const std::string& text)
+{
+    BIO* bio = BIO_push(BIO_new(BIO_f_base64()),
+                        BIO_new_mem_buf(text.data(), static_cast<int>(text.size())));
+    BIO_set_flags(bio, BIO_FLAGS_BASE64_NO_NL);
+
+    std::vector<uint8_t> decoded(text.size());
+    int len = BIO_read(bio, decoded.data(), static_cast<int>(decoded.size()));
+    BIO_free_all(bio);
+
+    decoded.resize(len < 0 ? 0 : len);
+    return decoded;
+}
+
+template <typename F>
+double microsecondsPerCall(int calls, F&& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; ++i) f();
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / calls;
+}
+}  // namespace
+
+TEST(UtilsTest, CodecsMatchPreviousImplementations)
+{
+    for (size_t size : { 0, 1, 2, 3, 32, 71, 91, 178 })
+    {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; ++i) data[i] = static_cast<uint8_t>(i * 37 + 11);
+
+        std::string hex = utils::toHex(data);
+        EXPECT_EQ(hex, streamHex(data));
+        EXPECT_EQ(utils::fromHex(hex), stoiHex(hex));
+
+        std::string base64 = utils::toBase64(data);
+        std::vector<uint8_t> decoded;
+        EXPECT_EQ(base64, bioBase64(data));
+        ASSERT_TRUE(utils::fromBase64(base64, decoded));
+        EXPECT_EQ(decoded, bioFromBase64(base64));
+    }
+}
+
+// micro-benchmark, run with --gtest_also_run_disabled_tests
+TEST(UtilsTest, DISABLED_CodecBenchmark)
+{
+    std::vector<uint8_t> key(178);  // size of a PEM-encoded P-256 public key
+    for (size_t i = 0; i < key.size(); ++i) key[i] = static_cast<uint8_t>(i * 37 + 11);
+    std::string hex = utils::toHex(key);
+    std::string base64 = utils::toBase64(key);
+    const int calls = 200000;
+
+    auto report = [](const char* name, double before, double after)
+    {
+        std::cout << std::fixed << std::setprecision(3) << name << ": " << before << " us -> "
+                  << after << " us (x" << std::setprecision(1) << before / after << ")\n";
+    };
+
+    report("hex encode",
+           microsecondsPerCall(calls, [&]() { return streamHex(key); }),
+           microsecondsPerCall(calls, [&]() { return utils::toHex(key); }));
+    report("hex decode",
+           microsecondsPerCall(calls, [&]() { return stoiHex(hex); }),
+           microsecondsPerCall(calls, [&]() { return utils::fromHex(hex); }));
+    report("base64 encode",
+           microsecondsPerCall(calls, [&]() { return bioBase64(key); }),
+           microsecondsPerCall(calls, [&]() { return utils::toBase64(key); }));
+
+    std::vector<uint8_t> decoded;
+    report("base64 decode",
+           microsecondsPerCall(calls, [&]() { return bioFromBase64(base64); }),
+           microsecondsPerCall(calls, [&]() { return utils::fromBase64(base64, decoded); }));
+}
+
+TEST(UtilsTest, BinaryWriterAndReaderRoundTrip)
+{
+    std::string data;
+    utils::BinaryWriter writer(data);
+    writer.writeByte(0xAB);
+    writer.writeUint16(8080);
+    writer.writeVarint(0);
+    writer.writeVarint(300);
+    writer.writeVarint(UINT64_MAX);
+    writer.writeString("hello");
+    writer.writeBytes({ 0, 1, 2 });
+
+    // 0xAB, 2 bytes port, varints of 1 + 2 + 10 bytes, 1 + 5 for the string, 1 + 3 for the bytes
+    EXPECT_EQ(data.size(), 1u + 2 + 1 + 2 + 10 + 6 + 4);
+
+    utils::BinaryReader reader(data);
+    EXPECT_EQ(reader.readByte(), 0xAB);
+    EXPECT_EQ(reader.readUint16(), 8080);
+    EXPECT_EQ(reader.readVarint(), 0u);
+    EXPECT_EQ(reader.readVarint(), 300u);
+    EXPECT_EQ(reader.readVarint(), UINT64_MAX);
+    EXPECT_EQ(reader.readString(), "hello");
+    EXPECT_EQ(reader.readBytes(), std::vector<uint8_t>({ 0, 1, 2 }));
+    EXPECT_TRUE(reader.atEnd());
+    EXPECT_THROW(reader.readByte(), utils::BinaryFormatError);
+}
+
+TEST(UtilsTest, BinaryTextKeepsExactTextWhenItIsNotCanonical)
+{
+    std::string hash = utils::sha256("data");
+    std::vector<std::string> hexTexts = { hash, "0", "", "ABCD", "abc" };
+    std::vector<std::string> base64Texts = { "aGVsbG8=", "aGVsbG9=", "test_public_key", "" };
+
+    std::string data;
+    utils::BinaryWriter writer(data);
+    for (const auto& text : hexTexts) writer.writeHexString(text);
+    for (const auto& text : base64Texts) writer.writeBase64String(text);
+
+    utils::BinaryReader reader(data);
+    for (const auto& text : hexTexts) EXPECT_EQ(reader.readHexString(), text);
+    for (const auto& text : base64Texts) EXPECT_EQ(reader.readBase64String(), text);
+    EXPECT_TRUE(reader.atEnd());
+
+    // a 64 digit hash takes a tag, a length and 32 bytes
+    std::string hashOnly;
+    utils::BinaryWriter(hashOnly).writeHexString(hash);
+    EXPECT_EQ(hashOnly.size(), 34u);
+}
+
+TEST(UtilsTest, BinaryReaderRejectsLengthsPastTheEnd)
+{
+    std::string data;
+    utils::BinaryWriter writer(data);
+    writer.writeVarint(1000);
+    data += "short";
+
+    utils::BinaryReader reader(data);
+    EXPECT_THROW(reader.readString(), utils::BinaryFormatError);
+
+    std::string endlessVarint(11, '\xFF');
+    utils::BinaryReader varintReader(endlessVarint);
+    EXPECT_THROW(varintReader.readVarint(), utils::BinaryFormatError);
+}
+
 TEST(UtilsTest, TimestampToString)
 {
     uint64_t timestamp = 1577836800000;  // 3 hours after Jan 1, 2020 in ms GMT+3
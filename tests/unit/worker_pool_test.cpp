@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "WorkerPool.hpp"
+
+TEST(WorkerPoolTest, RunsAllSubmittedTasks)
+{
+    std::atomic<int> counter(0);
+    {
+        concurrency::WorkerPool pool(4, 16);
+        for (int i = 0; i < 100; ++i)
+        {
+            EXPECT_TRUE(pool.submit([&counter]() { counter.fetch_add(1); }));
+        }
+        pool.shutdown();
+    }
+
+    EXPECT_EQ(counter.load(), 100);
+}
+
+TEST(WorkerPoolTest, KeyedTasksKeepSubmissionOrder)
+{
+    std::mutex mutex;
+    std::vector<int> firstKeyOrder;
+    std::vector<int> secondKeyOrder;
+
+    concurrency::WorkerPool pool(4, 64);
+    for (int i = 0; i < 50; ++i)
+    {
+        pool.submit(1,
+                    [&, i]()
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        firstKeyOrder.push_back(i);
+                    });
+        pool.submit(2,
+                    [&, i]()
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        secondKeyOrder.push_back(i);
+                    });
+    }
+    pool.shutdown();
+
+    ASSERT_EQ(firstKeyOrder.size(), 50u);
+    ASSERT_EQ(secondKeyOrder.size(), 50u);
+    for (int i = 0; i < 50; ++i)
+    {
+        EXPECT_EQ(firstKeyOrder[i], i);
+        EXPECT_EQ(secondKeyOrder[i], i);
+    }
+}
+
+TEST(WorkerPoolTest, DifferentKeysRunInParallel)
+{
+    concurrency::WorkerPool pool(2, 16);
+    std::atomic<int> running(0);
+    std::atomic<int> maxRunning(0);
+
+    auto task = [&running, &maxRunning]()
+    {
+        int now = running.fetch_add(1) + 1;
+        int expected = maxRunning.load();
+        while (now > expected && !maxRunning.compare_exchange_weak(expected, now))
+        {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        running.fetch_sub(1);
+    };
+
+    pool.submit(1, task);
+    pool.submit(2, task);
+    pool.shutdown();
+
+    EXPECT_EQ(maxRunning.load(), 2);
+}
+
+TEST(WorkerPoolTest, FailingTaskDoesNotStopWorkers)
+{
+    std::atomic<int> counter(0);
+    concurrency::WorkerPool pool(1, 4);
+
+    pool.submit([]() { throw std::runtime_error("task failed"); });
+    pool.submit([&counter]() { counter.fetch_add(1); });
+    pool.shutdown();
+
+    EXPECT_EQ(counter.load(), 1);
+    EXPECT_FALSE(pool.submit([]() {}));
+}
+
+TEST(WorkerPoolTest, TrySubmitDoesNotWaitForFullQueue)
+{
+    std::atomic<bool> release(false);
+    concurrency::WorkerPool pool(1, 2);
+
+    auto blocked = [&release]()
+    {
+        while (!release.load()) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    };
+    EXPECT_TRUE(pool.trySubmit(blocked));
+    EXPECT_TRUE(pool.trySubmit(blocked));
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(pool.trySubmit([]() {}));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(100));
+
+    release.store(true);
+    pool.shutdown();
+    EXPECT_FALSE(pool.trySubmit([]() {}));
+}